@@ -174,6 +174,7 @@ ssize_t BufferSendMsg::send_l(int fd, int flags) {
         msg.msg_controllen = 0;
         msg.msg_flags = flags;
         n = sendmsg(fd, &msg, flags);
+        onSyscall();
     } while (-1 == n && UV_EINTR == get_uv_error(true));
 #else
     do {
@@ -321,6 +322,7 @@ ssize_t BufferSendTo::send(int fd, int flags) {
         } else {
             n = ::send(fd, buffer->data() + _offset, buffer->size() - _offset, flags);
         }
+        onSyscall();
 
         if (n >= 0) {
             assert(n);
@@ -382,6 +384,7 @@ ssize_t BufferSendMMsg::send_l(int fd, int flags) {
     ssize_t n;
     do {
         n = sendmmsg(fd, &_hdrvec[0], _hdrvec.size(), flags);
+        onSyscall();
     } while (-1 == n && UV_EINTR == get_uv_error(true));
 
     if (n > 0) {
@@ -460,6 +463,16 @@ BufferSendMMsg::BufferSendMMsg(List<std::pair<Buffer::Ptr, bool>> list, SendResu
 #endif //defined(__linux__) || defined(__linux)
 
 
+static std::atomic<uint64_t> s_send_syscall_count(0);
+
+void BufferList::onSyscall() {
+    s_send_syscall_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t BufferList::getSyscallCount() {
+    return s_send_syscall_count.load(std::memory_order_relaxed);
+}
+
 BufferList::Ptr BufferList::create(List<std::pair<Buffer::Ptr, bool> > list, SendResult cb, bool is_udp) {
 #if defined(_WIN32)
     if (is_udp) {
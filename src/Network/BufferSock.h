@@ -64,6 +64,12 @@ public:
 
     static Ptr create(List<std::pair<Buffer::Ptr, bool> > list, SendResult cb, bool is_udp);
 
+    // 累计调用发送系统调用(sendmsg/sendmmsg/send/sendto)的次数
+    static uint64_t getSyscallCount();
+
+protected:
+    static void onSyscall();
+
 private:
     //对象个数统计  [AUTO-TRANSLATED:3b43e8c2]
     //Object count statistics
@@ -16,6 +16,7 @@
 #include "Util/util.h"
 #include "Util/SSLBox.h"
 #include "Redis/TransactionContext.h"
+#include "Redis/ReplySequencer.h"
 
 namespace toolkit {
 
@@ -55,6 +56,19 @@ public:
 
     virtual TransactionContext& getTransactionContext() {};
 
+    // 会话当前选择的数据库（SELECT）
+    virtual int getDbIndex() const { return 0; }
+    virtual void setDbIndex(int dbIndex) {}
+    // 回复排序器（分片模式下使用），不支持时返回 nullptr
+    virtual ReplySequencer *getReplySequencer() { return nullptr; }
+    // 客户端是否已断开（可在任意线程中调用），已断开的会话排队中的命令不再执行
+    virtual bool closed() const { return false; }
+    // 合并回复模式下把发送缓存中的回复一次发出（执行线程每轮结束、onRecv 结束时调用）
+    virtual void flushReplies() { flushAll(); }
+    // 暂停 / 恢复分发收到的命令（只在 poller 线程中调用）：暂停期间收到的数据留在接收缓存中，恢复后继续解析分发
+    virtual void holdCommands() {}
+    virtual void resumeCommands() {}
+
 private:
     mutable std::string _id;
     std::unique_ptr<toolkit::ObjectStatistic<toolkit::TcpSession> > _statistic_tcp;
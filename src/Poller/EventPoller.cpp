@@ -53,6 +53,12 @@ using namespace std;
 
 namespace toolkit {
 
+//时间轮中的延时任务节点，到期且不再重复时释放
+struct DelayNode : public TimingWheel::Node {
+    explicit DelayNode(EventPoller::DelayTask::Ptr task) : task(std::move(task)) {}
+    EventPoller::DelayTask::Ptr task;
+};
+
 EventPoller &EventPoller::Instance() {
     return *(EventPollerPool::Instance().getFirstPoller());
 }
@@ -68,7 +74,7 @@ void EventPoller::addEventPipe() {
     }
 }
 
-EventPoller::EventPoller(std::string name) {
+EventPoller::EventPoller(std::string name) : _delay_wheel(getCurrentMillisecond()) {
 #if defined(HAS_EPOLL) || defined(HAS_KQUEUE)
     _event_fd = create_event();
     if (_event_fd == -1) {
@@ -109,6 +115,9 @@ EventPoller::~EventPoller() {
     //退出前清理管道中的数据  [AUTO-TRANSLATED:60e26f9a]
     //Clean up pipe data before exiting
     onPipeEvent(true);
+    _delay_wheel.clear([](TimingWheel::Node *node) {
+        delete static_cast<DelayNode *>(node);
+    });
     InfoL << getThreadName();
 }
 
@@ -523,50 +532,47 @@ void EventPoller::runLoop(bool blocked, bool ref_self) {
 }
 
 uint64_t EventPoller::flushDelayTask(uint64_t now_time) {
-    decltype(_delay_task_map) task_copy;
-    task_copy.swap(_delay_task_map);
-
-    for (auto it = task_copy.begin(); it != task_copy.end() && it->first <= now_time; it = task_copy.erase(it)) {
+    _delay_wheel.advance(now_time, [&](TimingWheel::Node *node) {
         //已到期的任务  [AUTO-TRANSLATED:849cdc29]
         //Expired tasks
+        auto delay = static_cast<DelayNode *>(node);
         try {
-            auto next_delay = (*(it->second))();
+            auto next_delay = (*(delay->task))();
             if (next_delay) {
                 //可重复任务,更新时间截止线  [AUTO-TRANSLATED:c7746a21]
                 //Repeatable tasks, update deadline
-                _delay_task_map.emplace(next_delay + now_time, std::move(it->second));
+                _delay_wheel.add(delay, next_delay + now_time);
+                return;
             }
         } catch (std::exception &ex) {
             ErrorL << "Exception occurred when do delay task: " << ex.what();
         }
-    }
-
-    task_copy.insert(_delay_task_map.begin(), _delay_task_map.end());
-    task_copy.swap(_delay_task_map);
+        delete delay;
+    });
 
-    auto it = _delay_task_map.begin();
-    if (it == _delay_task_map.end()) {
+    uint64_t next;
+    if (!_delay_wheel.nextExpire(next)) {
         //没有剩余的定时器了  [AUTO-TRANSLATED:23b1119e]
         //No remaining timers
         return 0;
     }
-    //最近一个定时器的执行延时  [AUTO-TRANSLATED:2535621b]
+    //最近一个定时器的执行延时（回调中新添加的已到期任务下一轮执行）  [AUTO-TRANSLATED:2535621b]
     //Delay in execution of the last timer
-    return it->first - now_time;
+    return next > now_time ? next - now_time : 1;
 }
 
 uint64_t EventPoller::getMinDelay() {
-    auto it = _delay_task_map.begin();
-    if (it == _delay_task_map.end()) {
+    uint64_t next;
+    if (!_delay_wheel.nextExpire(next)) {
         //没有剩余的定时器了  [AUTO-TRANSLATED:23b1119e]
         //No remaining timers
         return 0;
     }
     auto now = getCurrentMillisecond();
-    if (it->first > now) {
+    if (next > now) {
         //所有任务尚未到期  [AUTO-TRANSLATED:8d80eabf]
         //All tasks have not expired
-        return it->first - now;
+        return next - now;
     }
     //执行已到期的任务并刷新休眠延时  [AUTO-TRANSLATED:cd6348b7]
     //Execute expired tasks and refresh sleep delay
@@ -579,7 +585,7 @@ EventPoller::DelayTask::Ptr EventPoller::doDelayTask(uint64_t delay_ms, function
     async_first([time_line, ret, this]() {
         //异步执行的目的是刷新select或epoll的休眠时间  [AUTO-TRANSLATED:a6b5c8d7]
         //The purpose of asynchronous execution is to refresh the sleep time of select or epoll
-        _delay_task_map.emplace(time_line, ret);
+        _delay_wheel.add(new DelayNode(ret), time_line);
     });
     return ret;
 }
@@ -19,6 +19,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include "PipeWrap.h"
+#include "TimingWheel.h"
 #include "Util/logger.h"
 #include "Util/List.h"
 #include "Thread/TaskExecutor.h"
@@ -341,7 +342,8 @@ private:
 
     //定时器相关  [AUTO-TRANSLATED:fa2e84da]
     //Timer related
-    std::multimap<uint64_t, DelayTask::Ptr> _delay_task_map;
+    //延时任务放在分层时间轮中，添加 O(1)，休眠时间由时间轮的位图直接得出
+    TimingWheel _delay_wheel;
 };
 
 class EventPollerPool : public std::enable_shared_from_this<EventPollerPool>, public TaskExecutorGetterImp {
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2016 The ZLToolKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLToolKit(https://github.com/ZLMediaKit/ZLToolKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "TimingWheel.h"
+
+namespace toolkit {
+
+TimingWheel::TimingWheel(uint64_t now) : _current(now) {
+    for (auto &head : _heads) {
+        head._prev = head._next = &head;
+    }
+}
+
+void TimingWheel::add(Node *node, uint64_t expire) {
+    if (node->armed()) {
+        cancel(node);
+    }
+    node->_expire = expire;
+    uint32_t slot = kDueSlot;
+    if (expire > _current) {
+        auto delta = expire - _current;
+        int level = 0;
+        while (level + 1 < kLevels && delta >= (uint64_t(1) << (kBits * (level + 1)))) {
+            ++level;
+        }
+        auto at = expire;
+        if (delta >> (kBits * kLevels)) {
+            //超出时间轮的范围，先放在最高层最远的槽，下放时重新计算
+            at = _current + (uint64_t(1) << (kBits * kLevels)) - 1;
+        }
+        slot = level * kSlots + slotIndex(at, level);
+    }
+    link(node, slot);
+    ++_size;
+}
+
+void TimingWheel::cancel(Node *node) {
+    if (!node->armed()) {
+        return;
+    }
+    auto slot = node->_slot;
+    unlink(node);
+    --_size;
+    //整体移走的节点仍记着原来的槽，原来的槽已空时清除位图同样正确
+    if (slot < kDueSlot && _heads[slot]._next == &_heads[slot]) {
+        _bitmap[slot / kSlots][(slot % kSlots) / 64] &= ~(uint64_t(1) << (slot % 64));
+    }
+}
+
+bool TimingWheel::nextExpire(uint64_t &at) const {
+    if (!_size) {
+        return false;
+    }
+    if (_due._next != &_due) {
+        at = _current;
+        return true;
+    }
+    return nextTick(at);
+}
+
+void TimingWheel::link(Node *node, uint32_t slot) {
+    auto head = &_heads[slot];
+    node->_slot = slot;
+    node->_prev = head->_prev;
+    node->_next = head;
+    head->_prev->_next = node;
+    head->_prev = node;
+    if (slot < kDueSlot) {
+        _bitmap[slot / kSlots][(slot % kSlots) / 64] |= uint64_t(1) << (slot % 64);
+    }
+}
+
+void TimingWheel::unlink(Node *node) {
+    node->_prev->_next = node->_next;
+    node->_next->_prev = node->_prev;
+    node->_prev = node->_next = nullptr;
+}
+
+void TimingWheel::splice(Node *from, Node *to) {
+    if (from->_next == from) {
+        return;
+    }
+    from->_next->_prev = to->_prev;
+    to->_prev->_next = from->_next;
+    from->_prev->_next = to;
+    to->_prev = from->_prev;
+    from->_prev = from->_next = from;
+    if (from >= _heads && from < _heads + kDueSlot) {
+        auto index = static_cast<uint32_t>(from - _heads);
+        _bitmap[index / kSlots][(index % kSlots) / 64] &= ~(uint64_t(1) << (index % 64));
+    }
+}
+
+void TimingWheel::cascade(int level, uint32_t index) {
+    auto head = &_heads[level * kSlots + index];
+    if (head->_next == head) {
+        return;
+    }
+    Node list;
+    list._prev = list._next = &list;
+    splice(head, &list);
+    //链表已整体取下，逐个重新放入时不必再维护它
+    for (auto node = list._next; node != &list;) {
+        auto next = node->_next;
+        node->_prev = node->_next = nullptr;
+        --_size;
+        add(node, node->_expire);
+        node = next;
+    }
+}
+
+int TimingWheel::findSlot(int level, uint32_t from) const {
+    for (auto word = from / 64; word < kSlots / 64; ++word) {
+        auto bits = _bitmap[level][word];
+        if (word == from / 64) {
+            bits &= ~uint64_t(0) << (from % 64);
+        }
+        if (bits) {
+            return static_cast<int>(word * 64 + __builtin_ctzll(bits));
+        }
+    }
+    return -1;
+}
+
+bool TimingWheel::nextTick(uint64_t &at) const {
+    bool found = false;
+    for (int level = 0; level < kLevels; ++level) {
+        //本层第 index 个槽在 current 之后第一次轮到的时间：在本圈剩余的槽中找，找不到再从下一圈开头找
+        auto shift = kBits * level;
+        auto index = slotIndex(_current, level);
+        auto base = (_current >> (shift + kBits)) << (shift + kBits);
+        auto slot = index + 1 < kSlots ? findSlot(level, index + 1) : -1;
+        if (slot >= 0) {
+            //在本圈内找到，更高层的槽最早也要到本圈结束时才下放
+            auto tick = base + (static_cast<uint64_t>(slot) << shift);
+            if (!found || tick < at) {
+                at = tick;
+            }
+            return true;
+        }
+        slot = findSlot(level, 0);
+        if (slot < 0) {
+            continue;
+        }
+        auto tick = base + (uint64_t(1) << (shift + kBits)) + (static_cast<uint64_t>(slot) << shift);
+        if (!found || tick < at) {
+            at = tick;
+            found = true;
+        }
+    }
+    return found;
+}
+
+} // namespace toolkit
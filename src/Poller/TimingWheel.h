@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2016 The ZLToolKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLToolKit(https://github.com/ZLMediaKit/ZLToolKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef TimingWheel_h
+#define TimingWheel_h
+
+#include <cstddef>
+#include <cstdint>
+
+namespace toolkit {
+
+/**
+ * 分层时间轮：4 层，每层 256 个槽，最小刻度 1 毫秒，覆盖 2^32 毫秒（约 49 天），更远的定时器先挂在最高层，到时再重新放入
+ * 定时器节点是侵入式双向链表节点（由调用者分配），添加与取消都是 O(1)；
+ * 每层用位图记录非空的槽，nextExpire() 只需查找位图，空转的刻度不需要逐个推进。
+ * 非线程安全，只能在所属线程中使用。
+ */
+class TimingWheel {
+public:
+    class Node {
+    public:
+        Node() = default;
+        Node(const Node &) = delete;
+        Node &operator=(const Node &) = delete;
+
+        // 是否已放入时间轮
+        bool armed() const { return _next != nullptr; }
+        // 到期时间（毫秒）
+        uint64_t expire() const { return _expire; }
+
+    private:
+        friend class TimingWheel;
+        Node *_prev = nullptr;
+        Node *_next = nullptr;
+        uint64_t _expire = 0;
+        uint32_t _slot = 0;
+    };
+
+    /**
+     * @param now 当前时间（毫秒），早于它的定时器在下次 advance 时到期
+     */
+    explicit TimingWheel(uint64_t now);
+    TimingWheel(const TimingWheel &) = delete;
+    TimingWheel &operator=(const TimingWheel &) = delete;
+
+    // 放入时间轮，已放入的节点先取消
+    void add(Node *node, uint64_t expire);
+    // 取消定时器，未放入的节点忽略
+    void cancel(Node *node);
+
+    /**
+     * @brief 最早可能有定时器到期的时间
+     * 高层的槽返回其下放到低层的时间，因此是一个下界：到这个时间调用 advance 后再查询即可
+     * @return 没有定时器返回 false
+     */
+    bool nextExpire(uint64_t &at) const;
+
+    /**
+     * @brief 推进到 now，依次对到期的节点调用 func(Node *)
+     * 回调前节点已从时间轮中取出，回调中可以重新 add 它、取消其它节点或添加新节点；
+     * 回调中添加的已到期节点在下次 advance 时处理
+     * @return 到期的节点数
+     */
+    template <typename Func>
+    size_t advance(uint64_t now, Func &&func) {
+        size_t fired = fireDue(func);
+        uint64_t at;
+        while (nextTick(at) && at <= now) {
+            _current = at;
+            for (int level = kLevels - 1; level > 0; --level) {
+                if ((at & ((uint64_t(1) << (kBits * level)) - 1)) == 0) {
+                    cascade(level, slotIndex(at, level));
+                }
+            }
+            splice(&_heads[slotIndex(at, 0)], &_due);
+            fired += fireDue(func);
+        }
+        if (now > _current) {
+            _current = now;
+        }
+        return fired;
+    }
+
+    // 取出所有节点，依次调用 func(Node *)（用于释放节点）
+    template <typename Func>
+    void clear(Func &&func) {
+        for (size_t slot = 0; slot <= kDueSlot; ++slot) {
+            splice(&_heads[slot], &_due);
+        }
+        Node list;
+        list._prev = list._next = &list;
+        splice(&_due, &list);
+        while (list._next != &list) {
+            auto node = list._next;
+            unlink(node);
+            --_size;
+            func(node);
+        }
+    }
+
+    // 已放入的定时器数
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    // 时间轮当前的时间
+    uint64_t current() const { return _current; }
+
+private:
+    static const int kBits = 8;
+    static const int kLevels = 4;
+    static const uint32_t kSlots = 1 << kBits;
+    static const uint32_t kDueSlot = kLevels * kSlots;     // 已到期节点的链表
+
+    static uint32_t slotIndex(uint64_t at, int level) {
+        return static_cast<uint32_t>((at >> (kBits * level)) & (kSlots - 1));
+    }
+
+    void link(Node *node, uint32_t slot);
+    void unlink(Node *node);
+    // 把 from 链表整体移到 to 链表尾部（O(1)，节点的 _slot 不更新），并清除 from 所在槽的位图
+    void splice(Node *from, Node *to);
+    void cascade(int level, uint32_t index);
+    bool nextTick(uint64_t &at) const;
+    // 位图中从 from 开始的第一个非空槽，没有返回 -1
+    int findSlot(int level, uint32_t from) const;
+
+    template <typename Func>
+    size_t fireDue(Func &func) {
+        if (_due._next == &_due) {
+            return 0;
+        }
+        // 先取出当前已到期的节点，回调中再添加的到期节点留到下次
+        Node list;
+        list._prev = list._next = &list;
+        splice(&_due, &list);
+        size_t fired = 0;
+        while (list._next != &list) {
+            auto node = list._next;
+            unlink(node);
+            --_size;
+            ++fired;
+            func(node);
+        }
+        return fired;
+    }
+
+    uint64_t _current;
+    size_t _size = 0;
+    Node _heads[kDueSlot + 1];                  // 每个槽链表的哨兵，最后一个为 _due
+    Node &_due = _heads[kDueSlot];
+    uint64_t _bitmap[kLevels][kSlots / 64] = {};
+};
+
+} // namespace toolkit
+#endif /* TimingWheel_h */
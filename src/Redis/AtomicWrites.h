@@ -0,0 +1,61 @@
+#ifndef ATOMICWRITES_H
+#define ATOMICWRITES_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace toolkit
+{
+
+// 多键写（MSET、DEL、EXEC）的发布计数，作用类似 seqlock
+// poller 线程上的并发读（--poller-reads）不经过执行线程，单个键的值整体替换，读到的总是完整的值；
+// 但多键写逐个键生效，读多个键（MGET）或读在事务执行期间，可能看到写了一半的结果。
+// 多键写开始时 active 加一，结束时先推进 generation 再减一；并发读在读取前后检查两者，
+// 读取期间有多键写进行过就放弃读到的结果，改走执行线程（与写串行）。
+class AtomicWrites {
+public:
+    static AtomicWrites &Instance() {
+        static AtomicWrites instance;
+        return instance;
+    }
+    AtomicWrites(const AtomicWrites &) = delete;
+    AtomicWrites &operator=(const AtomicWrites &) = delete;
+
+    // 多键写的作用域（可嵌套，如 EXEC 中的 MSET）
+    class Scope {
+    public:
+        Scope() {
+            AtomicWrites::Instance()._active.fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~Scope() {
+            auto &writes = AtomicWrites::Instance();
+            writes._generation.fetch_add(1, std::memory_order_seq_cst);
+            writes._active.fetch_sub(1, std::memory_order_seq_cst);
+        }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    // 并发读开始前调用：有多键写正在进行时返回 false，此时不应在 poller 线程中读取
+    bool readBegin(uint64_t &generation) const {
+        generation = _generation.load(std::memory_order_seq_cst);
+        return _active.load(std::memory_order_seq_cst) == 0;
+    }
+
+    // 并发读结束后调用：读取期间没有多键写开始或结束，读到的结果是一致的
+    bool readValidate(uint64_t generation) const {
+        // 之前对键空间的读取不能排到下面的检查之后
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return _active.load(std::memory_order_seq_cst) == 0 && _generation.load(std::memory_order_seq_cst) == generation;
+    }
+
+private:
+    AtomicWrites() = default;
+
+    std::atomic<uint64_t> _active{0};       // 正在进行的多键写
+    std::atomic<uint64_t> _generation{0};   // 已完成的多键写
+};
+
+} // namespace toolkit
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef CMDARGS_H
+#define CMDARGS_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <strings.h>
+#include <ostream>
+#include "Network/Buffer.h"
+
+namespace toolkit
+{
+
+// 只读字符串切片（C++11 下 std::string_view 的简化替代），不持有内存
+class StrView {
+public:
+    StrView() : _data(""), _size(0) {}
+    StrView(const char *data, size_t size) : _data(data), _size(size) {}
+    StrView(const char *str) : _data(str), _size(strlen(str)) {}
+    StrView(const std::string &str) : _data(str.data()), _size(str.size()) {}
+
+    const char *data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    char operator[](size_t pos) const { return _data[pos]; }
+    const char *begin() const { return _data; }
+    const char *end() const { return _data + _size; }
+
+    // 只有在需要持有数据（如写入键空间）时才拷贝为 std::string
+    std::string toString() const { return std::string(_data, _size); }
+
+    // 拷贝到本线程复用的临时字符串中（容量保留，通常不分配内存），供只接受 std::string 的查找接口使用；
+    // 返回的引用在本线程下一次调用前有效
+    const std::string &scratch() const {
+        static thread_local std::string buf;
+        buf.assign(_data, _size);
+        return buf;
+    }
+    operator std::string() const { return toString(); }
+
+    // 不区分大小写比较（命令名、子命令、选项）
+    bool equalsIgnoreCase(const char *str) const {
+        return strlen(str) == _size && strncasecmp(_data, str, _size) == 0;
+    }
+
+    friend bool operator==(const StrView &a, const StrView &b) {
+        return a._size == b._size && (a._size == 0 || memcmp(a._data, b._data, a._size) == 0);
+    }
+    friend bool operator!=(const StrView &a, const StrView &b) {
+        return !(a == b);
+    }
+    friend bool operator<(const StrView &a, const StrView &b) {
+        int ret = memcmp(a._data, b._data, a._size < b._size ? a._size : b._size);
+        return ret < 0 || (ret == 0 && a._size < b._size);
+    }
+    friend std::ostream &operator<<(std::ostream &os, const StrView &view) {
+        return os.write(view._data, view._size);
+    }
+
+private:
+    const char *_data;
+    size_t _size;
+};
+
+// 一条已解析的命令：参数是指向接收缓存的切片，通过持有缓存的引用保证切片有效
+// 从 RedisSession 解析出来后作为命令描述符（CmdDesc）的一部分传递到 executeCommand，中途不再拷贝参数
+class CmdArgs {
+public:
+    using Ptr = std::shared_ptr<CmdArgs>;
+
+    explicit CmdArgs(Buffer::Ptr buf = nullptr) : _buf(std::move(buf)) {}
+
+    // 由独立的字符串构造命令（内部生成的命令等场景），参数拷贝到一块自有缓存中
+    static Ptr create(const std::vector<std::string> &args) {
+        std::string storage;
+        for (auto &arg : args) {
+            storage += arg;
+        }
+        auto buf = std::make_shared<BufferString>(std::move(storage));
+        auto ret = std::make_shared<CmdArgs>(buf);
+        ret->reserve(args.size());
+        size_t offset = 0;
+        for (auto &arg : args) {
+            ret->push(buf->data() + offset, arg.size());
+            offset += arg.size();
+        }
+        return ret;
+    }
+
+    // 换用新的缓存并清空参数（描述符复用时调用），保留切片数组的容量，超大命令留下的容量则释放
+    void reset(Buffer::Ptr buf) {
+        _buf = std::move(buf);
+        if (_args.capacity() > kRetainedArgs) {
+            std::vector<StrView>().swap(_args);
+        } else {
+            _args.clear();
+        }
+    }
+
+    void reserve(size_t n) { _args.reserve(n); }
+    void push(const char *data, size_t size) { _args.emplace_back(data, size); }
+
+    size_t size() const { return _args.size(); }
+    bool empty() const { return _args.empty(); }
+    const StrView &operator[](size_t pos) const { return _args[pos]; }
+    const StrView &front() const { return _args.front(); }
+    std::vector<StrView>::const_iterator begin() const { return _args.begin(); }
+    std::vector<StrView>::const_iterator end() const { return _args.end(); }
+
+    const Buffer::Ptr &getBuffer() const { return _buf; }
+
+private:
+    static const size_t kRetainedArgs = 64;
+
+    Buffer::Ptr _buf;               // 参数所在的缓存
+    std::vector<StrView> _args;     // 参数切片
+};
+
+} // namespace toolkit
+
+#endif
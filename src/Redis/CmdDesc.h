@@ -0,0 +1,164 @@
+#ifndef CMDDESC_H
+#define CMDDESC_H
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include "CmdArgs.h"
+
+namespace toolkit
+{
+
+class Session;
+class CmdHandler;
+struct CommandSpec;
+
+// 命令描述符：一条已解析的命令从分发、排队到执行所需的全部状态（解析器、参数切片、会话、数据库）
+// 命令队列与事务队列中只保存描述符，不再为每条命令构造捕获参数与会话的 std::function。
+// 描述符由分配它的线程的对象池复用（空闲链表），引用计数内嵌在对象中，稳定运行后分发一条命令不需要 malloc。
+class CmdDesc {
+    class Pool;
+
+public:
+    // 描述符的引用计数句柄（intrusive），最后一个句柄释放时描述符归还到对象池
+    class Ptr {
+    public:
+        Ptr() = default;
+        Ptr(std::nullptr_t) {}
+        explicit Ptr(CmdDesc *desc) : _desc(desc) {
+            if (_desc) {
+                _desc->_refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        Ptr(const Ptr &other) : Ptr(other._desc) {}
+        Ptr(Ptr &&other) noexcept : _desc(other._desc) {
+            other._desc = nullptr;
+        }
+        Ptr &operator=(Ptr other) noexcept {
+            std::swap(_desc, other._desc);
+            return *this;
+        }
+        ~Ptr() {
+            if (_desc) {
+                _desc->release();
+            }
+        }
+
+        CmdDesc *get() const { return _desc; }
+        CmdDesc *operator->() const { return _desc; }
+        CmdDesc &operator*() const { return *_desc; }
+        explicit operator bool() const { return _desc != nullptr; }
+
+    private:
+        CmdDesc *_desc = nullptr;
+    };
+
+    /**
+    * @brief 从当前线程的对象池取出一个描述符
+    * @param buf 参数切片所在的接收缓存
+    */
+    static Ptr create(Buffer::Ptr buf) {
+        auto desc = Pool::current().acquire();
+        desc->args.reset(std::move(buf));
+        return Ptr(desc);
+    }
+
+    CmdDesc(const CmdDesc &) = delete;
+    CmdDesc &operator=(const CmdDesc &) = delete;
+
+    CmdArgs args;                       // 参数切片，切片数组的容量随描述符复用
+    const CommandSpec *spec = nullptr;  // 命令表中的元数据
+    CmdHandler *parser = nullptr;       // 命令的解析器（由 CmdParserFactory 持有，生命周期与进程相同）
+    std::shared_ptr<Session> session;   // 发出命令的会话
+    int dbIndex = 0;                    // 分发时会话所选的数据库
+    uint64_t enqueueTime = 0;           // 进入命令队列的时间（毫秒），启用 maxQueueAgeMs 时记录
+    bool shed = false;                  // 入队时命令队列已超过 maxQueueDepth，轮到它时只回复 -BUSY
+
+private:
+    // 每个线程一个对象池：本线程归还的描述符放入普通链表，其它线程（执行线程）归还的压入无锁栈，
+    // 本线程的链表取空时再整体取走无锁栈。压栈与整体取走都不存在 ABA 问题。
+    class Pool {
+    public:
+        // 线程退出后对象池不释放：仍在其它线程中的描述符最终还会归还到这里
+        static Pool &current() {
+            auto &pool = local();
+            if (!pool) {
+                pool = new Pool();
+            }
+            return *pool;
+        }
+
+        CmdDesc *acquire() {
+            if (!_free) {
+                _free = _remote.exchange(nullptr, std::memory_order_acquire);
+            }
+            if (auto desc = _free) {
+                _free = desc->_next;
+                desc->_next = nullptr;
+                return desc;
+            }
+            auto desc = new CmdDesc();
+            desc->_pool = this;
+            return desc;
+        }
+
+        void recycle(CmdDesc *desc) {
+            if (local() == this) {
+                desc->_next = _free;
+                _free = desc;
+                return;
+            }
+            auto head = _remote.load(std::memory_order_relaxed);
+            do {
+                desc->_next = head;
+            } while (!_remote.compare_exchange_weak(head, desc, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+    private:
+        static Pool *&local() {
+            static thread_local Pool *pool = nullptr;
+            return pool;
+        }
+
+        CmdDesc *_free = nullptr;                   // 只由所属线程访问
+        std::atomic<CmdDesc *> _remote{nullptr};    // 其它线程归还的描述符
+    };
+
+    CmdDesc() = default;
+
+    // 释放持有的会话与接收缓存后归还，避免空闲的描述符延长它们的生命周期
+    void release() {
+        if (_refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        args.reset(nullptr);
+        spec = nullptr;
+        parser = nullptr;
+        session = nullptr;
+        dbIndex = 0;
+        enqueueTime = 0;
+        shed = false;
+        _pool->recycle(this);
+    }
+
+    std::atomic<uint32_t> _refs{0};
+    CmdDesc *_next = nullptr;           // 空闲链表
+    Pool *_pool = nullptr;              // 分配它的线程的对象池
+};
+
+// 命令描述符的处理者（CommandParser），命令队列与事务队列通过它分发和执行描述符
+class CmdHandler {
+public:
+    virtual ~CmdHandler() = default;
+
+    // 在会话所在 poller 线程中分发：直接执行、路由到键所属分片或放入命令队列
+    virtual void parserAndExecuter(const CmdDesc::Ptr &cmd) = 0;
+    // 在执行线程中执行已放入命令队列的命令
+    virtual void run(CmdDesc &cmd) = 0;
+};
+
+} // namespace toolkit
+
+#endif
@@ -2,15 +2,30 @@
 #define CMDPARSER_H
 
 #include <vector>
+#include <string>
+#include <algorithm>
 #include <memory>
+#include <cstdlib>
+#include <cerrno>
+#include <cstdint>
 #include "CmdQueueManager.h"
 #include "RedisHelper.h"
 #include "RedisSession.h"
+#include "CmdArgs.h"
+#include "CmdDesc.h"
+#include "CommandTable.h"
+#include "SharedReply.h"
+#include "RespWriter.h"
+#include "ShardRouter.h"
+#include "Epoch.h"
+#include "AtomicWrites.h"
+#include "StringMatch.h"
+#include "Util/onceToken.h"
 
 
 namespace toolkit
 {
-class CommandParser {
+class CommandParser : public CmdHandler {
 public:
     using Ptr = std::shared_ptr<CommandParser>;
 
@@ -18,35 +33,411 @@ public:
     CommandParser() = delete;
     virtual ~CommandParser() = default;
 
+    // 绑定命令表中的元数据，由 CmdParserFactory 在创建解析器时调用
+    void bind(const CommandSpec &spec) {
+        spec_ = &spec;
+    }
+    const CommandSpec &spec() const {
+        return *spec_;
+    }
+
+    // 分片模式与多执行线程模式下命令的路由方式
+    enum Route {
+        ROUTE_KEY,      // 按第一个参数（键）路由到所属分片
+        ROUTE_LOCAL,    // 不访问键空间，在会话所在的 poller 线程执行
+        ROUTE_FANOUT    // 多键或全库命令，拆分到各分片执行后汇总（见 fanout）
+    };
+
     // 解析并执行，执行并不是真正执行，而是将其压入命令队列管理器等待执行
-    void parserAndExecuter(const std::vector<std::string> &args, Session::Ptr session) {
-        if(!parserCommand(std::move(args), session)){
+    // 命令以描述符传递，入队时只移动句柄，不拷贝参数、不构造闭包
+    void parserAndExecuter(const CmdDesc::Ptr &cmd) override {
+        auto &session = cmd->session;
+        if(!parserCommand(cmd->args, session)){
+            return;
+        }
+        // 数据库在入队时确定：同一会话的 SELECT 已在此前的 parserCommand 中生效
+        cmd->dbIndex = session->getDbIndex();
+        auto sequencer = session->getReplySequencer();
+        if (readOnly() && RedisConfig::Instance().pollerReads && Keyspace::sharedReads() && sequencer->quiescent() &&
+            executeRead(cmd->args, session, cmd->dbIndex)) {
+            // 只读命令且该会话之前的命令都已完成：直接在 poller 线程中读取，不经过执行线程
+            return;
+        }
+        if (ShardRouter::Instance().enabled()) {
+            // 分片模式或多执行线程：在键所属分片的线程上执行，回复由会话按命令顺序发送
+            dispatch(cmd);
+            return;
+        }
+
+        if (overloaded(*cmd)) {
+            if (sequencer->quiescent()) {
+                // 该会话没有排队中的命令，直接拒绝不会打乱回复顺序
+                session->send(SharedReply::busy());
+                return;
+            }
+            // 排在该会话之前的命令之后回复 -BUSY，不执行
+            cmd->shed = true;
+        }
+        if (RedisConfig::Instance().maxQueueAgeMs) {
+            cmd->enqueueTime = getCurrentMillisecond();
+        }
+        sequencer->beginQueued();
+        CommandQueueManager::Instance().pushCommand(cmd);
+    }
+
+    // 在执行线程中执行由 parserAndExecuter 放入命令队列的命令
+    void run(CmdDesc &cmd) override {
+        auto &session = cmd.session;
+        if (RedisConfig::Instance().replyBatching) {
+            CommandQueueManager::Instance().addPendingFlush(session);
+        }
+        auto sequencer = session->getReplySequencer();
+        onceToken token(nullptr, [sequencer]() {
+            sequencer->endQueued();
+        });
+        if (!admit(cmd)) {
+            return;
+        }
+        this->execute(cmd.args, session, cmd.dbIndex);
+    }
+
+    // 在当前线程中执行事务中的一条已解析的命令（EXEC 在同一个任务中依次执行事务中的命令）。
+    // 启用分片路由时事务在 ShardRouter::Inline 作用域中执行，命令照常路由，由 ShardRouter 切换到键所属的分片直接执行
+    void executeQueued(const CmdDesc::Ptr &cmd) {
+        if (ShardRouter::Instance().enabled()) {
+            dispatch(cmd);
+            return;
+        }
+        this->execute(cmd->args, cmd->session, cmd->dbIndex);
+    }
+
+    // 启用分片路由时命令访问的分片并入 shards（EXEC 据此决定要独占哪些分片）：
+    // 访问整个键空间的命令（KEYS、DBSIZE 等）为所有分片，其余为其各个键所属的分片
+    void collectShards(const CmdArgs &command, std::vector<size_t> &shards) const {
+        auto &router = ShardRouter::Instance();
+        if (route() == ROUTE_FANOUT && spec_->firstKey == 0) {
+            for (size_t i = 0; i < router.shardCount(); ++i) {
+                shards.push_back(i);
+            }
+            return;
+        }
+        CommandTable::forEachKey(*spec_, command, [&](const StrView &key) {
+            shards.push_back(router.shardOf(key));
+        });
+    }
+
+    // 解析并执行，dbIndex 为命令入队时会话所选的数据库
+    virtual void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) = 0;
+    virtual bool parserCommand(const CmdArgs &command, Session::Ptr session) = 0;
+
+protected:
+    virtual Route route() const {
+        return ROUTE_KEY;
+    }
+
+    // 命令队列已超过 maxQueueDepth，新命令应当拒绝（控制命令不拒绝，过载时仍可以用 INFO 观察）
+    static bool overloaded(const CmdDesc &cmd) {
+        auto maxDepth = RedisConfig::Instance().maxQueueDepth;
+        if (!maxDepth || (cmd.spec && (cmd.spec->flags & CMD_CONTROL))) {
+            return false;
+        }
+        if (CommandQueueManager::Instance().depth() < maxDepth) {
+            return false;
+        }
+        RedisStats::Instance().onShedDepth();
+        return true;
+    }
+
+    // 执行线程中轮到该命令时是否仍应执行：客户端已断开的直接丢弃，入队时被拒绝或排队超时的回复 -BUSY
+    static bool admit(const CmdDesc &cmd) {
+        auto &session = cmd.session;
+        if (session->closed()) {
+            RedisStats::Instance().onDropClosed();
+            return false;
+        }
+        if (cmd.shed) {
+            session->send(SharedReply::busy());
+            return false;
+        }
+        auto maxAge = RedisConfig::Instance().maxQueueAgeMs;
+        if (maxAge && cmd.enqueueTime && getCurrentMillisecond() - cmd.enqueueTime > maxAge) {
+            RedisStats::Instance().onShedAge();
+            session->send(SharedReply::busy());
+            return false;
+        }
+        return true;
+    }
+
+    // 只读命令（只读取整体替换的字符串值或键本身）返回 true，可以在 poller 线程中通过 executeRead 直接执行
+    virtual bool readOnly() const {
+        return false;
+    }
+
+    // 只读命令在 poller 线程中的执行，只能通过 RedisHelper 的 *Shared 接口读取键空间
+    virtual void executeShared(const CmdArgs &command, const Session::Ptr &session, int dbIndex) {}
+
+    // 读取期间有多键写（MSET、DEL、EXEC）进行时放弃结果并返回 false，由调用者改走执行线程，不会读到写了一半的结果
+    bool executeRead(const CmdArgs &command, const Session::Ptr &session, int dbIndex) {
+        auto &writes = AtomicWrites::Instance();
+        uint64_t generation = 0;
+        if (!writes.readBegin(generation)) {
+            return false;
+        }
+        // 回复先捕获下来，确认读到的结果一致后再发送
+        std::vector<Buffer::Ptr> replies;
+        {
+            Epoch::Guard guard;
+            ReplySequencer::Capture capture(session.get(), replies);
+            try {
+                executeShared(command, session, dbIndex);
+            } catch (const WrongTypeError &) {
+                session->send(SharedReply::wrongType());
+            } catch (const std::exception &ex) {
+                session->send(SharedReply::error(ex.what()));
+            }
+        }
+        if (!writes.readValidate(generation)) {
+            return false;
+        }
+        RedisStats::Instance().onCommand();
+        RedisStats::Instance().onPollerRead();
+        for (auto &reply : replies) {
+            session->send(std::move(reply));
+        }
+        return true;
+    }
+
+    // 写多个键的命令（MSET、DEL），执行期间并发读不能在 poller 线程中进行（见 AtomicWrites）
+    bool multiKeyWrite() const {
+        return (spec_->flags & CMD_WRITE) && spec_->lastKey < 0;
+    }
+
+    // 启用分片路由时按 route() 执行命令：在键所属分片的线程上执行，回复由会话按命令顺序发送
+    void dispatch(const CmdDesc::Ptr &cmd) {
+        auto &router = ShardRouter::Instance();
+        switch (route()) {
+            case ROUTE_FANOUT:
+                fanout(cmd);
+                break;
+            case ROUTE_LOCAL:
+                // 不访问键空间，直接在会话所在线程执行，前面有未完成的命令时回复会排在它们之后
+                this->execute(cmd->args, cmd->session, cmd->dbIndex);
+                break;
+            default:
+                router.execute(router.shardOf(cmd->args[1]), cmd->session, [cmd, this]() {
+                    this->execute(cmd->args, cmd->session, cmd->dbIndex);
+                });
+                break;
+        }
+    }
+
+    // 启用分片路由时 ROUTE_FANOUT 命令的执行：按分片拆分，通过 ShardRouter::scatter 分发，汇总后用 replyFanout 回复
+    virtual void fanout(const CmdDesc::Ptr &cmd) {}
+
+    // 在当前线程（键所属分片的执行线程或 poller）上执行命令
+    void execute(const CmdArgs &command, const Session::Ptr &session, int dbIndex) {
+        RedisStats::Instance().onCommand();
+        // 超出 maxmemory 时先淘汰；无法回到上限以内时拒绝可能增加内存的命令（DEL 等仍可执行）
+        if ((spec_->flags & CMD_WRITE) && !redisHelper_->performEvictions() && (spec_->flags & CMD_DENYOOM)) {
+            session->send(SharedReply::oom());
+            return;
+        }
+        try {
+            if (multiKeyWrite()) {
+                AtomicWrites::Scope scope;
+                executeCommand(command, session, dbIndex);
+            } else {
+                executeCommand(command, session, dbIndex);
+            }
+            if (spec_->flags & CMD_WRITE) {
+                touchKeys(command, dbIndex);
+            }
+        } catch (const WrongTypeError &) {
+            // 键已存在且类型不符
+            session->send(SharedReply::wrongType());
+        } catch (const std::exception &ex) {
+            // 其它执行错误（如 INCR 的值不是整数）也必须回复，否则分片模式下该会话之后的回复会一直等待
+            session->send(SharedReply::error(ex.what()));
+        }
+    }
+
+    // 解析整数参数（十进制，不允许多余字符）
+    static bool parseInteger(const StrView &arg, int64_t &value) {
+        auto &str = arg.scratch();
+        if (str.empty()) {
+            return false;
+        }
+        char *end = nullptr;
+        errno = 0;
+        value = strtoll(str.c_str(), &end, 10);
+        return *end == '\0' && errno != ERANGE;
+    }
+
+    // INCR/DECR/INCRBY/DECRBY：键的值加上 delta 后回复新值，键原有的过期时间保留；值不是整数或溢出时回复错误
+    static void incrementBy(RedisString *redisString, const StrView &key, int64_t delta, const Session::Ptr &session) {
+        int64_t value = 0;
+        auto current = redisString->get(key);
+        if (current && !parseInteger(*current, value)) {
+            session->send("-ERR value is not an integer or out of range\r\n");
+            return;
+        }
+        if ((delta > 0 && value > INT64_MAX - delta) || (delta < 0 && value < INT64_MIN - delta)) {
+            session->send("-ERR increment or decrement would overflow\r\n");
             return;
         }
-        std::string cmd = args[0];
-        auto dataStore = redisHelper_->getDataType(cmd);
+        value += delta;
+        redisString->update(key, std::to_string(value));
+        session->send(SharedReply::integer(value));
+    }
+
+    // SCAN/HSCAN/SSCAN 的参数
+    struct ScanArgs {
+        size_t cursor = 0;
+        const StrView *match = nullptr;     // MATCH 模式，nullptr 表示不过滤
+        size_t count = 10;                  // 每次调用至少访问的元素数
+        const StrView *type = nullptr;      // TYPE（只用于 SCAN）
+    };
+
+    // 解析 cursor [MATCH pattern] [COUNT count] [TYPE type]，cursorIndex 为游标参数的位置，参数不合法时回复错误
+    static bool parseScanArgs(const CmdArgs &command, size_t cursorIndex, bool allowType, ScanArgs &args,
+                              const Session::Ptr &session) {
+        int64_t value;
+        if (!parseInteger(command[cursorIndex], value) || value < 0) {
+            session->send("-ERR invalid cursor\r\n");
+            return false;
+        }
+        args.cursor = static_cast<size_t>(value);
+        for (size_t i = cursorIndex + 1; i < command.size(); i += 2) {
+            auto &option = command[i];
+            if (i + 1 >= command.size()) {
+                session->send("-ERR syntax error\r\n");
+                return false;
+            }
+            if (option.equalsIgnoreCase("MATCH")) {
+                args.match = &command[i + 1];
+            } else if (option.equalsIgnoreCase("COUNT")) {
+                if (!parseInteger(command[i + 1], value)) {
+                    session->send("-ERR value is not an integer or out of range\r\n");
+                    return false;
+                }
+                if (value < 1) {
+                    session->send("-ERR syntax error\r\n");
+                    return false;
+                }
+                args.count = static_cast<size_t>(value);
+            } else if (allowType && option.equalsIgnoreCase("TYPE")) {
+                args.type = &command[i + 1];
+            } else {
+                session->send("-ERR syntax error\r\n");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool scanMatch(const ScanArgs &args, const std::string &str) {
+        return !args.match || StringMatch::match(args.match->data(), args.match->size(), str.data(), str.size());
+    }
+
+    // SCAN 类命令的回复：下一个游标与本次取出的元素
+    static Buffer::Ptr scanReply(size_t cursor, const std::vector<std::string> &items) {
+        auto next = std::to_string(cursor);
+        size_t length = RespWriter::arrayLength(2) + RespWriter::bulkLength(next.size()) + RespWriter::arrayLength(items.size());
+        for (auto &item : items) {
+            length += RespWriter::bulkLength(item.size());
+        }
+        RespWriter response(length);
+        response.array(2);
+        response.bulk(next);
+        response.array(items.size());
+        for (auto &item : items) {
+            response.bulk(item);
+        }
+        return response.buffer();
+    }
 
-        CommandQueueManager::Instance().pushCommand([args,this,session,dataStore]() {
-            this->executeCommand(std::move(args),std::move(session),std::move(dataStore));
+    // 写命令执行后增大其所有键的版本号（WATCH）
+    void touchKeys(const CmdArgs &command, int dbIndex) {
+        CommandTable::forEachKey(*spec_, command, [&](const StrView &key) {
+            redisHelper_->touchKey(dbIndex, key);
         });
     }
 
-    // 解析并执行
-    virtual void executeCommand(const std::vector<std::string>& command, Session::Ptr session, RedisDataType::Ptr dataStore) = 0;
-    virtual bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) = 0;
+    // 按分片对参数分组：返回涉及的分片，groups[shard] 为该分片上的参数下标（从 first 开始，每 step 个参数一组）
+    static std::vector<size_t> groupByShard(const CmdArgs &command, size_t first, size_t step,
+                                            std::vector<std::vector<size_t>> &groups) {
+        auto &router = ShardRouter::Instance();
+        groups.assign(router.shardCount(), std::vector<size_t>());
+        std::vector<size_t> shards;
+        for (size_t i = first; i < command.size(); i += step) {
+            auto shard = router.shardOf(command[i]);
+            if (groups[shard].empty()) {
+                shards.push_back(shard);
+            }
+            groups[shard].push_back(i);
+        }
+        return shards;
+    }
+
+    // 所有分片
+    static std::vector<size_t> allShards() {
+        std::vector<size_t> shards(ShardRouter::Instance().shardCount());
+        for (size_t i = 0; i < shards.size(); ++i) {
+            shards[i] = i;
+        }
+        return shards;
+    }
+
+    // 预留回复序号，汇总完成后（任意线程）调用返回的函数发送回复
+    static std::function<void(Buffer::Ptr)> replyFanout(const Session::Ptr &session) {
+        RedisStats::Instance().onCommand();
+        if (ShardRouter::inlined()) {
+            // 事务中各分片已在当前线程中执行完毕，直接回复（由 EXEC 捕获）
+            return [session](Buffer::Ptr buf) {
+                session->send(std::move(buf));
+            };
+        }
+        auto seq = session->getReplySequencer()->reserve();
+        return [session, seq](Buffer::Ptr buf) {
+            ShardRouter::reply(session, seq, std::vector<Buffer::Ptr>{std::move(buf)});
+        };
+    }
+
+    // 汇总前某个分片抛出异常时以 -ERR 代替汇总结果回复（ShardRouter::scatter 的 fail）
+    static std::function<void(const std::string &)> failFanout(const std::function<void(Buffer::Ptr)> &reply) {
+        return [reply](const std::string &error) {
+            reply(SharedReply::error(error));
+        };
+    }
 
 protected:
     RedisHelper::Ptr redisHelper_;
+    const CommandSpec *spec_ = nullptr;
+};
+
+// 操作某一种数据类型的命令解析器（CRTP）
+// 派生类实现非虚的 executeTyped，执行时直接取得当前分片上 Store 的视图并静态调用，
+// 不需要按类型名查找，也不需要 dynamic_pointer_cast；键的类型检查由 Keyspace 比较类型标签完成
+template <typename Derived, typename Store>
+class TypedParser : public CommandParser {
+public:
+    explicit TypedParser(RedisHelper::Ptr helper) : CommandParser(std::move(helper)) {}
+
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) final {
+        static_cast<Derived *>(this)->executeTyped(command, session, &redisHelper_->store<Store>(dbIndex), dbIndex);
+    }
 };
 
 // SET 命令解析器 
-class SetParser : public CommandParser {
+class SetParser : public TypedParser<SetParser, RedisString> {
 public:
     explicit SetParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if(command.size() < 3) {
             ////DebugL << "Invalid SET command.";
             session->send(std::move("-ERR wrong number of arguments for 'set' command\r\n"));
@@ -55,29 +446,27 @@ private:
         return true;
     }  
     // 执行 SET 命令的逻辑
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session,RedisDataType::Ptr dataStore) override {
-        // 动态类型转换
-        auto redisString = std::dynamic_pointer_cast<RedisString>(dataStore);
-        if(!redisString) {
-            //DebugL << "Error: Data store is not a RedisString type.";
-            session->send(std::move("-ERR operation against a key holding the wrong kind of value\r\n"));
-            return;
-        }
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
         // 调用 RedisString 的 insert 方法
-        redisString->insert({command[1] ,command[2]});
+        redisString->set(command[1], command[2]);
         //DebugL << "Inserted key: " << command[1] << " with value: " << command[2];
-        session->send(std::move("+OK\r\n"));
+        session->send(SharedReply::ok());
     }
 };
 
 // GET 命令解析器
-class GetParser : public CommandParser {
+class GetParser : public TypedParser<GetParser, RedisString> {
 public:
     explicit GetParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    friend TypedParser;
+
+    bool readOnly() const override {
+        return true;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if(command.size() != 2) {
             //DebugL << "Invalid GET command.";
             session->send(std::move("-ERR wrong number of arguments for 'get' command\r\n"));
@@ -87,31 +476,38 @@ private:
     }  
 
     // 执行 Get 命令的逻辑
-    void executeCommand(const std::vector<std::string> &command,Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换
-        auto redisString = std::dynamic_pointer_cast<RedisString>(dataStore);
-        if(!redisString) {
-            //DebugL << "Error: Data store is not a RedisString type.";
-            session->send(std::move("-ERR operation against a key holding the wrong kind of value\r\n"));
-            return;
-        }
-        auto value = redisString->get({command[1]});
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
+        auto value = redisString->get(command[1]);
         if ( value != nullptr ) {
             //DebugL << "Found value for key " << command[1] << ": " << value;
-            session->send(std::move("$" + std::to_string(value->size()) + "\r\n" + (*value) + "\r\n"));
+            session->send(RespWriter(RespWriter::bulkLength(value->size())).bulk(*value).buffer());
+        } else {
+            session->send(SharedReply::nil());
+        }
+    }
+    void executeShared(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        auto value = redisHelper_->getStringShared(dbIndex, command[1]);
+        if (value != nullptr) {
+            session->send(RespWriter(RespWriter::bulkLength(value->size())).bulk(*value).buffer());
         } else {
-            session->send(std::move("$-1\r\n"));
+            session->send(SharedReply::nil());
         }
     }
+
 };
 // STRLEN 命令解析器
-class StrlenParser : public CommandParser {
+class StrlenParser : public TypedParser<StrlenParser, RedisString> {
 public:
     explicit StrlenParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool readOnly() const override {
+        return true;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if(command.size() != 2) {
             //DebugL << "Invalid STRLEN command.";
             session->send("-ERR wrong number of arguments for 'strlen' command\r\n");
@@ -121,58 +517,100 @@ private:
     }
 
     // 执行 STRLEN 命令的逻辑
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换
-        auto redisString = std::dynamic_pointer_cast<RedisString>(dataStore);
-        if (!redisString) {
-            //DebugL << "Error: Data store is not a RedisString type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
         // 获取字符串长度
-        auto value = redisString->get({command[1]});
+        auto value = redisString->get(command[1]);
         if (value != nullptr) {
             //DebugL << "Found value for key " << command[1] << ": " << *value;
-            session->send(":" + std::to_string(value->size()) + "\r\n");
+            session->send(SharedReply::integer(value->size()));
         } else {
-            session->send(":0\r\n");  // 如果不存在该键，返回 0
+            session->send(SharedReply::integer(0));  // 如果不存在该键，返回 0
         }
     }
+    void executeShared(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        auto value = redisHelper_->getStringShared(dbIndex, command[1]);
+        session->send(SharedReply::integer(value ? value->size() : 0));
+    }
+
 };
 // COMMAND 命令解析器
+// COMMAND / COMMAND COUNT / COMMAND INFO name... / COMMAND DOCS，内容来自 CommandTable
 class CommandParserCommand : public CommandParser {
 public:
     explicit CommandParserCommand(std::shared_ptr<RedisHelper> redisHelper)
         : CommandParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
-        if (command.size() != 1) {
-            //DebugL << "Invalid COMMAND command.";
-            session->send("-ERR wrong number of arguments for 'COMMAND' command\r\n");
-            return false;
+    Route route() const override {
+        return ROUTE_LOCAL;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() == 1) {
+            return true;
         }
-        return true;
+        auto sub = command[1];
+        if ((sub.equalsIgnoreCase("COUNT") && command.size() == 2) || sub.equalsIgnoreCase("INFO") || sub.equalsIgnoreCase("DOCS")) {
+            return true;
+        }
+        session->send("-ERR unknown subcommand or wrong number of arguments for 'COMMAND' command\r\n");
+        return false;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 构建 RESP 格式响应
-        std::ostringstream response;
-        response << "*" << commandMaps.size() << "\r\n";
-
-        for (const auto &[cmd, enumVal] : commandMaps) {
-            response << "*6\r\n";                 // 每个命令包含 6 部分
-            response << "$" << cmd.size() << "\r\n" << cmd << "\r\n"; // 命令名称
-            response << ":-1\r\n";                // 参数数量 -1 表示变长参数
-            response << "*1\r\n$5\r\nwrite\r\n"; // 默认标志为 write
-            response << ":1\r\n";                 // 第一个键位置
-            response << ":1\r\n";                 // 最后一个键位置
-            response << ":1\r\n";                 // 步长
+    // 一条命令的描述：名称、参数个数、标志、第一个键、最后一个键、步长
+    static void writeSpec(RespWriter &response, const CommandSpec &spec) {
+        static const std::pair<uint32_t, const char *> kFlagNames[] = {
+            {CMD_WRITE, "write"}, {CMD_READONLY, "readonly"}, {CMD_DENYOOM, "denyoom"}, {CMD_ADMIN, "admin"},
+            {CMD_FAST, "fast"}
+        };
+        size_t flagCount = 0;
+        for (auto &flag : kFlagNames) {
+            flagCount += (spec.flags & flag.first) ? 1 : 0;
+        }
+        response.array(6);
+        response.bulk(spec.name, strlen(spec.name));
+        response.integer(spec.arity);
+        response.array(flagCount);
+        for (auto &flag : kFlagNames) {
+            if (spec.flags & flag.first) {
+                response.status(flag.second);
+            }
         }
+        response.integer(spec.firstKey);
+        response.integer(spec.lastKey);
+        response.integer(spec.keyStep);
+    }
 
-        session->send(response.str());
-        //DebugL << "Sent COMMAND response.";
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        if (command.size() == 1) {
+            RespWriter response(RespWriter::arrayLength(CommandTable::kCount) + CommandTable::kCount * 64);
+            response.array(CommandTable::kCount);
+            for (auto &spec : CommandTable::kCommands) {
+                writeSpec(response, spec);
+            }
+            session->send(response.buffer());
+            return;
+        }
+        auto sub = command[1];
+        if (sub.equalsIgnoreCase("COUNT")) {
+            session->send(SharedReply::integer(CommandTable::kCount));
+            return;
+        }
+        if (sub.equalsIgnoreCase("DOCS")) {
+            session->send(SharedReply::emptyArray());
+            return;
+        }
+        // COMMAND INFO name...，未知命令对应 nil
+        size_t count = command.size() - 2;
+        RespWriter response(RespWriter::arrayLength(count) + count * 64);
+        response.array(count);
+        for (size_t i = 2; i < command.size(); ++i) {
+            if (auto spec = CommandTable::lookup(command[i])) {
+                writeSpec(response, *spec);
+            } else {
+                response.nil();
+            }
+        }
+        session->send(response.buffer());
     }
 };
 
@@ -182,18 +620,35 @@ public:
     explicit SelectParser(std::shared_ptr<RedisHelper> redisHelper) 
         :CommandParser(std::move(redisHelper)) {}
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    Route route() const override {
+        return ROUTE_LOCAL;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if(command.size() != 2) {
             //DebugL << "Invalid SELECT command.";
             session->send("-ERR wrong number of arguments for 'sellect' command\r\n");
             return false;
         }
+        const std::string arg = command[1];
+        char *end = nullptr;
+        long dbIndex = strtol(arg.c_str(), &end, 10);
+        if (arg.empty() || *end != '\0') {
+            session->send("-ERR value is not an integer or out of range\r\n");
+            return false;
+        }
+        if (!RedisHelper::isValidDb(dbIndex)) {
+            session->send("-ERR DB index is out of range\r\n");
+            return false;
+        }
+        // 数据库是会话自身的状态，在 poller 线程中立即切换，之后入队的命令都作用于新库；
+        // 事务中的 SELECT 只入队，由 EXEC 按顺序生效（见 ExecParser），DISCARD 或放弃执行的事务不改变数据库
+        if (!session->getTransactionContext().isTransactionActive()) {
+            session->setDbIndex(static_cast<int>(dbIndex));
+        }
         return true;
     }
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        int dbIndex = std::stoi(command[1]);
-        redisHelper_->selectDatabase(dbIndex);
-        session->send("+OK\r\n");
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        session->send(SharedReply::ok());
         //DebugL << "Jump to db [" << dbIndex << "]";
     }
 };
@@ -205,7 +660,10 @@ public:
         :CommandParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    Route route() const override {
+        return ROUTE_FANOUT;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if(command.size() != 2) {
             //DebugL << "Invalid KEYS command.";
             session->send("-ERR wrong number of arguments for 'keys' command\r\n");
@@ -213,20 +671,97 @@ private:
         }
         return true;
     }
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
         const std::string &pattern = command[1];
 
         // 获取所有匹配的键
-        auto matched_keys = redisHelper_->keys(pattern);
+        std::vector<std::vector<std::string>> matched_keys;
+        matched_keys.emplace_back(redisHelper_->keys(dbIndex, pattern));
+        session->send(buildReply(matched_keys));
+        //DebugL << "Found " << matched_keys.size() << " keys matching pattern: " << pattern;
+    }
+
+    void fanout(const CmdDesc::Ptr &cmd) override {
+        auto dbIndex = cmd->dbIndex;
+        auto matched = std::make_shared<std::vector<std::vector<std::string>>>(ShardRouter::Instance().shardCount());
+        auto reply = replyFanout(cmd->session);
+        ShardRouter::Instance().scatter(allShards(), [this, cmd, matched, dbIndex](size_t shard) {
+            (*matched)[shard] = redisHelper_->keys(dbIndex, cmd->args[1]);
+        }, [matched, reply]() {
+            reply(buildReply(*matched));
+        }, failFanout(reply));
+    }
 
-        // 构建返回响应
-        std::string response = "*" + std::to_string(matched_keys.size()) + "\r\n";
-        for (const auto &key : matched_keys) {
-            response += "$" + std::to_string(key.size()) + "\r\n" + key + "\r\n";
+    // 构建返回响应，各分片的结果依次拼接
+    static Buffer::Ptr buildReply(const std::vector<std::vector<std::string>> &matched) {
+        size_t count = 0, length = 0;
+        for (auto &keys : matched) {
+            count += keys.size();
+            for (const auto &key : keys) {
+                length += RespWriter::bulkLength(key.size());
+            }
+        }
+        RespWriter response(RespWriter::arrayLength(count) + length);
+        response.array(count);
+        for (auto &keys : matched) {
+            for (const auto &key : keys) {
+                response.bulk(key);
+            }
         }
+        return response.buffer();
+    }
+};
 
-        session->send(response);
-        //DebugL << "Found " << matched_keys.size() << " keys matching pattern: " << pattern;
+// SCAN cursor [MATCH pattern] [COUNT count] [TYPE type]
+// 按反向二进制游标分批遍历键空间（见 Dict::scan），每次调用只访问有限个桶，不会像 KEYS 一样长时间阻塞执行线程。
+// 分片模式与多执行线程模式下游标还记录分片：cursor = 桶游标 * 分片数 + 分片，依次遍历各分片，每次调用只在一个分片上执行
+class ScanParser : public CommandParser {
+public:
+    explicit ScanParser(std::shared_ptr<RedisHelper> redisHelper)
+        : CommandParser(std::move(redisHelper)) {}
+
+private:
+    Route route() const override {
+        return ROUTE_FANOUT;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() < 2) {
+            session->send("-ERR wrong number of arguments for 'scan' command\r\n");
+            return false;
+        }
+        ScanArgs args;
+        return parseScanArgs(command, 1, true, args, session);
+    }
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        ScanArgs args;
+        if (!parseScanArgs(command, 1, true, args, session)) {
+            return;
+        }
+        auto shards = std::max<size_t>(RedisConfig::Instance().shardCount, 1);
+        auto shard = args.cursor % shards;
+        std::vector<std::string> keys;
+        auto next = redisHelper_->scan(dbIndex, args.cursor / shards, args.count,
+                                       [&](const std::string &key, const RedisObject &obj) {
+            if (args.type && !args.type->equalsIgnoreCase(RedisObject::typeName(obj.type()))) {
+                return;
+            }
+            if (scanMatch(args, key)) {
+                keys.push_back(key);
+            }
+        });
+        // 本分片遍历结束后从下一个分片的开头继续
+        auto cursor = next ? next * shards + shard : (shard + 1 < shards ? shard + 1 : 0);
+        session->send(scanReply(cursor, keys));
+    }
+    void fanout(const CmdDesc::Ptr &cmd) override {
+        ScanArgs args;
+        if (!parseScanArgs(cmd->args, 1, true, args, cmd->session)) {
+            return;
+        }
+        auto &router = ShardRouter::Instance();
+        router.execute(args.cursor % router.shardCount(), cmd->session, [cmd, this]() {
+            this->execute(cmd->args, cmd->session, cmd->dbIndex);
+        });
     }
 };
 
@@ -237,8 +772,11 @@ public:
         : CommandParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
-        if(command.size() != 2) {
+    Route route() const override {
+        return ROUTE_FANOUT;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
+        if(command.size() < 2) {
             //DebugL << "Invalid DEL command.";
             session->send("-ERR wrong number of arguments for 'del' command\r\n");
             return false;
@@ -246,15 +784,35 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session,RedisDataType::Ptr dataStore) override {
-        bool deleted = redisHelper_->eraseKey(command[1]);
-        if (deleted) {
-            //DebugL << "Deleted key: " << command[1];
-            session->send(":1\r\n");
-        } else {
-            //DebugL << "Key not found: " << command[1];
-            session->send(":0\r\n");
+    // 返回删除的键个数
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        int deleted = 0;
+        for (size_t i = 1; i < command.size(); ++i) {
+            deleted += redisHelper_->eraseKey(dbIndex, command[i]);
         }
+        session->send(SharedReply::integer(deleted));
+    }
+
+    void fanout(const CmdDesc::Ptr &cmd) override {
+        auto dbIndex = cmd->dbIndex;
+        auto groups = std::make_shared<std::vector<std::vector<size_t>>>();
+        auto shards = groupByShard(cmd->args, 1, 1, *groups);
+        auto counts = std::make_shared<std::vector<int>>(groups->size(), 0);
+        auto reply = replyFanout(cmd->session);
+        // 各分片全部完成、分发的任务释放后多键写才结束
+        auto scope = std::make_shared<AtomicWrites::Scope>();
+        ShardRouter::Instance().scatter(shards, [this, cmd, groups, counts, dbIndex, scope](size_t shard) {
+            for (auto i : (*groups)[shard]) {
+                (*counts)[shard] += redisHelper_->eraseKey(dbIndex, cmd->args[i]);
+                redisHelper_->touchKey(dbIndex, cmd->args[i]);
+            }
+        }, [counts, reply]() {
+            int deleted = 0;
+            for (auto count : *counts) {
+                deleted += count;
+            }
+            reply(SharedReply::integer(deleted));
+        }, failFanout(reply));
     }
 };
 
@@ -265,7 +823,10 @@ public:
         : CommandParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    bool readOnly() const override {
+        return true;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if(command.size() != 2) {
             //DebugL << "Invalid EXISTS command.";
             session->send("-ERR wrong number of arguments for 'exists' command\r\n");
@@ -273,20 +834,27 @@ private:
         }
         return true;
     }
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto exists = redisHelper_->exists(command[1]);
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        auto exists = redisHelper_->exists(dbIndex, command[1]);
         //DebugL << "Exists check for key: " << command[1] << ", result: " << exists;
-        session->send(":" + std::to_string(exists ? 1 : 0) + "\r\n");
+        session->send(SharedReply::integer(exists ? 1 : 0));
     }
+    void executeShared(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        auto exists = redisHelper_->lookupShared(dbIndex, command[1]) != nullptr;
+        session->send(SharedReply::integer(exists ? 1 : 0));
+    }
+
 };
 
 // INCR 命令解析器
-class IncrParser : public CommandParser {
+class IncrParser : public TypedParser<IncrParser, RedisString> {
 public:
     explicit IncrParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if(command.size() != 2) {
             //DebugL << "Invalid INCR command.";
             session->send("-ERR wrong number of arguments for 'incr' command\r\n");
@@ -295,31 +863,21 @@ private:
         return true;
     }  
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换
-        auto redisString = std::dynamic_pointer_cast<RedisString>(dataStore);
-        if(!redisString) {
-            //DebugL << "Error: Data store is not a RedisString type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
-        auto value = redisString->get({command[1]});
-        int new_value = value ? std::stoi(*value) + 1 : 1;
-        redisString->insert({command[1] ,std::to_string(new_value)});
-        //DebugL << "Incremented key: " << command[1] << " to value: " << new_value;
-        session->send(":" + std::to_string(new_value) + "\r\n");
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
+        incrementBy(redisString, command[1], 1, session);
     }
 };
 
 // DECR 命令解析器
-class DecrParser : public CommandParser {
+class DecrParser : public TypedParser<DecrParser, RedisString> {
 public:
     explicit DecrParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if(command.size() != 2) {
             //DebugL << "Invalid INCR command.";
             session->send("-ERR wrong number of arguments for 'incr' command\r\n");
@@ -328,31 +886,21 @@ private:
         return true;
     }  
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换
-        auto redisString = std::dynamic_pointer_cast<RedisString>(dataStore);
-        if(!redisString) {
-            //DebugL << "Error: Data store is not a RedisString type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
-        auto value = redisString->get({command[1]});
-        int new_value = value ? std::stoi(*value) - 1 : 1;
-        redisString->insert({command[1] ,std::to_string(new_value)});
-        //DebugL << "Decremented key: " << command[1] << " to value: " << new_value;
-        session->send(":" + std::to_string(new_value) + "\r\n");
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
+        incrementBy(redisString, command[1], -1, session);
     }
 };
 
 // APPEND 命令解析器
-class AppendParser : public CommandParser {
+class AppendParser : public TypedParser<AppendParser, RedisString> {
 public:
     explicit AppendParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         // APPEND 命令需要两个参数：命令名和键，键对应的值
         if (command.size() != 3) {
             //DebugL << "Invalid APPEND command.";
@@ -363,42 +911,40 @@ private:
     }
 
     // 执行 APPEND 命令的逻辑
-    void executeCommand(const std::vector<std::string>& command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换，将 dataStore 转换为 RedisString 类型
-        auto redisString = std::dynamic_pointer_cast<RedisString>(dataStore);
-        if (!redisString) {
-            //DebugL << "Error: Data store is not a RedisString type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
         // 获取键当前的值，如果不存在则返回空字符串
-        auto currentValue = redisString->get({command[1]});
+        auto currentValue = redisString->get(command[1]);
         
         // 如果值存在，则将新值追加到现有值的末尾
         if (currentValue != nullptr) {
-            std::string newValue = *currentValue + command[2];
-            redisString->insert({command[1], newValue});
+            std::string newValue = *currentValue;
+            newValue.append(command[2].data(), command[2].size());
+            redisString->update(command[1], std::move(newValue));
             //DebugL << "Appended to key: " << command[1] << " new value: " << newValue;
         } else {
             // 如果键不存在，将该值设置为传入的值
-            redisString->insert({command[1], command[2]});
+            redisString->set(command[1], command[2]);
             //DebugL << "Set new key: " << command[1] << " to value: " << command[2];
         }
 
         // 返回追加后的字符串长度
-        session->send(":" + std::to_string(command[1].size() + command[2].size()) + "\r\n");
+        session->send(SharedReply::integer(command[1].size() + command[2].size()));
     }
 };
 
 // MSET 命令解析器
-class MSetParser : public CommandParser {
+class MSetParser : public TypedParser<MSetParser, RedisString> {
 public:
     explicit MSetParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    friend TypedParser;
+
+    Route route() const override {
+        return ROUTE_FANOUT;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() < 3 || command.size() % 2 == 0) {
             //DebugL << "Invalid MSET command.";
             session->send("-ERR wrong number of arguments for 'mset' command\r\n");
@@ -406,31 +952,56 @@ private:
         }
         return true;
     }
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换
-        auto redisString = std::dynamic_pointer_cast<RedisString>(dataStore);
-        if (!redisString) {
-            //DebugL << "Error: Data store is not a RedisString type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
         for (size_t i = 1; i < command.size(); i += 2) {
-            redisString->insert({command[i],command[i+1]});
+            redisString->set(command[i], command[i + 1]);
             //DebugL << "Inserted key: " << command[i] << " with value: " << command[i + 1];
         }
         
-        session->send("+OK\r\n");
+        session->send(SharedReply::ok());
+    }
+    void fanout(const CmdDesc::Ptr &cmd) override {
+        auto dbIndex = cmd->dbIndex;
+        auto groups = std::make_shared<std::vector<std::vector<size_t>>>();
+        auto shards = groupByShard(cmd->args, 1, 2, *groups);
+        auto reply = replyFanout(cmd->session);
+        // 已用内存是全局的：noeviction 下超出即拒绝；其它策略由各分片先淘汰自己的键，各分片的写入不能部分拒绝
+        auto &config = RedisConfig::Instance();
+        if (config.maxmemory && config.maxmemoryPolicy == EVICT_NOEVICTION && UsedMemory::get() > config.maxmemory) {
+            reply(SharedReply::oom());
+            return;
+        }
+        // 各分片全部完成、分发的任务释放后多键写才结束
+        auto scope = std::make_shared<AtomicWrites::Scope>();
+        ShardRouter::Instance().scatter(shards, [this, cmd, groups, dbIndex, scope](size_t shard) {
+            redisHelper_->performEvictions();
+            auto redisString = &redisHelper_->store<RedisString>(dbIndex);
+            for (auto i : (*groups)[shard]) {
+                redisString->set(cmd->args[i], cmd->args[i + 1]);
+                redisHelper_->touchKey(dbIndex, cmd->args[i]);
+            }
+        }, [reply]() {
+            reply(SharedReply::ok());
+        }, failFanout(reply));
     }
 };
 
 // MGET 命令解析器
-class MGetParser : public CommandParser {
+class MGetParser : public TypedParser<MGetParser, RedisString> {
 public:
     explicit MGetParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool readOnly() const override {
+        return true;
+    }
+    Route route() const override {
+        return ROUTE_FANOUT;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() < 2 ) {
             //DebugL << "Invalid MGET command.";
             session->send("-ERR wrong number of arguments for 'mget' command\r\n");
@@ -438,35 +1009,98 @@ private:
         }
         return true;
     }
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisString = std::dynamic_pointer_cast<RedisString>(dataStore);
-        if (!redisString) {
-            //DebugL << "Error: Data store is not a RedisString type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-        std::string response = "*" + std::to_string(command.size() - 1) + "\r\n";
+    // 与 Redis 相同，不是字符串的键回复 nil，不会使整个命令失败
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
+        // 先取出所有值，按实际长度一次分配回复缓存
+        std::vector<const std::string *> values;
+        values.reserve(command.size() - 1);
+        size_t length = RespWriter::arrayLength(command.size() - 1);
         for (size_t i = 1; i < command.size(); ++i) {
-            auto value = redisString->get({command[i]});
+            values.emplace_back(redisString->find(command[i]));
+            length += values.back() ? RespWriter::bulkLength(values.back()->size()) : 5;
+        }
+        RespWriter response(length);
+        response.array(values.size());
+        for (auto &value : values) {
             if (value) {
-                response += "$" + std::to_string(value->size()) + "\r\n" + *value + "\r\n";
+                response.bulk(*value);
             } else {
-                response += "$-1\r\n";
+                response.nil();
             }
         }
-        session->send(response);
+        session->send(response.buffer());
         //DebugL << "MGET response sent for keys: " << command.size() - 1;
     }
+    // poller 线程中直接读取所有键，不需要按分片拆分
+    void executeShared(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        std::vector<const std::string *> values;
+        values.reserve(command.size() - 1);
+        size_t length = RespWriter::arrayLength(command.size() - 1);
+        for (size_t i = 1; i < command.size(); ++i) {
+            values.emplace_back(redisHelper_->findStringShared(dbIndex, command[i]));
+            length += values.back() ? RespWriter::bulkLength(values.back()->size()) : 5;
+        }
+        RespWriter response(length);
+        response.array(values.size());
+        for (auto &value : values) {
+            if (value) {
+                response.bulk(*value);
+            } else {
+                response.nil();
+            }
+        }
+        session->send(response.buffer());
+    }
+    // 各分片把值拷贝到各自键对应的位置（值所在的键空间只能由所属分片访问），全部完成后按原顺序回复
+    void fanout(const CmdDesc::Ptr &cmd) override {
+        auto dbIndex = cmd->dbIndex;
+        struct Result {
+            std::vector<std::string> values;
+            std::vector<char> found;
+        };
+        auto groups = std::make_shared<std::vector<std::vector<size_t>>>();
+        auto shards = groupByShard(cmd->args, 1, 1, *groups);
+        auto result = std::make_shared<Result>();
+        result->values.resize(cmd->args.size());
+        result->found.resize(cmd->args.size(), 0);
+        auto reply = replyFanout(cmd->session);
+        ShardRouter::Instance().scatter(shards, [this, cmd, groups, result, dbIndex](size_t shard) {
+            auto redisString = &redisHelper_->store<RedisString>(dbIndex);
+            for (auto i : (*groups)[shard]) {
+                if (auto value = redisString->find(cmd->args[i])) {
+                    result->values[i] = *value;
+                    result->found[i] = 1;
+                }
+            }
+        }, [cmd, result, reply]() {
+            size_t length = RespWriter::arrayLength(cmd->args.size() - 1);
+            for (size_t i = 1; i < cmd->args.size(); ++i) {
+                length += result->found[i] ? RespWriter::bulkLength(result->values[i].size()) : 5;
+            }
+            RespWriter response(length);
+            response.array(cmd->args.size() - 1);
+            for (size_t i = 1; i < cmd->args.size(); ++i) {
+                if (result->found[i]) {
+                    response.bulk(result->values[i]);
+                } else {
+                    response.nil();
+                }
+            }
+            reply(response.buffer());
+        }, failFanout(reply));
+    }
 };
 
 // HMSET 命令解析器
-class HMSetParser : public CommandParser {
+class HMSetParser : public TypedParser<HMSetParser, RedisHash> {
 public:
     explicit HMSetParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() < 3 || command.size() % 2 == 1) {
             //DebugL << "Invalid HMSET command.";
             session->send("-ERR wrong number of arguments for 'hmset' command\r\n");
@@ -474,30 +1108,25 @@ private:
         }
         return true;
     }
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换
-        auto redisHash = std::dynamic_pointer_cast<RedisHash>(dataStore);
-        if(!redisHash) {
-            //DebugL << "Error: Data store is not a RedisHash type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisHash *redisHash, int dbIndex) {
         for (size_t i = 2; i < command.size(); i += 2) {
             redisHash->hset(command[1],command[i],command[i+1]);
             //DebugL << "Inserted field: " << command[i] << " with value: " << command[i + 1];
         }
 
-        session->send("+OK\r\n");
+        session->send(SharedReply::ok());
     }
 };
 // HMGET 命令解析器
-class HMGetParser : public CommandParser {
+class HMGetParser : public TypedParser<HMGetParser, RedisHash> {
 public:
     explicit HMGetParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() < 3 ) {
             //DebugL << "Invalid HMGET command.";
             session->send("-ERR wrong number of arguments for 'hmget' command. At least one field is required\r\n");
@@ -505,38 +1134,38 @@ private:
         }
         return true;
     }
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换
-        auto redisHash = std::dynamic_pointer_cast<RedisHash>(dataStore);
-        if(!redisHash) {
-            //DebugL << "Error: Data store is not a RedisHash type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
-        std::ostringstream response;
-        response << "*" << (command.size() - 2) << "\r\n";
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisHash *redisHash, int dbIndex) {
+        std::vector<const std::string *> values;
+        values.reserve(command.size() - 2);
+        size_t length = RespWriter::arrayLength(command.size() - 2);
         for (size_t i = 2; i < command.size(); ++i) {
-            auto value = redisHash->hget(command[1], command[i]);
+            values.emplace_back(redisHash->hget(command[1], command[i]));
+            length += values.back() ? RespWriter::bulkLength(values.back()->size()) : 5;
+        }
+        RespWriter response(length);
+        response.array(values.size());
+        for (auto &value : values) {
             if (value) {
-                response << "$" << value->size() << "\r\n" << *value << "\r\n";
+                response.bulk(*value);
             } else {
-                response << "$-1\r\n";
+                response.nil();
             }
         }
-        session->send(response.str());
+        session->send(response.buffer());
         //DebugL << "HMGET response sent for keys: " << command.size() - 2;
     }
 };
 
 // HSET 命令解析器
-class HSetParser : public CommandParser {
+class HSetParser : public TypedParser<HSetParser, RedisHash> {
 public:
     explicit HSetParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if(command.size() != 4) {
             //DebugL << "Invalid HSET command.";
             session->send("-ERR wrong number of arguments for 'hset' command\r\n");
@@ -545,28 +1174,23 @@ private:
         return true;
     }  
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换
-        auto redisHash = std::dynamic_pointer_cast<RedisHash>(dataStore);
-        if(!redisHash) {
-            //DebugL << "Error: Data store is not a RedisHash type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisHash *redisHash, int dbIndex) {
         redisHash->hset(command[1],command[2],command[3]);
         //DebugL << "hset key: " << command[1] << " to value: " << command[2] << ": "<< command[3];
-        session->send("+OK\r\n");
+        session->send(SharedReply::ok());
     }
 };
 
 // HGET 命令解析器
-class HGetParser : public CommandParser {
+class HGetParser : public TypedParser<HGetParser, RedisHash> {
 public:
     explicit HGetParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if(command.size() != 3) {
             //DebugL << "Invalid HGET command.";
             session->send("-ERR wrong number of arguments for 'hget' command\r\n");
@@ -575,19 +1199,12 @@ private:
         return true;
     }  
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换
-        auto redisHash = std::dynamic_pointer_cast<RedisHash>(dataStore);
-        if(!redisHash) {
-            //DebugL << "Error: Data store is not a RedisHash type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisHash *redisHash, int dbIndex) {
         auto value = redisHash->hget(command[1],command[2]);
         if (value) {
-            session->send("$" + std::to_string(value->size()) + "\r\n" + *value + "\r\n");
+            session->send(RespWriter(RespWriter::bulkLength(value->size())).bulk(*value).buffer());
         } else {
-            session->send("$-1\r\n");
+            session->send(SharedReply::nil());
         }
         //DebugL << "HGET response sent for field: " << command[2];
     }
@@ -595,13 +1212,15 @@ private:
 };
 
 // HDEL 命令解析器
-class HDelParser : public CommandParser {
+class HDelParser : public TypedParser<HDelParser, RedisHash> {
 public:
     explicit HDelParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if (command.size() < 3) {
             //DebugL << "Invalid HDEL command.";
             session->send("-ERR wrong number of arguments for 'hdel' command\r\n");
@@ -609,32 +1228,28 @@ private:
         }
         return true;
     }  
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisHash = std::dynamic_pointer_cast<RedisHash>(dataStore);
-        if(!redisHash) {
-            //DebugL << "Error: Data store is not a RedisHash type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisHash *redisHash, int dbIndex) {
         bool deleted = redisHash->hdel(command[1], command[2]);
         if (deleted) {
             //DebugL << "Deleted field: " << command[2];
-            session->send(":1\r\n");
+            session->send(SharedReply::integer(1));
         } else {
             //DebugL << "Field not found: " << command[2];
-            session->send(":0\r\n");
+            session->send(SharedReply::integer(0));
         }
     }
 };
 
 // HGETALL
-class HGetAllParser : public CommandParser {
+class HGetAllParser : public TypedParser<HGetAllParser, RedisHash> {
 public:
     explicit HGetAllParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         // HGETALL 命令需要两个参数，第一个是命令名，第二个是哈希表的键
         if (command.size() != 2) {
             //DebugL << "Invalid HGETALL command.";
@@ -644,41 +1259,76 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string>& command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        // 动态类型转换，将 dataStore 转换为 RedisHash 类型
-        auto redisHash = std::dynamic_pointer_cast<RedisHash>(dataStore);
-        if (!redisHash) {
-            //DebugL << "Error: Data store is not a RedisHash type.";
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisHash *redisHash, int dbIndex) {
         // 获取指定键的所有字段和值
         auto allFields = redisHash->hgetall(command[1]);
         if (allFields.empty()) {
             // 如果没有找到字段，返回空的哈希
-            session->send("*0\r\n");
+            session->send(SharedReply::emptyArray());
         } else {
             // 格式化返回值为 Redis 响应格式
-            std::string response = "*" + std::to_string(allFields.size() * 2) + "\r\n"; // 每个字段和值一对，共2个元素
+            size_t length = RespWriter::arrayLength(allFields.size() * 2);
+            for (const auto& fieldValuePair : allFields) {
+                length += RespWriter::bulkLength(fieldValuePair.first.size()) + RespWriter::bulkLength(fieldValuePair.second.size());
+            }
+            RespWriter response(length);
+            response.array(allFields.size() * 2);    // 每个字段和值一对，共2个元素
             for (const auto& fieldValuePair : allFields) {
-                response += "$" + std::to_string(fieldValuePair.first.size()) + "\r\n" + fieldValuePair.first + "\r\n";
-                response += "$" + std::to_string(fieldValuePair.second.size()) + "\r\n" + fieldValuePair.second + "\r\n";
+                response.bulk(fieldValuePair.first).bulk(fieldValuePair.second);
             }
-            session->send(response);
+            session->send(response.buffer());
         }
         //DebugL << "HGETALL response sent for key: " << command[1];
     }
 };
 
+// HSCAN key cursor [MATCH pattern] [COUNT count]，MATCH 只匹配字段名
+class HScanParser : public TypedParser<HScanParser, RedisHash> {
+public:
+    explicit HScanParser(std::shared_ptr<RedisHelper> redisHelper)
+        : TypedParser(std::move(redisHelper)) {}
+
+private:
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() < 3) {
+            session->send("-ERR wrong number of arguments for 'hscan' command\r\n");
+            return false;
+        }
+        ScanArgs args;
+        return parseScanArgs(command, 2, false, args, session);
+    }
+
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisHash *redisHash, int dbIndex) {
+        ScanArgs args;
+        if (!parseScanArgs(command, 2, false, args, session)) {
+            return;
+        }
+        std::vector<std::pair<std::string, std::string>> fields;
+        auto cursor = redisHash->hscan(command[1], args.cursor, args.count, fields);
+        std::vector<std::string> items;
+        items.reserve(fields.size() * 2);
+        for (auto &field : fields) {
+            if (scanMatch(args, field.first)) {
+                items.push_back(std::move(field.first));
+                items.push_back(std::move(field.second));
+            }
+        }
+        session->send(scanReply(cursor, items));
+    }
+};
+
 // INCRBY 命令解析器
-class IncrByParser : public CommandParser {
+class IncrByParser : public TypedParser<IncrByParser, RedisString> {
 public:
     explicit IncrByParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() != 3) {
             //DebugL << "Invalid INCRBY command.";
             session->send("-ERR wrong number of arguments for 'incrby' command\r\n");
@@ -686,27 +1336,26 @@ private:
         }
         return true;
     }
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisString = std::dynamic_pointer_cast<RedisString>(dataStore);
-
-        int increment = std::stoi(command[2]);
-        auto value = redisString->get({command[1]});
-        int new_value = value ? std::stoi(*value) + increment : increment;
-        redisString->insert({command[1], std::to_string(new_value)});
-
-        session->send(":" + std::to_string(new_value) + "\r\n");
-        //DebugL << "Incremented key: " << command[1] << " to value: " << new_value;
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
+        int64_t increment = 0;
+        if (!parseInteger(command[2], increment)) {
+            session->send("-ERR value is not an integer or out of range\r\n");
+            return;
+        }
+        incrementBy(redisString, command[1], increment, session);
     }
 };
 
 // DECRBY 命令解析器
-class DecrByParser : public CommandParser {
+class DecrByParser : public TypedParser<DecrByParser, RedisString> {
 public:
     explicit DecrByParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() != 3) {
             //DebugL << "Invalid DECRBY command.";
             session->send("-ERR wrong number of arguments for 'decrby' command\r\n");
@@ -714,20 +1363,19 @@ private:
         }
         return true;
     }
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisString = std::dynamic_pointer_cast<RedisString>(dataStore);
-
-        int decrement = std::stoi(command[2]);
-        auto value = redisString->get({command[1]});
-        int new_value = value ? std::stoi(*value) - decrement : -decrement;
-        redisString->insert({command[1], std::to_string(new_value)});
-
-        session->send(":" + std::to_string(new_value) + "\r\n");
-        //DebugL << "Decremented key: " << command[1] << " to value: " << new_value;
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
+        int64_t decrement = 0;
+        if (!parseInteger(command[2], decrement) || decrement == INT64_MIN) {
+            session->send("-ERR value is not an integer or out of range\r\n");
+            return;
+        }
+        incrementBy(redisString, command[1], -decrement, session);
     }
 };
 
 // MULTI 事务命令解析器
+// 事务状态是会话自身的状态，MULTI/EXEC/DISCARD 与 SELECT 一样在 poller 线程的 parserCommand 中修改，
+// 之后到达的命令按新的状态入队
 // MultiParser
 class MultiParser : public CommandParser {
 public:
@@ -735,61 +1383,161 @@ public:
         : CommandParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    Route route() const override {
+        return ROUTE_LOCAL;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() != 1) {
             session->send("-ERR wrong number of arguments for 'multi' command\r\n");
             return false;
         }
-        return true;
-    }
-
-    void executeCommand(const std::vector<std::string>& command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        //auto redisSession = std::dynamic_pointer_cast<RedisSession>(session);
         auto& transactionContext = session->getTransactionContext();
         if (transactionContext.isTransactionActive()) {
             session->send("-ERR MULTI calls can't be nested\r\n");
-            return;
+            return false;
         }
-
         transactionContext.startTransaction();
-        session->send("+OK\r\n");
+        return true;
+    }
+
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        session->send(SharedReply::ok());
     }
 };
 
 // ExecParser
+// 整个事务作为一个任务在执行线程中执行：先比较 WATCH 的键的版本号，再依次执行事务中的命令，
+// 捕获它们的回复拼成一个数组一次发出。执行期间不会穿插其它命令，也只排队一次。
+// 启用分片路由时事务独占它访问的所有分片（含 WATCH 的键所属分片，见 ShardRouter::exclusive），
+// 只涉及一个分片时就在该分片上执行，跨分片时涉及的分片全部停下，由其中一个线程执行整个事务。
 class ExecParser : public CommandParser {
 public:
     explicit ExecParser(std::shared_ptr<RedisHelper> redisHelper)
         : CommandParser(std::move(redisHelper)) {}
 
+    void parserAndExecuter(const CmdDesc::Ptr &cmd) override {
+        auto &session = cmd->session;
+        if (!parserCommand(cmd->args, session)) {
+            return;
+        }
+        auto& transactionContext = session->getTransactionContext();
+        auto dirty = transactionContext.isDirty();
+        auto batch = transactionContext.endWatchBatch();
+        auto commands = std::make_shared<std::vector<CmdDesc::Ptr>>(transactionContext.takeTransactionQueue());
+        transactionContext.endTransaction();
+
+        // 按顺序应用事务中的 SELECT，确定各命令的数据库与事务执行后会话所在的数据库
+        auto dbIndex = session->getDbIndex();
+        bool selects = false;
+        for (auto &queued : *commands) {
+            if (queued->spec->id == SELECT) {
+                int64_t value = 0;
+                parseInteger(queued->args[1], value);   // 入队时已检查
+                dbIndex = static_cast<int>(value);
+                selects = true;
+            }
+            queued->dbIndex = dbIndex;
+        }
+        selects = selects && !dirty;
+        if (selects) {
+            // 事务可能因 WATCH 的键被修改而放弃，执行完之前不知道之后的命令该用哪个数据库：
+            // 暂停分发该会话之后的命令，事务执行完毕后回到 poller 线程切换数据库（仅当事务执行了）再继续
+            session->holdCommands();
+        }
+        auto task = [this, session, commands, dirty, batch, selects, dbIndex]() {
+            bool executed = false;
+            onceToken token(nullptr, [&executed, session, selects, dbIndex]() {
+                if (!selects) {
+                    return;
+                }
+                session->getPoller()->async([session, executed, dbIndex]() {
+                    if (executed) {
+                        session->setDbIndex(dbIndex);
+                    }
+                    session->resumeCommands();
+                }, false);
+            });
+            executed = runTransaction(session, *commands, dirty, batch);
+        };
+        auto &router = ShardRouter::Instance();
+        if (router.enabled()) {
+            // 排在 WATCH 之后，并独占事务中的命令访问的分片
+            auto shards = transactionContext.takeWatchShards();
+            for (auto &cmd : *commands) {
+                static_cast<CommandParser *>(cmd->parser)->collectShards(cmd->args, shards);
+            }
+            std::sort(shards.begin(), shards.end());
+            shards.erase(std::unique(shards.begin(), shards.end()), shards.end());
+            router.exclusive(shards, session, task);
+            return;
+        }
+        CommandQueueManager::Instance().pushSessionTask(session, task);
+    }
+
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() != 1) {
             session->send("-ERR wrong number of arguments for 'exec' command\r\n");
             return false;
         }
+        if (!session->getTransactionContext().isTransactionActive()) {
+            session->send("-ERR EXEC without MULTI\r\n");
+            return false;
+        }
         return true;
     }
 
-    void executeCommand(const std::vector<std::string>& command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        //auto redisSession = std::dynamic_pointer_cast<RedisSession>(session);
-        auto& transactionContext = session->getTransactionContext();
-        if (!transactionContext.isTransactionActive()) {
-            session->send("-ERR EXEC without MULTI\r\n");
-            return;
-        }
+    // 不经过 execute，见 runTransaction
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {}
 
-        auto& transactionQueue = transactionContext.getTransactionQueue();
-        std::string response = "*" + std::to_string(transactionQueue.size()) + "\r\n";
-        // 迭代处理事务队列中的所有命令
-        for (const auto& cmd : transactionQueue) {
-            std::ostringstream result;
-            cmd(result);
-            response += result.str();
+    // 返回事务是否执行了（没有因解析错误或 WATCH 的键被修改而放弃）
+    bool runTransaction(const Session::Ptr &session, const std::vector<CmdDesc::Ptr> &commands, bool dirty, uint64_t batch) {
+        RedisStats::Instance().onCommand();
+        // EXEC 之后不再监视任何键
+        auto watched = session->getTransactionContext().takeWatched(batch);
+        if (dirty) {
+            session->send(SharedReply::execAbort());
+            return false;
         }
-
-        transactionContext.endTransaction();
-        session->send(response);
+        auto &router = ShardRouter::Instance();
+        for (auto &key : watched) {
+            if (router.enabled()) {
+                // 独占执行中，切换到键所属的分片读取版本号
+                Keyspace::currentShard() = Keyspace::shardOf(key.key.data(), key.key.size(), router.shardCount());
+            }
+            if (redisHelper_->keyVersion(key.dbIndex, key.key) != key.version) {
+                // WATCH 之后键被修改过，放弃执行
+                session->send(SharedReply::nullArray());
+                return false;
+            }
+        }
+        std::vector<Buffer::Ptr> replies;
+        replies.reserve(commands.size());
+        {
+            // 事务中的写全部完成之前，poller 线程上的并发读改走执行线程，看不到执行了一半的事务
+            AtomicWrites::Scope scope;
+            ReplySequencer::Capture capture(session.get(), replies);
+            for (auto &cmd : commands) {
+                // 与 Redis 相同，某条命令执行出错时它的回复是一个错误，其余命令照常执行
+                try {
+                    // 描述符的处理者都是 CommandParser
+                    static_cast<CommandParser *>(cmd->parser)->executeQueued(cmd);
+                } catch (const std::exception &ex) {
+                    session->send(SharedReply::error(ex.what()));
+                }
+            }
+        }
+        size_t length = RespWriter::arrayLength(commands.size());
+        for (auto &reply : replies) {
+            length += reply->size();
+        }
+        RespWriter response(length);
+        response.array(commands.size());
+        for (auto &reply : replies) {
+            response.raw(reply->data(), reply->size());
+        }
+        session->send(response.buffer());
+        return true;
     }
 };
 
@@ -800,35 +1548,157 @@ public:
         : CommandParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string>& command, Session::Ptr session) override {
+    Route route() const override {
+        return ROUTE_LOCAL;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() != 1) {
             session->send("-ERR wrong number of arguments for 'discard' command\r\n");
             return false;
         }
+        auto& transactionContext = session->getTransactionContext();
+        if (!transactionContext.isTransactionActive()) {
+            session->send("-ERR DISCARD without MULTI\r\n");
+            return false;
+        }
+        transactionContext.endTransaction();
+        // 之前批次中尚未执行完的 WATCH 之后记录的键不会再被 EXEC 使用，不必等待
+        transactionContext.endWatchBatch();
+        transactionContext.takeWatchShards();
         return true;
     }
 
-    void executeCommand(const std::vector<std::string>& command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        //auto redisSession = std::dynamic_pointer_cast<RedisSession>(session);
-        auto& transactionContext = session->getTransactionContext();
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        session->getTransactionContext().unwatch();
+        session->send(SharedReply::ok());
+    }
+};
 
-        if (!transactionContext.isTransactionActive()) {
-            session->send("-ERR DISCARD without MULTI\r\n");
+// WATCH 命令解析器
+// 在键所属分片的线程中记录各键当前的版本号，EXEC 独占这些分片后比较。
+// 键按解析时的批次记录（见 TransactionContext），因此批次在 poller 线程中取得后随任务带到执行线程
+class WatchParser : public CommandParser {
+public:
+    explicit WatchParser(std::shared_ptr<RedisHelper> redisHelper)
+        : CommandParser(std::move(redisHelper)) {}
+
+    void parserAndExecuter(const CmdDesc::Ptr &cmd) override {
+        auto &session = cmd->session;
+        if (!parserCommand(cmd->args, session)) {
             return;
         }
+        auto dbIndex = session->getDbIndex();
+        auto &transactionContext = session->getTransactionContext();
+        auto batch = transactionContext.watchBatch();
+        auto &router = ShardRouter::Instance();
+        if (!router.enabled()) {
+            CommandQueueManager::Instance().pushSessionTask(session, [this, cmd, dbIndex, batch]() {
+                RedisStats::Instance().onCommand();
+                for (size_t i = 1; i < cmd->args.size(); ++i) {
+                    watchKey(cmd, i, dbIndex, batch);
+                }
+                cmd->session->send(SharedReply::ok());
+            });
+            return;
+        }
+        // 各分片记录自己的键，全部完成后回复
+        auto groups = std::make_shared<std::vector<std::vector<size_t>>>();
+        auto shards = groupByShard(cmd->args, 1, 1, *groups);
+        for (auto shard : shards) {
+            transactionContext.addWatchShard(shard);
+        }
+        auto reply = replyFanout(session);
+        router.scatter(shards, [this, cmd, groups, dbIndex, batch](size_t shard) {
+            for (auto i : (*groups)[shard]) {
+                watchKey(cmd, i, dbIndex, batch);
+            }
+        }, [reply]() {
+            reply(SharedReply::ok());
+        }, failFanout(reply));
+    }
 
-        transactionContext.endTransaction();
-        session->send("+OK\r\n");
+private:
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() < 2) {
+            session->send("-ERR wrong number of arguments for 'watch' command\r\n");
+            return false;
+        }
+        if (session->getTransactionContext().isTransactionActive()) {
+            session->send("-ERR WATCH inside MULTI is not allowed\r\n");
+            return false;
+        }
+        return true;
+    }
+
+    // 不经过 execute，见 parserAndExecuter
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {}
+
+    // 记录第 i 个参数（键）当前的版本号
+    void watchKey(const CmdDesc::Ptr &cmd, size_t i, int dbIndex, uint64_t batch) {
+        auto &key = cmd->args[i];
+        cmd->session->getTransactionContext().watch({dbIndex, key.toString(), redisHelper_->keyVersion(dbIndex, key), batch});
+    }
+};
+
+// UNWATCH 命令解析器
+// 启用分片路由时经 WATCH 的键所属的分片执行，排在这些分片上尚未执行的 WATCH 之后，不会被之前的 WATCH 重新加回监视
+class UnwatchParser : public CommandParser {
+public:
+    explicit UnwatchParser(std::shared_ptr<RedisHelper> redisHelper)
+        : CommandParser(std::move(redisHelper)) {}
+
+private:
+    Route route() const override {
+        return ROUTE_FANOUT;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() != 1) {
+            session->send("-ERR wrong number of arguments for 'unwatch' command\r\n");
+            return false;
+        }
+        return true;
+    }
+
+    // 不分片时与之前的命令在同一个执行线程中按序执行，直接清空
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        session->getTransactionContext().unwatch();
+        session->send(SharedReply::ok());
+    }
+
+    void fanout(const CmdDesc::Ptr &cmd) override {
+        auto &session = cmd->session;
+        if (ShardRouter::inlined()) {
+            // 事务中：EXEC 已经取走了要监视的键
+            session->send(SharedReply::ok());
+            return;
+        }
+        auto &transactionContext = session->getTransactionContext();
+        auto batch = transactionContext.endWatchBatch();
+        auto shards = transactionContext.takeWatchShards();
+        if (shards.empty()) {
+            // 没有尚未完成的 WATCH
+            transactionContext.unwatch(batch);
+            session->send(SharedReply::ok());
+            return;
+        }
+        // 各分片上排在前面的 WATCH 都已执行后，只清除本批次及更早的键，之后新 WATCH 的键保留
+        auto reply = replyFanout(session);
+        ShardRouter::Instance().scatter(shards, [](size_t) {}, [session, batch, reply]() {
+            session->getTransactionContext().unwatch(batch);
+            reply(SharedReply::ok());
+        }, failFanout(reply));
     }
 };
 // LPUSH 命令解析器
-class LPushParser : public CommandParser {
+class LPushParser : public TypedParser<LPushParser, RedisList> {
 public:
     explicit LPushParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() < 3) { // 至少需要 key 和一个 value
             DebugL << "Invalid LPUSH command.";
             session->send("-ERR wrong number of arguments for 'lpush' command\r\n");
@@ -837,30 +1707,26 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisList = std::dynamic_pointer_cast<RedisList>(dataStore);
-        if (!redisList) {
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisList *redisList, int dbIndex) {
         const std::string& key = command[1];
         for (size_t i = 2; i < command.size(); ++i) {
             redisList->lpush(key, command[i]);
         }
 
-        session->send(":" + std::to_string(command.size() - 2) + "\r\n"); // 返回插入的元素数量
+        session->send(SharedReply::integer(command.size() - 2)); // 返回插入的元素数量
     }
 };
 
 // RPUSH 命令解析器
-class RPushParser : public CommandParser {
+class RPushParser : public TypedParser<RPushParser, RedisList> {
 public:
     explicit RPushParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() < 3) { // 至少需要 key 和一个 value
             DebugL << "Invalid RPUSH command.";
             session->send("-ERR wrong number of arguments for 'rpush' command\r\n");
@@ -869,30 +1735,26 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisList = std::dynamic_pointer_cast<RedisList>(dataStore);
-        if (!redisList) {
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisList *redisList, int dbIndex) {
         const std::string& key = command[1];
         for (size_t i = 2; i < command.size(); ++i) {
             redisList->rpush(key, command[i]);
         }
 
-        session->send(":" + std::to_string(command.size() - 2) + "\r\n"); // 返回插入的元素数量
+        session->send(SharedReply::integer(command.size() - 2)); // 返回插入的元素数量
     }
 };
 
 // LPOP 命令解析器
-class LPopParser : public CommandParser {
+class LPopParser : public TypedParser<LPopParser, RedisList> {
 public:
     explicit LPopParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() != 2) { // 需要 key
             DebugL << "Invalid LPOP command.";
             session->send("-ERR wrong number of arguments for 'lpop' command\r\n");
@@ -901,31 +1763,27 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisList = std::dynamic_pointer_cast<RedisList>(dataStore);
-        if (!redisList) {
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisList *redisList, int dbIndex) {
         const std::string& key = command[1];
         auto value = redisList->lpop(key);
         if (!value.empty()) {
-            session->send("$" + std::to_string(value.size()) + "\r\n" + value + "\r\n");
+            session->send(RespWriter(RespWriter::bulkLength(value.size())).bulk(value).buffer());
         } else {
-            session->send("$-1\r\n"); // 列表为空或不存在
+            session->send(SharedReply::nil()); // 列表为空或不存在
         }
     }
 };
 
 // RPOP 命令解析器
-class RPopParser : public CommandParser {
+class RPopParser : public TypedParser<RPopParser, RedisList> {
 public:
     explicit RPopParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() != 2) { // 需要 key
             DebugL << "Invalid RPOP command.";
             session->send("-ERR wrong number of arguments for 'rpop' command\r\n");
@@ -934,31 +1792,27 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisList = std::dynamic_pointer_cast<RedisList>(dataStore);
-        if (!redisList) {
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisList *redisList, int dbIndex) {
         const std::string& key = command[1];
         auto value = redisList->rpop(key);
         if (!value.empty()) {
-            session->send("$" + std::to_string(value.size()) + "\r\n" + value + "\r\n");
+            session->send(RespWriter(RespWriter::bulkLength(value.size())).bulk(value).buffer());
         } else {
-            session->send("$-1\r\n"); // 列表为空或不存在
+            session->send(SharedReply::nil()); // 列表为空或不存在
         }
     }
 };
 
 // LRANGE 命令解析器
-class LRangeParser : public CommandParser {
+class LRangeParser : public TypedParser<LRangeParser, RedisList> {
 public:
     explicit LRangeParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() != 4) { // 需要 key, start, end
             DebugL << "Invalid LRANGE command.";
             session->send("-ERR wrong number of arguments for 'lrange' command\r\n");
@@ -967,32 +1821,34 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisList = std::dynamic_pointer_cast<RedisList>(dataStore);
-        if (!redisList) {
-            session->send("-ERR operation against a key holding the wrong kind of value\r\n");
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisList *redisList, int dbIndex) {
         const std::string& key = command[1];
         int start = std::stoi(command[2]);
         int end = std::stoi(command[3]);
         auto values = redisList->lrange(key, start, end);
 
-        session->send("*" + std::to_string(values.size()) + "\r\n");
+        size_t length = RespWriter::arrayLength(values.size());
+        for (const auto& value : values) {
+            length += RespWriter::bulkLength(value.size());
+        }
+        RespWriter response(length);
+        response.array(values.size());
         for (const auto& value : values) {
-            session->send("$" + std::to_string(value.size()) + "\r\n" + value + "\r\n");
+            response.bulk(value);
         }
+        session->send(response.buffer());
     }
 };
 // SADD
-class SAddParser : public CommandParser {
+class SAddParser : public TypedParser<SAddParser, RedisSet> {
 public:
     explicit SAddParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() < 3) {
             session->send(std::move("-ERR wrong number of arguments for 'sadd' command\r\n"));
             return false;
@@ -1000,13 +1856,7 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisSet = std::dynamic_pointer_cast<RedisSet>(dataStore);
-        if (!redisSet) {
-            session->send(std::move("-ERR operation against a key holding the wrong kind of value\r\n"));
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisSet *redisSet, int dbIndex) {
         const std::string &key = command[1];
         int addedCount = 0;
 
@@ -1015,17 +1865,19 @@ private:
             ++addedCount;
         }
 
-        session->send(std::move(":" + std::to_string(addedCount) + "\r\n"));
+        session->send(SharedReply::integer(addedCount));
     }
 };
 // SREM
-class SRemParser : public CommandParser {
+class SRemParser : public TypedParser<SRemParser, RedisSet> {
 public:
     explicit SRemParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() < 3) {
             session->send(std::move("-ERR wrong number of arguments for 'srem' command\r\n"));
             return false;
@@ -1033,13 +1885,7 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisSet = std::dynamic_pointer_cast<RedisSet>(dataStore);
-        if (!redisSet) {
-            session->send(std::move("-ERR operation against a key holding the wrong kind of value\r\n"));
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisSet *redisSet, int dbIndex) {
         const std::string &key = command[1];
         int removedCount = 0;
 
@@ -1049,17 +1895,19 @@ private:
             }
         }
 
-        session->send(std::move(":" + std::to_string(removedCount) + "\r\n"));
+        session->send(SharedReply::integer(removedCount));
     }
 };
 // SMEMBERS
-class SMembersParser : public CommandParser {
+class SMembersParser : public TypedParser<SMembersParser, RedisSet> {
 public:
     explicit SMembersParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() != 2) {
             session->send(std::move("-ERR wrong number of arguments for 'smembers' command\r\n"));
             return false;
@@ -1067,30 +1915,66 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisSet = std::dynamic_pointer_cast<RedisSet>(dataStore);
-        if (!redisSet) {
-            session->send(std::move("-ERR operation against a key holding the wrong kind of value\r\n"));
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisSet *redisSet, int dbIndex) {
         const std::string &key = command[1];
         auto members = redisSet->smembers(key);
 
-        session->send(std::move("*" + std::to_string(members.size()) + "\r\n"));
+        size_t length = RespWriter::arrayLength(members.size());
         for (const auto &member : members) {
-            session->send(std::move("$" + std::to_string(member.size()) + "\r\n" + member + "\r\n"));
+            length += RespWriter::bulkLength(member.size());
         }
+        RespWriter response(length);
+        response.array(members.size());
+        for (const auto &member : members) {
+            response.bulk(member);
+        }
+        session->send(response.buffer());
     }
 };
+// SSCAN key cursor [MATCH pattern] [COUNT count]
+class SScanParser : public TypedParser<SScanParser, RedisSet> {
+public:
+    explicit SScanParser(std::shared_ptr<RedisHelper> redisHelper)
+        : TypedParser(std::move(redisHelper)) {}
+
+private:
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() < 3) {
+            session->send("-ERR wrong number of arguments for 'sscan' command\r\n");
+            return false;
+        }
+        ScanArgs args;
+        return parseScanArgs(command, 2, false, args, session);
+    }
+
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisSet *redisSet, int dbIndex) {
+        ScanArgs args;
+        if (!parseScanArgs(command, 2, false, args, session)) {
+            return;
+        }
+        std::vector<std::string> members;
+        auto cursor = redisSet->sscan(command[1], args.cursor, args.count, members);
+        if (args.match) {
+            members.erase(std::remove_if(members.begin(), members.end(), [&](const std::string &member) {
+                return !scanMatch(args, member);
+            }), members.end());
+        }
+        session->send(scanReply(cursor, members));
+    }
+};
+
 // SISMEMEBER
-class SIsMemberParser : public CommandParser {
+class SIsMemberParser : public TypedParser<SIsMemberParser, RedisSet> {
 public:
     explicit SIsMemberParser(std::shared_ptr<RedisHelper> redisHelper)
-        : CommandParser(std::move(redisHelper)) {}
+        : TypedParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override {
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
         if (command.size() != 3) {
             session->send(std::move("-ERR wrong number of arguments for 'sismember' command\r\n"));
             return false;
@@ -1098,18 +1982,12 @@ private:
         return true;
     }
 
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto redisSet = std::dynamic_pointer_cast<RedisSet>(dataStore);
-        if (!redisSet) {
-            session->send(std::move("-ERR operation against a key holding the wrong kind of value\r\n"));
-            return;
-        }
-
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisSet *redisSet, int dbIndex) {
         const std::string &key = command[1];
         const std::string &value = command[2];
 
         bool isMember = redisSet->sismember(key, value);
-        session->send(std::move(":" + std::to_string(isMember ? 1 : 0) + "\r\n"));
+        session->send(SharedReply::integer(isMember ? 1 : 0));
     }
 };
 
@@ -1120,7 +1998,10 @@ public:
         :CommandParser(std::move(redisHelper)) {}
 
 private:
-    bool parserCommand(const std::vector<std::string> &command, Session::Ptr session) override{
+    Route route() const override {
+        return ROUTE_FANOUT;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override{
         if(command.size() != 1) {
             //DebugL << "Invalid DBSIZE command.";
             session->send("-ERR wrong number of arguments for 'dbsize' command\r\n");
@@ -1128,13 +2009,361 @@ private:
         }
         return true;
     }
-    void executeCommand(const std::vector<std::string> &command, Session::Ptr session, RedisDataType::Ptr dataStore) override {
-        auto response = redisHelper_->dbsize();
-        session->send(":" + std::to_string(response) + "\r\n");
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        auto response = redisHelper_->dbsize(dbIndex);
+        session->send(SharedReply::integer(response));
         //DebugL << "Found " << matched_keys.size() << " keys matching pattern: " << pattern;
     }
+    void fanout(const CmdDesc::Ptr &cmd) override {
+        auto dbIndex = cmd->dbIndex;
+        auto sizes = std::make_shared<std::vector<int>>(ShardRouter::Instance().shardCount(), 0);
+        auto reply = replyFanout(cmd->session);
+        ShardRouter::Instance().scatter(allShards(), [this, sizes, dbIndex](size_t shard) {
+            (*sizes)[shard] = redisHelper_->dbsize(dbIndex);
+        }, [sizes, reply]() {
+            int total = 0;
+            for (auto size : *sizes) {
+                total += size;
+            }
+            reply(SharedReply::integer(total));
+        }, failFanout(reply));
+    }
+};
+
+
+// INFO 命令解析器
+class InfoParser : public CommandParser {
+public:
+    explicit InfoParser(std::shared_ptr<RedisHelper> redisHelper)
+        : CommandParser(std::move(redisHelper)) {}
+
+private:
+    Route route() const override {
+        return ROUTE_LOCAL;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() > 2) {
+            session->send("-ERR wrong number of arguments for 'info' command\r\n");
+            return false;
+        }
+        return true;
+    }
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        auto info = RedisStats::Instance().info() + CommandQueueManager::Instance().info();
+        session->send(RespWriter(RespWriter::bulkLength(info.size())).bulk(info).buffer());
+    }
 };
 
+// MEMORY USAGE key [SAMPLES count] / MEMORY STATS
+// USAGE 在键所属的分片上估算；STATS 需遍历所有键（O(N)），在各分片上分别统计后汇总
+class MemoryParser : public CommandParser {
+public:
+    explicit MemoryParser(std::shared_ptr<RedisHelper> redisHelper)
+        : CommandParser(std::move(redisHelper)) {}
+
+private:
+    Route route() const override {
+        return ROUTE_FANOUT;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() == 2 && command[1].equalsIgnoreCase("STATS")) {
+            return true;
+        }
+        if ((command.size() == 3 || command.size() == 5) && command[1].equalsIgnoreCase("USAGE")) {
+            size_t samples;
+            return parseSamples(command, samples, session);
+        }
+        session->send("-ERR unknown subcommand or wrong number of arguments for 'MEMORY' command\r\n");
+        return false;
+    }
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        if (command[1].equalsIgnoreCase("STATS")) {
+            std::vector<MemoryStats> stats;
+            redisHelper_->memoryStats(stats);
+            session->send(statsReply(stats));
+            return;
+        }
+        size_t samples;
+        if (!parseSamples(command, samples, session)) {
+            return;
+        }
+        size_t bytes;
+        if (!redisHelper_->keyMemoryUsage(dbIndex, command[2], samples, bytes)) {
+            session->send(SharedReply::nil());
+            return;
+        }
+        session->send(SharedReply::integer(static_cast<int64_t>(bytes)));
+    }
+    void fanout(const CmdDesc::Ptr &cmd) override {
+        auto &router = ShardRouter::Instance();
+        if (cmd->args[1].equalsIgnoreCase("USAGE")) {
+            // 只访问一个键，与按键路由的命令相同
+            router.execute(router.shardOf(cmd->args[2]), cmd->session, [cmd, this]() {
+                this->execute(cmd->args, cmd->session, cmd->dbIndex);
+            });
+            return;
+        }
+        auto stats = std::make_shared<std::vector<std::vector<MemoryStats>>>(router.shardCount());
+        auto reply = replyFanout(cmd->session);
+        router.scatter(allShards(), [this, stats](size_t shard) {
+            redisHelper_->memoryStats((*stats)[shard]);
+        }, [stats, reply]() {
+            std::vector<MemoryStats> total(RedisHelper::kDbCount);
+            for (auto &shard : *stats) {
+                for (size_t i = 0; i < shard.size(); ++i) {
+                    total[i] += shard[i];
+                }
+            }
+            reply(statsReply(total));
+        }, failFanout(reply));
+    }
+
+    // SAMPLES 参数：抽样的元素数，0 表示所有元素，默认 Keyspace::kMemorySamples
+    static bool parseSamples(const CmdArgs &command, size_t &samples, const Session::Ptr &session) {
+        samples = Keyspace::kMemorySamples;
+        if (command.size() < 5) {
+            return true;
+        }
+        int64_t value;
+        if (!command[3].equalsIgnoreCase("SAMPLES")) {
+            session->send("-ERR syntax error\r\n");
+            return false;
+        }
+        if (!parseInteger(command[4], value) || value < 0) {
+            session->send("-ERR value is not an integer or out of range\r\n");
+            return false;
+        }
+        samples = static_cast<size_t>(value);
+        return true;
+    }
+
+    // MEMORY STATS 的回复：名称与数值交替的数组，各数据库的哈希表开销为嵌套数组
+    static Buffer::Ptr statsReply(const std::vector<MemoryStats> &perDb) {
+        MemoryStats total;
+        size_t dbs = 0;
+        for (auto &db : perDb) {
+            total += db;
+            dbs += db.keys ? 1 : 0;
+        }
+        auto overhead = total.mainOverhead + total.expiresOverhead;
+        std::vector<std::pair<std::string, size_t>> fields = {
+            {"peak.allocated", UsedMemory::peak()},
+            {"total.allocated", UsedMemory::get()},
+            {"overhead.hashtable.main", total.mainOverhead},
+            {"overhead.hashtable.expires", total.expiresOverhead},
+            {"keys.count", total.keys},
+            {"keys.bytes-per-key", total.keys ? (total.datasetBytes + overhead) / total.keys : 0},
+            {"dataset.bytes", total.datasetBytes},
+        };
+        for (auto type : {OBJ_STRING, OBJ_LIST, OBJ_SET, OBJ_HASH}) {
+            fields.emplace_back(std::string(RedisObject::typeName(type)) + ".keys", total.typeKeys[type]);
+            fields.emplace_back(std::string(RedisObject::typeName(type)) + ".bytes", total.typeBytes[type]);
+        }
+        // 各数据库的开销紧接在总的哈希表开销之后
+        const size_t kDbPosition = 4;
+        auto count = fields.size() + dbs;
+        RespWriter response(RespWriter::arrayLength(count * 2) + (fields.size() + dbs * 3) * 64);
+        response.array(count * 2);
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (i == kDbPosition) {
+                for (size_t db = 0; db < perDb.size(); ++db) {
+                    if (!perDb[db].keys) {
+                        continue;
+                    }
+                    auto name = "db." + std::to_string(db);
+                    response.bulk(name.data(), name.size());
+                    response.array(4);
+                    response.bulk("overhead.hashtable.main", 23);
+                    response.integer(static_cast<int64_t>(perDb[db].mainOverhead));
+                    response.bulk("overhead.hashtable.expires", 26);
+                    response.integer(static_cast<int64_t>(perDb[db].expiresOverhead));
+                }
+            }
+            response.bulk(fields[i].first.data(), fields[i].first.size());
+            response.integer(static_cast<int64_t>(fields[i].second));
+        }
+        return response.buffer();
+    }
+};
+
+// PING 命令解析器
+class PingParser : public CommandParser {
+public:
+    explicit PingParser(std::shared_ptr<RedisHelper> redisHelper)
+        : CommandParser(std::move(redisHelper)) {}
+
+private:
+    Route route() const override {
+        return ROUTE_LOCAL;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() > 2) {
+            session->send("-ERR wrong number of arguments for 'ping' command\r\n");
+            return false;
+        }
+        return true;
+    }
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        if (command.size() == 1) {
+            session->send(SharedReply::pong());
+            return;
+        }
+        session->send(RespWriter(RespWriter::bulkLength(command[1].size())).bulk(command[1]).buffer());
+    }
+};
+
+// TYPE 命令解析器
+class TypeParser : public CommandParser {
+public:
+    explicit TypeParser(std::shared_ptr<RedisHelper> redisHelper)
+        : CommandParser(std::move(redisHelper)) {}
+
+private:
+    bool readOnly() const override {
+        return true;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() != 2) {
+            session->send("-ERR wrong number of arguments for 'type' command\r\n");
+            return false;
+        }
+        return true;
+    }
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        session->send(std::string("+") + redisHelper_->keyType(dbIndex, command[1]) + "\r\n");
+    }
+    // 值对象的类型在创建后不会改变，并发读取是安全的
+    void executeShared(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        auto obj = redisHelper_->lookupShared(dbIndex, command[1]);
+        session->send(std::string("+") + (obj ? RedisObject::typeName(obj->type()) : "none") + "\r\n");
+    }
+
+};
+
+// EXPIRE / PEXPIRE 命令解析器，unit 为参数的单位（毫秒数）
+class ExpireParser : public CommandParser {
+public:
+    ExpireParser(std::shared_ptr<RedisHelper> redisHelper, int64_t unit)
+        : CommandParser(std::move(redisHelper)), _unit(unit) {}
+
+private:
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() != 3) {
+            session->send(std::string("-ERR wrong number of arguments for '") + spec().name + "' command\r\n");
+            return false;
+        }
+        int64_t at;
+        return expireAt(command[2], at, session);
+    }
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        int64_t at;
+        if (!expireAt(command[2], at, session)) {
+            return;
+        }
+        session->send(SharedReply::integer(redisHelper_->expireKey(dbIndex, command[1], at) ? 1 : 0));
+    }
+
+    // 把相对时间参数换算为过期时刻，参数不合法时回复错误
+    bool expireAt(const StrView &arg, int64_t &at, const Session::Ptr &session) const {
+        int64_t value;
+        if (!parseInteger(arg, value)) {
+            session->send("-ERR value is not an integer or out of range\r\n");
+            return false;
+        }
+        if (value > kMaxExpire / _unit || value < -kMaxExpire / _unit) {
+            session->send(std::string("-ERR invalid expire time in '") + spec().name + "' command\r\n");
+            return false;
+        }
+        at = static_cast<int64_t>(getCurrentMillisecond()) + value * _unit;
+        return true;
+    }
+
+    static const int64_t kMaxExpire = INT64_MAX / 4;
+    int64_t _unit;
+};
+
+// TTL 命令解析器
+class TtlParser : public CommandParser {
+public:
+    explicit TtlParser(std::shared_ptr<RedisHelper> redisHelper)
+        : CommandParser(std::move(redisHelper)) {}
+
+private:
+    bool readOnly() const override {
+        return true;
+    }
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() != 2) {
+            session->send("-ERR wrong number of arguments for 'ttl' command\r\n");
+            return false;
+        }
+        return true;
+    }
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        session->send(SharedReply::integer(seconds(redisHelper_->keyTtl(dbIndex, command[1]))));
+    }
+    // 过期时间是原子读写的，并发读取是安全的
+    void executeShared(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        session->send(SharedReply::integer(seconds(redisHelper_->keyTtlShared(dbIndex, command[1]))));
+    }
+    // 剩余毫秒数四舍五入为秒，-2/-1 原样返回
+    static int64_t seconds(int64_t ms) {
+        return ms < 0 ? ms : (ms + 500) / 1000;
+    }
+};
+
+// PERSIST 命令解析器
+class PersistParser : public CommandParser {
+public:
+    explicit PersistParser(std::shared_ptr<RedisHelper> redisHelper)
+        : CommandParser(std::move(redisHelper)) {}
+
+private:
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() != 2) {
+            session->send("-ERR wrong number of arguments for 'persist' command\r\n");
+            return false;
+        }
+        return true;
+    }
+    void executeCommand(const CmdArgs &command, const Session::Ptr &session, int dbIndex) override {
+        session->send(SharedReply::integer(redisHelper_->persistKey(dbIndex, command[1]) ? 1 : 0));
+    }
+};
+
+// SETEX 命令解析器
+class SetexParser : public TypedParser<SetexParser, RedisString> {
+public:
+    explicit SetexParser(std::shared_ptr<RedisHelper> redisHelper)
+        : TypedParser(std::move(redisHelper)) {}
+
+private:
+    friend TypedParser;
+
+    bool parserCommand(const CmdArgs &command, Session::Ptr session) override {
+        if (command.size() != 4) {
+            session->send("-ERR wrong number of arguments for 'setex' command\r\n");
+            return false;
+        }
+        int64_t seconds;
+        if (!parseInteger(command[2], seconds)) {
+            session->send("-ERR value is not an integer or out of range\r\n");
+            return false;
+        }
+        if (seconds <= 0 || seconds > INT64_MAX / 4000) {
+            session->send("-ERR invalid expire time in 'setex' command\r\n");
+            return false;
+        }
+        return true;
+    }
+    void executeTyped(const CmdArgs &command, const Session::Ptr &session, RedisString *redisString, int dbIndex) {
+        int64_t seconds = 0;
+        parseInteger(command[2], seconds);
+        redisString->set(command[1], command[3]);
+        redisHelper_->expireKey(dbIndex, command[1], static_cast<int64_t>(getCurrentMillisecond()) + seconds * 1000);
+        session->send(SharedReply::ok());
+    }
+};
 
 } // namespace toolkit
 
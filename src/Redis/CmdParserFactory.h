@@ -3,6 +3,7 @@
 
 #include "CmdParser.h"
 #include "Global.h"
+#include "CommandTable.h"
 #include "Util/onceToken.h"
 
 namespace toolkit
@@ -10,7 +11,7 @@ namespace toolkit
 // 享元模式工厂
 class CmdParserFactory {
 private:
-    std::unordered_map<std::string, std::shared_ptr<CommandParser>> parserMaps;
+    std::vector<std::shared_ptr<CommandParser>> parsers_;   // 下标与 CommandTable::kCommands 一致
     RedisHelper::Ptr redisHelper_;
 
     CmdParserFactory() : redisHelper_(RedisHelper::instance()) {
@@ -18,9 +19,18 @@ private:
             redisHelper_->loadFromStorage();
             DebugL << "Data loaded from Disk !";
         });
+        // 预先为命令表中的每个命令创建解析器，之后各 poller 线程并发调用 getParser 时只读不写
+        parsers_.resize(CommandTable::kCount);
+        for (auto &spec : CommandTable::kCommands) {
+            auto parser = createCommandParser(spec.id);
+            if (parser) {
+                parser->bind(spec);
+            }
+            parsers_[CommandTable::indexOf(spec)] = std::move(parser);
+        }
     };  // 初始化RedisHelper对象
 
-    std::shared_ptr<CommandParser> createCommandParser(const std::string& command);
+    std::shared_ptr<CommandParser> createCommandParser(Command op);
 
 public:
     using Ptr = std::shared_ptr<CmdParserFactory>;
@@ -33,164 +43,162 @@ public:
         return redisHelper_;
     }
 
-    std::shared_ptr<CommandParser> getParser(const std::string& command) {
-        if(!parserMaps.empty() && parserMaps.find(command) != parserMaps.end()) {
-            return parserMaps[command];
-        }
-        return createCommandParser(command);
+    // 命令对应的解析器，解析器与工厂同生命周期
+    CommandParser *getParser(const CommandSpec &spec) const {
+        return parsers_[CommandTable::indexOf(spec)].get();
     }
 };
 
-std::shared_ptr<CommandParser> CmdParserFactory::createCommandParser(const std::string& command){
-        Command op;
-        if(commandMaps.find(command)  == commandMaps.end()) {
-            op = INVALID_COMMAND;
-        } else {
-            op = commandMaps[command];
-        }
-
+std::shared_ptr<CommandParser> CmdParserFactory::createCommandParser(Command op){
         switch(op) {
             case SET:{
-                parserMaps[command] = std::make_shared<SetParser>(redisHelper_);
-                break;
+                return std::make_shared<SetParser>(redisHelper_);
             }
             case GET:{
-                parserMaps[command] = std::make_shared<GetParser>(redisHelper_);
-                break;
+                return std::make_shared<GetParser>(redisHelper_);
             }
             case DEL:{
-                parserMaps[command] = std::make_shared<DelParser>(redisHelper_);
-                break;
+                return std::make_shared<DelParser>(redisHelper_);
             }
             case EXISTS:{
-                parserMaps[command] = std::make_shared<ExistsParser>(redisHelper_);
-                break;
+                return std::make_shared<ExistsParser>(redisHelper_);
             }
             case INCR:{
-                parserMaps[command] = std::make_shared<IncrParser>(redisHelper_);
-                break;
+                return std::make_shared<IncrParser>(redisHelper_);
             }
             case DECR:{
-                parserMaps[command] = std::make_shared<DecrParser>(redisHelper_);
-                break;
+                return std::make_shared<DecrParser>(redisHelper_);
             }
             case APPEND:{
-                parserMaps[command] = std::make_shared<AppendParser>(redisHelper_);
-                break;
+                return std::make_shared<AppendParser>(redisHelper_);
             }
             case KEYS:{
-                parserMaps[command] = std::make_shared<KeysParaser>(redisHelper_);
-                break;
+                return std::make_shared<KeysParaser>(redisHelper_);
             }
             case MSET:{
-                parserMaps[command] = std::make_shared<MSetParser>(redisHelper_);
-                break;               
+                return std::make_shared<MSetParser>(redisHelper_);               
             }
             case MGET:{
-                parserMaps[command] = std::make_shared<MGetParser>(redisHelper_);
-                break;
+                return std::make_shared<MGetParser>(redisHelper_);
             }
             case HSET:{
-                parserMaps[command] = std::make_shared<HSetParser>(redisHelper_);
-                break;
+                return std::make_shared<HSetParser>(redisHelper_);
             }
             case HMSET:{
-                parserMaps[command] = std::make_shared<HMSetParser>(redisHelper_);
-                break;
+                return std::make_shared<HMSetParser>(redisHelper_);
             }
             case HMGET:{
-                parserMaps[command] = std::make_shared<HMGetParser>(redisHelper_);
-                break;
+                return std::make_shared<HMGetParser>(redisHelper_);
             }
             case HGET:{
-                parserMaps[command] = std::make_shared<HGetParser>(redisHelper_);
-                break;
+                return std::make_shared<HGetParser>(redisHelper_);
             }
             case HDEL:{
-                parserMaps[command] = std::make_shared<HDelParser>(redisHelper_);
-                break;
+                return std::make_shared<HDelParser>(redisHelper_);
             }
             case HGETALL:{
-                parserMaps[command] = std::make_shared<HGetAllParser>(redisHelper_);
-                break;
+                return std::make_shared<HGetAllParser>(redisHelper_);
             }
             case INCRBY:{
-                parserMaps[command] = std::make_shared<IncrByParser>(redisHelper_);
-                break;
+                return std::make_shared<IncrByParser>(redisHelper_);
             }
             case DECRBY:{
-                parserMaps[command] = std::make_shared<DecrByParser>(redisHelper_);
-                break;
+                return std::make_shared<DecrByParser>(redisHelper_);
             }
             case MULTI:{
-                parserMaps[command] = std::make_shared<MultiParser>(redisHelper_);               
-                break;
+                return std::make_shared<MultiParser>(redisHelper_);
             }
             case EXEC:{
-                parserMaps[command] = std::make_shared<ExecParser>(redisHelper_);               
-                break;
+                return std::make_shared<ExecParser>(redisHelper_);
             }
             case DISCARD:{
-                parserMaps[command] = std::make_shared<DiscardParser>(redisHelper_);
-                break;
+                return std::make_shared<DiscardParser>(redisHelper_);
+            }
+            case WATCH:{
+                return std::make_shared<WatchParser>(redisHelper_);
+            }
+            case UNWATCH:{
+                return std::make_shared<UnwatchParser>(redisHelper_);
             }
             case STRLEN:{
-                parserMaps[command] = std::make_shared<StrlenParser>(redisHelper_);
-                break;
+                return std::make_shared<StrlenParser>(redisHelper_);
             }
             case SELECT:{
-                parserMaps[command] = std::make_shared<SelectParser>(redisHelper_);
-                break;
+                return std::make_shared<SelectParser>(redisHelper_);
             }
             case COMMAND:{
-                parserMaps[command] = std::make_shared<CommandParserCommand>(redisHelper_);
-                break;
+                return std::make_shared<CommandParserCommand>(redisHelper_);
             }
             case LPUSH:{
-                parserMaps[command] = std::make_shared<LPushParser>(redisHelper_);                
-                break;
+                return std::make_shared<LPushParser>(redisHelper_);
             }
             case RPUSH:{
-                parserMaps[command] = std::make_shared<RPushParser>(redisHelper_);
-                break;
+                return std::make_shared<RPushParser>(redisHelper_);
             }
             case LPOP:{
-                parserMaps[command] = std::make_shared<LPopParser>(redisHelper_);
-                break;
+                return std::make_shared<LPopParser>(redisHelper_);
             }
             case RPOP:{
-                parserMaps[command] = std::make_shared<RPopParser>(redisHelper_);
-                break;
+                return std::make_shared<RPopParser>(redisHelper_);
             }
             case LRANGE:{
-                parserMaps[command] = std::make_shared<LRangeParser>(redisHelper_);
-                break;
+                return std::make_shared<LRangeParser>(redisHelper_);
             }
             case SADD:{
-                parserMaps[command] = std::make_shared<SAddParser>(redisHelper_);            
-                break;
+                return std::make_shared<SAddParser>(redisHelper_);
             }
             case SREM:{
-                parserMaps[command] = std::make_shared<SRemParser>(redisHelper_);
-                break;
+                return std::make_shared<SRemParser>(redisHelper_);
             }
             case SMEMBERS:{
-                parserMaps[command] = std::make_shared<SMembersParser>(redisHelper_);
-                break;
+                return std::make_shared<SMembersParser>(redisHelper_);
             }
             case SISMEMEBER:{
-                parserMaps[command] = std::make_shared<SIsMemberParser>(redisHelper_);
-                break;
+                return std::make_shared<SIsMemberParser>(redisHelper_);
             }
             case DBSIZE:{
-                parserMaps[command] = std::make_shared<DBsizeParaser>(redisHelper_);
-                break;
+                return std::make_shared<DBsizeParaser>(redisHelper_);
+            }
+            case INFO:{
+                return std::make_shared<InfoParser>(redisHelper_);
+            }
+            case TYPE:{
+                return std::make_shared<TypeParser>(redisHelper_);
+            }
+            case PING:{
+                return std::make_shared<PingParser>(redisHelper_);
+            }
+            case SETEX:{
+                return std::make_shared<SetexParser>(redisHelper_);
+            }
+            case EXPIRE:{
+                return std::make_shared<ExpireParser>(redisHelper_, 1000);
+            }
+            case PEXPIRE:{
+                return std::make_shared<ExpireParser>(redisHelper_, 1);
+            }
+            case TTL:{
+                return std::make_shared<TtlParser>(redisHelper_);
+            }
+            case PERSIST:{
+                return std::make_shared<PersistParser>(redisHelper_);
+            }
+            case MEMORY:{
+                return std::make_shared<MemoryParser>(redisHelper_);
+            }
+            case SCAN:{
+                return std::make_shared<ScanParser>(redisHelper_);
+            }
+            case HSCAN:{
+                return std::make_shared<HScanParser>(redisHelper_);
+            }
+            case SSCAN:{
+                return std::make_shared<SScanParser>(redisHelper_);
             }
             default:{
                 return nullptr;
             }
         }
-        return parserMaps[command];
     };
 
 } // namespace toolkit
@@ -1,48 +1,272 @@
 #ifndef CMDQUEUE_H
 #define CMDQUEUE_H
 
-#include <queue>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include "CmdDesc.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
 #include <mutex>
 #include <condition_variable>
-#include <functional>
+#endif
 
 namespace toolkit
 {
-    
+
+// 有界无锁多生产者单消费者队列
+// 各 poller 线程（生产者）通过 CAS 抢占槽位写入命令，执行线程（唯一消费者）按序取出，入队与出队都不加锁。
+// 每个槽带一个序号（参考 Vyukov 的有界队列）：序号等于写入位置表示空闲，等于写入位置 + 1 表示命令已写好。
+// 执行线程取空队列后先短暂自旋，仍然没有命令才通过 futex 休眠，生产者只在执行线程休眠时才需要系统调用唤醒。
 class CommandQueue {
 public:
-    using Command = std::function<void()>;
+    using Task = std::function<void()>;
+
+    // 队列中的一项：客户端命令只保存描述符（不分配内存），其它跨线程任务（分片转发、后台 rehash 等）保存为 Task
+    class Command {
+    public:
+        Command() = default;
+        Command(CmdDesc::Ptr desc) : _desc(std::move(desc)) {}
+        // owner 为任务所属的客户端（公平调度按它分组），nullptr 表示不属于任何客户端
+        template <typename Func, typename = typename std::enable_if<
+                      !std::is_same<typename std::decay<Func>::type, Command>::value &&
+                      std::is_constructible<Task, Func>::value>::type>
+        Command(Func &&task, const void *owner = nullptr) : _task(std::forward<Func>(task)), _owner(owner) {}
+
+        void operator()() {
+            if (_desc) {
+                _desc->parser->run(*_desc);
+            } else if (_task) {
+                _task();
+            }
+        }
+
+        // 及时释放命令持有的会话与接收缓存
+        void reset() {
+            _desc = nullptr;
+            _task = nullptr;
+            _owner = nullptr;
+        }
+
+        // 客户端命令的描述符，任务返回 nullptr
+        const CmdDesc *desc() const {
+            return _desc.get();
+        }
+
+        // 命令所属的客户端（会话）
+        const void *owner() const {
+            return _desc ? static_cast<const void *>(_desc->session.get()) : _owner;
+        }
+
+    private:
+        CmdDesc::Ptr _desc;
+        Task _task;
+        const void *_owner = nullptr;
+    };
 
-    // 添加命令到队列
+    /**
+    * @brief 创建队列
+    * @param capacity 队列容量，向上取整为 2 的幂
+    */
+    explicit CommandQueue(size_t capacity = 65536) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _mask = size - 1;
+        _slots = std::vector<Slot>(size);
+        for (size_t i = 0; i < size; ++i) {
+            _slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    CommandQueue(const CommandQueue &) = delete;
+    CommandQueue &operator=(const CommandQueue &) = delete;
+
+    // 非阻塞写入，队列满时返回 false（多个生产者线程可并发调用）
+    bool tryPush(Command &cmd) {
+        auto pos = _tail.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &_slots[pos & _mask];
+            auto seq = slot->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // 该槽上一轮的命令尚未被取走，队列已满
+                return false;
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->cmd = std::move(cmd);
+        // 排队时间按 1/16 抽样统计，避免每条命令两次读时钟
+        slot->enqueueTime = (pos & kSampleMask) ? 0 : now();
+        slot->seq.store(pos + 1, std::memory_order_release);
+        wakeup();
+        return true;
+    }
+
+    // 写入命令，队列满时让出 CPU 等待执行线程腾出空间
     void push(Command cmd) {
-        {
-            std::lock_guard<std::mutex> lock(_mutex);
-            _queue.push(std::move(cmd));
+        if (tryPush(cmd)) {
+            return;
         }
-        _condition.notify_one();
+        _fullWaits.fetch_add(1, std::memory_order_relaxed);
+        while (!tryPush(cmd)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // 非阻塞取出命令，队列为空时返回 false（只能在消费者线程中调用）
+    bool tryPop(Command &cmd) {
+        auto pos = _head.load(std::memory_order_relaxed);
+        auto &slot = _slots[pos & _mask];
+        if (slot.seq.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        cmd = std::move(slot.cmd);
+        slot.cmd.reset();       // 及时释放命令持有的会话与参数
+        if (slot.enqueueTime) {
+            recordWait(now() - slot.enqueueTime);
+        }
+        slot.seq.store(pos + _mask + 1, std::memory_order_release);
+        _head.store(pos + 1, std::memory_order_relaxed);
+        return true;
     }
 
-    // 从队列中取出命令
+    // 阻塞取出命令：先自旋，仍为空则休眠直到有命令写入（只能在消费者线程中调用）
     Command pop() {
+        Command cmd;
+        while (true) {
+            for (int i = 0; i < kSpinCount; ++i) {
+                if (tryPop(cmd)) {
+                    return cmd;
+                }
+            }
+            park();
+        }
+    }
+
+    // 当前队列中的命令数（近似值）
+    size_t size() const {
+        auto tail = _tail.load(std::memory_order_relaxed);
+        auto head = _head.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return _mask + 1;
+    }
+
+    // 统计信息：命令在队列中的平均/最大等待时间（微秒）、执行线程休眠次数、队列满时生产者等待次数
+    double avgWaitUs() const {
+        auto count = _popped.load(std::memory_order_relaxed);
+        return count ? _waitNs.load(std::memory_order_relaxed) / 1000.0 / count : 0.0;
+    }
+    double maxWaitUs() const {
+        return _maxWaitNs.load(std::memory_order_relaxed) / 1000.0;
+    }
+    uint64_t waitSamples() const {
+        return _popped.load(std::memory_order_relaxed);
+    }
+    uint64_t parks() const {
+        return _parks.load(std::memory_order_relaxed);
+    }
+    uint64_t fullWaits() const {
+        return _fullWaits.load(std::memory_order_relaxed);
+    }
+
+private:
+    static const int kSpinCount = 256;
+    static const size_t kSampleMask = 15;
+
+    struct Slot {
+        std::atomic<size_t> seq{0};
+        Command cmd;
+        uint64_t enqueueTime = 0;
+    };
+
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 统计只由消费者线程写入
+    void recordWait(uint64_t ns) {
+        _popped.store(_popped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        _waitNs.store(_waitNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        if (ns > _maxWaitNs.load(std::memory_order_relaxed)) {
+            _maxWaitNs.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    // 消费者：标记为休眠后再检查一次队列，避免与生产者的唤醒错过
+    void park() {
+        _sleeping.store(1, std::memory_order_seq_cst);
+        if (!empty()) {
+            _sleeping.store(0, std::memory_order_relaxed);
+            return;
+        }
+        _parks.fetch_add(1, std::memory_order_relaxed);
+#if defined(__linux__)
+        while (_sleeping.load(std::memory_order_acquire) == 1) {
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&_sleeping), FUTEX_WAIT_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+#else
         std::unique_lock<std::mutex> lock(_mutex);
-        _condition.wait(lock, [this]() { return !_queue.empty(); });
-        Command cmd = std::move(_queue.front());
-        _queue.pop();
-        return cmd;
+        _condition.wait(lock, [this]() { return _sleeping.load(std::memory_order_acquire) == 0; });
+#endif
     }
 
-    // 判断当前任务队列是否为空
-    bool empty() {
-        return _queue.empty();
+    // 生产者：只有执行线程处于休眠时才需要唤醒
+    void wakeup() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_sleeping.load(std::memory_order_relaxed) == 0 || _sleeping.exchange(0, std::memory_order_release) == 0) {
+            return;
+        }
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&_sleeping), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+        std::lock_guard<std::mutex> lock(_mutex);
+        _condition.notify_one();
+#endif
     }
 
 private:
-    std::queue<Command> _queue;
+    std::vector<Slot> _slots;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _tail{0};       // 下一个写入位置（生产者竞争）
+    alignas(64) std::atomic<size_t> _head{0};       // 下一个读取位置（只由消费者修改）
+    alignas(64) std::atomic<uint32_t> _sleeping{0}; // 执行线程是否休眠，同时作为 futex 字
+
+    std::atomic<uint64_t> _popped{0};
+    std::atomic<uint64_t> _waitNs{0};
+    std::atomic<uint64_t> _maxWaitNs{0};
+    std::atomic<uint64_t> _parks{0};
+    std::atomic<uint64_t> _fullWaits{0};
+#if !defined(__linux__)
     std::mutex _mutex;
     std::condition_variable _condition;
+#endif
 };
 
 } // namespace toolkit
 
 
-#endif
\ No newline at end of file
+#endif
@@ -2,73 +2,343 @@
 #define CMDQUEUEMANAGER_H
 
 #include <iostream>
+#include <sstream>
+#include <atomic>
 #include <thread>
+#include <vector>
+#include <algorithm>
 #include "CmdQueue.h"
+#include "FairScheduler.h"
+#include "RedisConfig.h"
+#include "RedisStats.h"
+#include "ShardRouter.h"
+#include "Network/Session.h"
+#include "Thread/TaskExecutor.h"
+#include "Util/onceToken.h"
 
 namespace toolkit
 {
-    
-// 命令队列管理器：管理一个后台线程持续从队列中获取命令并执行，同时提供启动和停止线程的机制。
-class CommandQueueManager {
+
+// 命令执行器：一个后台线程持续从自己的命令队列中获取命令并执行。
+// 多执行线程时每个执行器独占键空间的一个分片，实现 TaskExecutor 接口以便 ShardRouter 把命令投递过来。
+class CommandExecutor : public TaskExecutor {
 public:
-    static CommandQueueManager &Instance() {
-        static CommandQueueManager instance;    //C++11 线程安全的局部静态变量
-        return instance;
+    using Ptr = std::shared_ptr<CommandExecutor>;
+
+    /**
+    * @brief 创建执行器并启动执行线程
+    * @param index 执行器编号
+    * @param capacity 命令队列容量
+    */
+    CommandExecutor(size_t index, size_t capacity)
+        : _index(index), _commandQueue(capacity),
+          _scheduler(RedisConfig::Instance().clientBudget, capacity, RedisConfig::Instance().fairScheduling), _stop(false) {
+        // 启动后台线程
+        _workThread = std::thread([this]() {
+            current() = this;
+            this->processCommands();
+        });
+        _workThreadId = _workThread.get_id();
+    }
+    ~CommandExecutor() override {
+        stop();
     }
-    // 禁用拷贝构造和赋值操作
-    CommandQueueManager(const CommandQueueManager &) = delete;
-    CommandQueueManager &operator=(const CommandQueueManager &) = delete;
 
     // 添加命令到队列
     void pushCommand(CommandQueue::Command cmd) {
+        if (isCurrentThread() && !_commandQueue.tryPush(cmd)) {
+            // 执行线程自己投递命令（如事务回放）时不能等待自己腾出空间，暂存到本地，本轮结束后执行
+            _overflow.emplace_back(std::move(cmd));
+            return;
+        }
         _commandQueue.push(std::move(cmd));
     }
+
+    Task::Ptr async(TaskIn task, bool may_sync = true) override {
+        if (may_sync && isCurrentThread()) {
+            task();
+            return nullptr;
+        }
+        auto ret = std::make_shared<Task>(std::move(task));
+        pushCommand([ret]() {
+            (*ret)();
+        });
+        return ret;
+    }
+
+    // 记录本轮执行中产生了回复的会话，本轮结束时统一 flush（仅在执行线程中调用）
+    void addPendingFlush(const Session::Ptr &session) {
+        // 同一会话的 pipeline 命令通常连续执行，只需和最后一个比较即可去掉绝大部分重复
+        if (_pendingFlush.empty() || _pendingFlush.back() != session) {
+            _pendingFlush.emplace_back(session);
+        }
+    }
+
+    bool isCurrentThread() const {
+        return std::this_thread::get_id() == _workThreadId;
+    }
+
+    // 当前线程所属的执行器，非执行线程返回 nullptr
+    static CommandExecutor *&current() {
+        static thread_local CommandExecutor *executor = nullptr;
+        return executor;
+    }
+
+    size_t index() const {
+        return _index;
+    }
+
+    const CommandQueue &queue() const {
+        return _commandQueue;
+    }
+
+    size_t maxDepth() const {
+        return _maxDepth.load(std::memory_order_relaxed);
+    }
+
+    // 等待执行的命令数：命令队列中的加上调度器中暂存的（可在任意线程中调用，近似值）
+    size_t depth() const {
+        return _commandQueue.size() + _scheduled.load(std::memory_order_relaxed);
+    }
+
+    // 调度器中暂存的命令数、有命令排队的客户端数、经优先通道执行的命令数（每轮更新）
+    size_t scheduled() const {
+        return _scheduled.load(std::memory_order_relaxed);
+    }
+    size_t activeClients() const {
+        return _activeClients.load(std::memory_order_relaxed);
+    }
+    uint64_t prioritized() const {
+        return _prioritized.load(std::memory_order_relaxed);
+    }
+
     // 停止任务处理
     void stop() {
-        {
-            std::lock_guard<std::mutex> lock(_mutex);
-            _stop = true;
+        if (_stop.exchange(true, std::memory_order_acq_rel)) {
+            return;
         }
         _commandQueue.push([] {});  // 推入空任务以唤醒线程
         if(_workThread.joinable()) {
             _workThread.join();
         }
     }
+
 private:
-    // 构造与析构函数
-    CommandQueueManager() : _stop(false) {
-        // 启动后台线程
-        _workThread = std::thread([this]() {
-            this->processCommands();
-        });
-    }
-    ~CommandQueueManager() {
-        stop();
-    }
     // 后台线程处理命令
+    // 每轮先把命令队列中已到达的命令取出交给公平调度器（按客户端分到各自的子队列），再按调度顺序执行：
+    // 优先通道中的控制命令先执行，其余客户端轮流执行，每次至多 clientBudget 条。
+    // 每执行 clientBudget 条就取一次新到达的命令：仍只有一个客户端在排队时继续执行，本轮至多 executorBatch 条；
+    // 出现其它客户端的命令时立即结束本轮，轻量客户端的命令与回复不必等重客户端的整批命令执行完。
+    // 这一轮中各会话产生的回复只暂存在 socket 的发送缓存里，结束时每个会话 flush 一次，合并为一次 sendmsg；
+    // 多执行线程时回复由 ShardRouter 暂存，本轮结束时每个会话投递一次
     void processCommands() {
+        auto batch = RedisConfig::Instance().executorBatch;
+        auto budget = std::min(RedisConfig::Instance().clientBudget, batch);
+        ShardRouter::Outbox outbox;
+        ShardRouter::Outbox::current() = &outbox;
+        CommandQueue::Command cmd;
+        auto executeOne = [this](CommandQueue::Command &cmd) {
+            execute(cmd);
+        };
         while (true) {
-            auto cmd = _commandQueue.pop();
-            {
-                std::lock_guard<std::mutex> lock(_mutex);
-                if(_stop && _commandQueue.empty()) {
+            if (_scheduler.empty()) {
+                if (!_commandQueue.tryPop(cmd)) {
+                    startSleep();
+                    cmd = _commandQueue.pop();
+                    sleepWakeUp();
+                }
+                _scheduler.push(std::move(cmd));
+            }
+            schedule();
+            if (_stop.load(std::memory_order_acquire) && _commandQueue.empty()) {
+                break;
+            }
+            auto depth = _commandQueue.size() + _scheduler.size();
+            if (depth > _maxDepth.load(std::memory_order_relaxed)) {
+                _maxDepth.store(depth, std::memory_order_relaxed);
+            }
+            size_t count = 0;
+            while (true) {
+                count += _scheduler.drain(std::min(budget, batch - count), executeOne);
+                if (count >= batch || _scheduler.empty()) {
+                    break;
+                }
+                schedule();
+                if (_scheduler.contended()) {
                     break;
                 }
             }
-            try {
-                cmd();  //执行命令
-            } catch (const std::exception &ex) {
-                std::cerr << "Command execution error: " << ex.what() <<std::endl;
+            _scheduled.store(_scheduler.size(), std::memory_order_relaxed);
+            _activeClients.store(_scheduler.activeClients(), std::memory_order_relaxed);
+            _prioritized.store(_scheduler.prioritized(), std::memory_order_relaxed);
+            executeOverflow();
+            outbox.flush();
+            flushPending();
+        }
+        ShardRouter::Outbox::current() = nullptr;
+    }
+
+    // 把命令队列中已到达的命令交给调度器
+    void schedule() {
+        CommandQueue::Command cmd;
+        while (!_scheduler.full() && _commandQueue.tryPop(cmd)) {
+            _scheduler.push(std::move(cmd));
+        }
+    }
+
+    void executeOverflow() {
+        while (!_overflow.empty()) {
+            auto overflow = std::move(_overflow);
+            _overflow.clear();
+            for (auto &cmd : overflow) {
+                execute(cmd);
             }
         }
     }
+
+    void execute(CommandQueue::Command &cmd) {
+        try {
+            cmd();  //执行命令
+        } catch (const std::exception &ex) {
+            std::cerr << "Command execution error: " << ex.what() <<std::endl;
+        }
+        // 执行完立即释放，空闲等待时不占着会话的接收缓存（否则 poller 无法原地复用）
+        cmd.reset();
+    }
+
+    void flushPending() {
+        for (auto &session : _pendingFlush) {
+            session->flushReplies();
+        }
+        _pendingFlush.clear();
+    }
+
+    size_t _index;
     CommandQueue _commandQueue;
+    FairScheduler _scheduler;                   // 只由执行线程访问
+    std::vector<Session::Ptr> _pendingFlush;    // 本轮执行中待 flush 的会话
+    std::vector<CommandQueue::Command> _overflow;   // 队列满时执行线程自己投递的命令
+    std::atomic<size_t> _maxDepth{0};           // 执行线程每轮开始时观察到的最大队列深度（含调度器中暂存的命令）
+    std::atomic<size_t> _scheduled{0};
+    std::atomic<size_t> _activeClients{0};
+    std::atomic<uint64_t> _prioritized{0};
     std::thread _workThread;
-    std::mutex _mutex;
-    bool _stop;
+    std::thread::id _workThreadId;
+    std::atomic<bool> _stop;
+};
+
+// 命令队列管理器：管理 executorThreads 个执行器，同时提供启动和停止线程的机制。
+// 只有一个执行器时所有命令进入同一个队列；多个执行器时命令由 ShardRouter 按键的哈希投递到键所属的执行器，
+// 同一个键的命令总在同一个线程上按序执行，不同分片的键并行执行。
+class CommandQueueManager : public TaskExecutorGetterImp {
+public:
+    static CommandQueueManager &Instance() {
+        static CommandQueueManager instance;    //C++11 线程安全的局部静态变量
+        return instance;
+    }
+    // 禁用拷贝构造和赋值操作
+    CommandQueueManager(const CommandQueueManager &) = delete;
+    CommandQueueManager &operator=(const CommandQueueManager &) = delete;
+
+    // 添加命令到第一个执行器的队列（单执行器模式）
+    void pushCommand(CommandQueue::Command cmd) {
+        executor(0)->pushCommand(std::move(cmd));
+    }
+
+    // 把属于会话的任务作为该会话的一条命令放入命令队列（单执行器模式），与该会话此前入队的命令按顺序执行
+    // 用于 EXEC 与 poller 线程中需要排在已入队命令之后发送的回复
+    void pushSessionTask(const Session::Ptr &session, std::function<void()> task) {
+        session->getReplySequencer()->beginQueued();
+        pushCommand(CommandQueue::Command([this, session, task]() {
+            if (RedisConfig::Instance().replyBatching) {
+                addPendingFlush(session);
+            }
+            // task 抛出异常时也要结束排队，否则该会话再也不会静止，poller 读与空闲检测都会失效
+            onceToken token(nullptr, [session]() {
+                session->getReplySequencer()->endQueued();
+            });
+            task();
+        }, session.get()));
+    }
+
+    // 单执行器模式下等待执行的命令数
+    size_t depth() const {
+        return executor(0)->depth();
+    }
+
+    // 记录本轮执行中产生了回复的会话，本轮结束时统一 flush（仅在执行线程中调用）
+    void addPendingFlush(const Session::Ptr &session) {
+        if (auto executor = CommandExecutor::current()) {
+            executor->addPendingFlush(session);
+        }
+    }
+
+    CommandExecutor::Ptr executor(size_t index) const {
+        return std::static_pointer_cast<CommandExecutor>(_threads[index]);
+    }
+
+    // INFO 命令中的队列统计，多个执行器时为汇总值
+    std::string info() {
+        size_t depth = 0, maxDepth = 0, scheduled = 0, activeClients = 0;
+        uint64_t samples = 0, parks = 0, fullWaits = 0, prioritized = 0;
+        double waitUs = 0, maxWaitUs = 0;
+        for (size_t i = 0; i < _threads.size(); ++i) {
+            auto &queue = executor(i)->queue();
+            depth += queue.size();
+            maxDepth = std::max(maxDepth, executor(i)->maxDepth());
+            samples += queue.waitSamples();
+            waitUs += queue.avgWaitUs() * queue.waitSamples();
+            maxWaitUs = std::max(maxWaitUs, queue.maxWaitUs());
+            parks += queue.parks();
+            fullWaits += queue.fullWaits();
+            scheduled += executor(i)->scheduled();
+            activeClients += executor(i)->activeClients();
+            prioritized += executor(i)->prioritized();
+        }
+        std::ostringstream oss;
+        oss << "executor_threads:" << _threads.size() << "\r\n";
+        oss << "executor_queue_capacity:" << executor(0)->queue().capacity() << "\r\n";
+        oss << "executor_queue_depth:" << depth << "\r\n";
+        oss << "executor_queue_depth_max:" << maxDepth << "\r\n";
+        oss << "executor_queue_wait_avg_us:" << (samples ? waitUs / samples : 0.0) << "\r\n";
+        oss << "executor_queue_wait_max_us:" << maxWaitUs << "\r\n";
+        oss << "executor_parks:" << parks << "\r\n";
+        oss << "executor_queue_full_waits:" << fullWaits << "\r\n";
+        oss << "executor_fair_scheduling:" << (RedisConfig::Instance().fairScheduling ? 1 : 0) << "\r\n";
+        oss << "executor_client_budget:" << RedisConfig::Instance().clientBudget << "\r\n";
+        oss << "executor_scheduled:" << scheduled << "\r\n";
+        oss << "executor_active_clients:" << activeClients << "\r\n";
+        oss << "executor_prioritized:" << prioritized << "\r\n";
+        oss << "executor_load:";
+        auto loads = getExecutorLoad();
+        for (size_t i = 0; i < loads.size(); ++i) {
+            oss << (i ? "," : "") << loads[i];
+        }
+        oss << "\r\n";
+        return oss.str();
+    }
+
+    // 停止任务处理
+    void stop() {
+        for (auto &thread : _threads) {
+            std::static_pointer_cast<CommandExecutor>(thread)->stop();
+        }
+    }
+private:
+    // 构造与析构函数
+    CommandQueueManager() {
+        auto &config = RedisConfig::Instance();
+        auto count = std::max<size_t>(config.executorThreads, 1);
+        for (size_t i = 0; i < count; ++i) {
+            _threads.emplace_back(std::make_shared<CommandExecutor>(i, config.commandQueueSize));
+        }
+    }
+    ~CommandQueueManager() {
+        stop();
+    }
 };
 
 } // namespace toolkit
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,49 @@
+#include <cstring>
+#include "CommandTable.h"
+
+namespace toolkit
+{
+
+constexpr CommandSpec CommandTable::kCommands[];
+constexpr size_t CommandTable::kCount;
+constexpr size_t CommandTable::kSlots;
+constexpr uint32_t CommandTable::kMaxSeed;
+
+// 编译期找到的完美哈希种子；新增命令后找不到时应增大 kSlots
+static constexpr uint32_t kSeed = CommandTable::findSeed(0);
+static_assert(kSeed < CommandTable::kMaxSeed, "no perfect hash seed for the command table, increase kSlots");
+static_assert(CommandTable::kCount < 0xFF, "command index must fit in uint8_t");
+
+// 槽位 -> 命令下标，空槽为 0xFF
+struct SlotIndex {
+    uint8_t slots[CommandTable::kSlots];
+
+    SlotIndex() {
+        memset(slots, 0xFF, sizeof(slots));
+        for (size_t i = 0; i < CommandTable::kCount; ++i) {
+            slots[CommandTable::slotOf(i, kSeed)] = static_cast<uint8_t>(i);
+        }
+    }
+};
+
+// 按大小写折叠比较命令名
+static bool equalsFolded(const char *name, const StrView &input) {
+    size_t i = 0;
+    for (; name[i]; ++i) {
+        if (i == input.size() || CommandTable::fold(input[i]) != name[i]) {
+            return false;
+        }
+    }
+    return i == input.size();
+}
+
+const CommandSpec *CommandTable::lookup(const StrView &name) {
+    static const SlotIndex index;
+    auto i = index.slots[slotOf(name.data(), name.size(), kSeed)];
+    if (i == 0xFF || !equalsFolded(kCommands[i].name, name)) {
+        return nullptr;
+    }
+    return &kCommands[i];
+}
+
+} // namespace toolkit
@@ -0,0 +1,153 @@
+#ifndef COMMANDTABLE_H
+#define COMMANDTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "CmdArgs.h"
+#include "Global.h"
+
+namespace toolkit
+{
+
+// 命令标志（COMMAND 的 flags 字段）
+enum CommandFlag : uint32_t {
+    CMD_WRITE = 1 << 0,         // 可能修改数据
+    CMD_READONLY = 1 << 1,      // 只读取数据
+    CMD_ADMIN = 1 << 2,         // 管理命令
+    CMD_FAST = 1 << 3,          // 时间复杂度为 O(1) 或 O(log N)
+    CMD_CONTROL = 1 << 4,       // 连接与服务器的控制命令，执行线程优先调度（不在 COMMAND 中输出）
+    CMD_DENYOOM = 1 << 5,       // 可能增加内存，超出 maxmemory 且无法淘汰时拒绝执行
+};
+
+// 一条命令的元数据
+struct CommandSpec {
+    const char *name;           // 小写命令名
+    Command id;
+    int arity;                  // 参数个数（含命令名），负数 -N 表示至少 N 个
+    uint32_t flags;             // CommandFlag 的组合
+    int firstKey;               // 第一个键的位置，0 表示不带键
+    int lastKey;                // 最后一个键的位置，-1 表示直到最后一个参数
+    int keyStep;                // 相邻两个键的间隔
+    const char *dataType;       // 操作的数据类型（DataManager 中的类型名），nullptr 表示作用于整个键空间
+};
+
+// 编译期命令表
+// 命令名按大小写折叠后做完美哈希：种子在编译期搜索，保证表中每个命令落在不同的槽位，
+// 查找只需计算一次哈希、比较一次命令名，新增命令时无需手工调整。
+class CommandTable {
+public:
+    static constexpr CommandSpec kCommands[] = {
+        // name         id          arity  flags                              first last step type
+        {"get",         GET,        2,   CMD_READONLY | CMD_FAST,             1,  1,  1, "STRING"},
+        {"set",         SET,        -3,  CMD_WRITE | CMD_DENYOOM,             1,  1,  1, "STRING"},
+        {"strlen",      STRLEN,     2,   CMD_READONLY | CMD_FAST,             1,  1,  1, "STRING"},
+        {"append",      APPEND,     3,   CMD_WRITE | CMD_DENYOOM | CMD_FAST,  1,  1,  1, "STRING"},
+        {"incr",        INCR,       2,   CMD_WRITE | CMD_DENYOOM | CMD_FAST,  1,  1,  1, "STRING"},
+        {"incrby",      INCRBY,     3,   CMD_WRITE | CMD_DENYOOM | CMD_FAST,  1,  1,  1, "STRING"},
+        {"decr",        DECR,       2,   CMD_WRITE | CMD_DENYOOM | CMD_FAST,  1,  1,  1, "STRING"},
+        {"decrby",      DECRBY,     3,   CMD_WRITE | CMD_DENYOOM | CMD_FAST,  1,  1,  1, "STRING"},
+        {"setex",       SETEX,      4,   CMD_WRITE | CMD_DENYOOM,             1,  1,  1, "STRING"},
+        {"mset",        MSET,       -3,  CMD_WRITE | CMD_DENYOOM,             1, -1,  2, "STRING"},
+        {"mget",        MGET,       -2,  CMD_READONLY | CMD_FAST,             1, -1,  1, "STRING"},
+        {"hset",        HSET,       4,   CMD_WRITE | CMD_DENYOOM | CMD_FAST,  1,  1,  1, "HASH"},
+        {"hget",        HGET,       3,   CMD_READONLY | CMD_FAST,             1,  1,  1, "HASH"},
+        {"hmset",       HMSET,      -4,  CMD_WRITE | CMD_DENYOOM | CMD_FAST,  1,  1,  1, "HASH"},
+        {"hmget",       HMGET,      -3,  CMD_READONLY | CMD_FAST,             1,  1,  1, "HASH"},
+        {"hdel",        HDEL,       -3,  CMD_WRITE | CMD_FAST,                1,  1,  1, "HASH"},
+        {"hgetall",     HGETALL,    2,   CMD_READONLY,                        1,  1,  1, "HASH"},
+        {"hscan",       HSCAN,      -3,  CMD_READONLY,                        1,  1,  1, "HASH"},
+        {"lpush",       LPUSH,      -3,  CMD_WRITE | CMD_DENYOOM | CMD_FAST,  1,  1,  1, "LIST"},
+        {"rpush",       RPUSH,      -3,  CMD_WRITE | CMD_DENYOOM | CMD_FAST,  1,  1,  1, "LIST"},
+        {"lpop",        LPOP,       2,   CMD_WRITE | CMD_FAST,                1,  1,  1, "LIST"},
+        {"rpop",        RPOP,       2,   CMD_WRITE | CMD_FAST,                1,  1,  1, "LIST"},
+        {"lrange",      LRANGE,     4,   CMD_READONLY,                        1,  1,  1, "LIST"},
+        {"sadd",        SADD,       -3,  CMD_WRITE | CMD_DENYOOM | CMD_FAST,  1,  1,  1, "SET"},
+        {"srem",        SREM,       -3,  CMD_WRITE | CMD_FAST,                1,  1,  1, "SET"},
+        {"smembers",    SMEMBERS,   2,   CMD_READONLY,                        1,  1,  1, "SET"},
+        {"sismember",   SISMEMEBER, 3,   CMD_READONLY | CMD_FAST,             1,  1,  1, "SET"},
+        {"sscan",       SSCAN,      -3,  CMD_READONLY,                        1,  1,  1, "SET"},
+        {"del",         DEL,        -2,  CMD_WRITE,                           1, -1,  1, nullptr},
+        {"exists",      EXISTS,     2,   CMD_READONLY | CMD_FAST,             1,  1,  1, nullptr},
+        {"type",        TYPE,       2,   CMD_READONLY | CMD_FAST,             1,  1,  1, nullptr},
+        {"expire",      EXPIRE,     3,   CMD_WRITE | CMD_FAST,                1,  1,  1, nullptr},
+        {"pexpire",     PEXPIRE,    3,   CMD_WRITE | CMD_FAST,                1,  1,  1, nullptr},
+        {"ttl",         TTL,        2,   CMD_READONLY | CMD_FAST,             1,  1,  1, nullptr},
+        {"persist",     PERSIST,    2,   CMD_WRITE | CMD_FAST,                1,  1,  1, nullptr},
+        {"keys",        KEYS,       2,   CMD_READONLY,                        0,  0,  0, nullptr},
+        {"scan",        SCAN,       -2,  CMD_READONLY,                        0,  0,  0, nullptr},
+        {"dbsize",      DBSIZE,     1,   CMD_READONLY | CMD_FAST,             0,  0,  0, nullptr},
+        {"select",      SELECT,     2,   CMD_FAST,                            0,  0,  0, nullptr},
+        {"multi",       MULTI,      1,   CMD_FAST | CMD_CONTROL,              0,  0,  0, nullptr},
+        {"exec",        EXEC,       1,   0,                                   0,  0,  0, nullptr},
+        {"discard",     DISCARD,    1,   CMD_FAST | CMD_CONTROL,              0,  0,  0, nullptr},
+        {"watch",       WATCH,      -2,  CMD_FAST | CMD_CONTROL,              1, -1,  1, nullptr},
+        {"unwatch",     UNWATCH,    1,   CMD_FAST | CMD_CONTROL,              0,  0,  0, nullptr},
+        {"memory",      MEMORY,     -2,  CMD_READONLY,                        0,  0,  0, nullptr},
+        {"info",        INFO,       -1,  CMD_CONTROL,                         0,  0,  0, nullptr},
+        {"command",     COMMAND,    -1,  CMD_CONTROL,                         0,  0,  0, nullptr},
+        {"ping",        PING,       -1,  CMD_FAST | CMD_CONTROL,              0,  0,  0, nullptr},
+    };
+    static constexpr size_t kCount = sizeof(kCommands) / sizeof(kCommands[0]);
+    static constexpr size_t kSlots = 512;   // 槽位数（2 的幂），约为命令数的 10 倍，种子通常几次就能找到
+
+    // 按命令名查找（不区分大小写），不存在返回 nullptr
+    static const CommandSpec *lookup(const StrView &name);
+
+    // 依次访问命令中的键（按 firstKey/lastKey/keyStep）
+    template <typename Func>
+    static void forEachKey(const CommandSpec &spec, const CmdArgs &args, Func &&func) {
+        if (spec.firstKey <= 0) {
+            return;
+        }
+        auto count = static_cast<int>(args.size());
+        auto last = spec.lastKey < 0 ? count + spec.lastKey : spec.lastKey;
+        for (int i = spec.firstKey; i <= last && i < count; i += spec.keyStep) {
+            func(args[i]);
+        }
+    }
+
+    // 本表在 kCommands 中的下标
+    static size_t indexOf(const CommandSpec &spec) {
+        return static_cast<size_t>(&spec - kCommands);
+    }
+
+    // 以下为完美哈希的编译期计算，查找时使用同样的函数
+
+    static constexpr char fold(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    static constexpr size_t length(const char *s) {
+        return *s ? 1 + length(s + 1) : 0;
+    }
+    // 大小写折叠后的 FNV-1a
+    static constexpr uint32_t hash(const char *s, size_t len, uint32_t h) {
+        return len == 0 ? h : hash(s + 1, len - 1, (h ^ static_cast<uint8_t>(fold(*s))) * 16777619u);
+    }
+    static constexpr size_t slotOf(const char *s, size_t len, uint32_t seed) {
+        return mix(hash(s, len, 2166136261u ^ (seed * 0x9E3779B9u))) & (kSlots - 1);
+    }
+    static constexpr size_t slotOf(size_t i, uint32_t seed) {
+        return slotOf(kCommands[i].name, length(kCommands[i].name), seed);
+    }
+    // seed 下所有命令的槽位互不相同
+    static constexpr bool perfect(uint32_t seed, size_t i = 0) {
+        return i >= kCount || (distinct(seed, i, i + 1) && perfect(seed, i + 1));
+    }
+    static constexpr uint32_t findSeed(uint32_t seed) {
+        return seed >= kMaxSeed || perfect(seed) ? seed : findSeed(seed + 1);
+    }
+
+    static constexpr uint32_t kMaxSeed = 256;
+
+private:
+    static constexpr uint32_t mix(uint32_t h) {
+        return h ^ (h >> 15);
+    }
+    static constexpr bool distinct(uint32_t seed, size_t i, size_t j) {
+        return j >= kCount || (slotOf(i, seed) != slotOf(j, seed) && distinct(seed, i, j + 1));
+    }
+};
+
+} // namespace toolkit
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "DataType.h"
 
 namespace toolkit
@@ -21,65 +23,87 @@ public:
         persistDataToDisk(true);     // 析构时同步刷盘
     }
 
-    DataManager(int dbIndex){
+    /**
+    * @brief 创建数据库
+    * @param dbIndex 数据库编号
+    * @param shardCount 分片数，分片模式下每个分片有独立的键空间，由对应的 poller 线程独占访问
+    */
+    DataManager(int dbIndex, size_t shardCount = 1){
         persistenceManager_ = std::make_shared<PersistenceManager>(dbIndex);
+        shards_.resize(shardCount);
+        for (size_t i = 0; i < shardCount; ++i) {
+            auto &shard = shards_[i];
+            // 各类型视图共享同一个键空间
+            shard.keyspace = std::make_shared<Keyspace>(i, shardCount);
+            shard.strings = std::make_shared<RedisString>(shard.keyspace);
+            shard.hashes = std::make_shared<RedisHash>(shard.keyspace);
+            shard.lists = std::make_shared<RedisList>(shard.keyspace);
+            shard.sets = std::make_shared<RedisSet>(shard.keyspace);
+            shard.dataStore["STRING"] = shard.strings;
+            shard.dataStore["HASH"] = shard.hashes;
+            shard.dataStore["LIST"] = shard.lists;
+            shard.dataStore["SET"] = shard.sets;
+        }
     }
 
 public:
 
-    // 根据数据类型获取相应的 RedisDataType 的实例化指针
-    RedisDataType::Ptr& getDataType(std::string& type) {
-        auto it = dataStore_.find(type);
-        if(it == dataStore_.end() || !it->second) {
-            // 如果 type 对应的键不存在或为空，则根据类型创建
-            if (type == "STRING") {
-                createKey<RedisString>(type);
-            } else if (type == "HASH") {
-                createKey<RedisHash>(type);
-            } else if (type == "LIST") {
-                createKey<RedisList>(type);
-            } else if (type == "SET") {
-                createKey<RedisSet>(type);
-            } else {
-                throw std::invalid_argument("Unsupported Redis data type: " + type);
-            }
-        }
-        return dataStore_[type];
-    } 
+    // 当前线程所属分片上数据类型 T（RedisString/RedisHash/...）的视图，编译期按类型选择，不需要按类型名查找
+    template <typename T>
+    T &store() {
+        return view(static_cast<T *>(nullptr));
+    }
 
-    // 持久化所有数据到磁盘
+    // 持久化所有数据到磁盘，各分片的快照按类型拼接在一起（只在没有其它线程访问数据时调用，如析构）
     void persistDataToDisk(bool sync) {
         std::unordered_map<std::string, std::string> validiSnapshot;
-        for (const auto& [key,value] : dataStore_) {
-            validiSnapshot[key] = value->serialize();
+        for (auto &shard : shards_) {
+            for (const auto& [key,value] : shard.dataStore) {
+                validiSnapshot[key] += value->serialize();
+            }
         }
         persistenceManager_->persistToDisk(validiSnapshot, sync);
     }
 
-    // 从磁盘加载数据到内存
-    void loadDataFromDisk() {
-        persistenceManager_->loadFromDisk(dataStore_);
+    // 当前线程所属分片的快照：类型名 -> 序列化数据（只能在拥有该分片的线程中调用）
+    std::unordered_map<std::string, std::string> snapshotShard() {
+        std::unordered_map<std::string, std::string> snapshot;
+        for (const auto& [key,value] : shard().dataStore) {
+            snapshot[key] = value->serialize();
+        }
+        return snapshot;
     }
 
-    // 创建一个新的键，指定类型
-    template <typename T>
-    void createKey(const std::string& key) {
-        if (dataStore_.count(key)) {
-            throw std::runtime_error("Key already exists with a different type");
+    // 把各分片在各自线程中生成的快照按类型拼接后写入磁盘，可在任意线程中调用
+    void persistSnapshots(const std::vector<std::unordered_map<std::string, std::string>> &snapshots, bool sync) {
+        std::unordered_map<std::string, std::string> validiSnapshot;
+        for (auto &snapshot : snapshots) {
+            for (const auto& [key,value] : snapshot) {
+                validiSnapshot[key] += value;
+            }
+        }
+        persistenceManager_->persistToDisk(validiSnapshot, sync);
+    }
+
+    // 从磁盘加载数据到内存，每个分片只保留属于自己的键
+    void loadDataFromDisk() {
+        for (auto &shard : shards_) {
+            persistenceManager_->loadFromDisk(shard.dataStore);
         }
-        dataStore_[key] = std::make_shared<T>();
     }
 
     // KEYS 命令调用
     std::vector<std::string> keys(const std::string& pattern) {
         std::vector<std::string> result;
+        auto &keyspace = shard().keyspace;
+
+        result.reserve(keyspace->size());
 
         // 特殊模式 "*" 处理
         if (pattern == "*") {
-            for (const auto& [key, data] : dataStore_) {
-                auto allKeys = data->getAllKeys();
-                result.insert(result.end(), allKeys.begin(), allKeys.end());
-            }
+            keyspace->forEach([&](const std::string& key, const RedisObject&) {
+                result.push_back(key);
+            });
             return result;
         }
 
@@ -87,45 +111,113 @@ public:
         std::regex regexPattern(wildcardToRegex(pattern));
 
         // 正则匹配
-        for (const auto& [key, data] : dataStore_) {
-            auto matchedKeys = data->keys(regexPattern);
-            result.insert(result.end(), matchedKeys.begin(), matchedKeys.end());
-        }
+        keyspace->forEach([&](const std::string& key, const RedisObject&) {
+            if (std::regex_match(key, regexPattern)) {
+                result.push_back(key);
+            }
+        });
         return result;
     }
 
+    // SCAN 命令调用，见 Keyspace::scan
+    template <typename Func>
+    size_t scanKeys(size_t cursor, size_t count, Func &&func) {
+        return shard().keyspace->scan(cursor, count, std::forward<Func>(func));
+    }
+
     // DEL命令调用
     bool eraseKey(const std::string& key) {
-        for (const auto& [type, data] : dataStore_) {
-            if(data->search(key)) {
-                data->erase(key);
-                return true;
-            }    
-        }
-        return false;
+        return shard().keyspace->erase(key);
     }
     // 键总数（dbsize）
     int dbsize() {
-        int sum = 0;
-        for (const auto& [type, data] : dataStore_) {
-            sum += data->getsize();
-        }
-        return sum;
+        return static_cast<int>(shard().keyspace->size());
     }
     // 搜索键
     bool searchKey(const std::string& key) {
-        for (const auto& [type, data] : dataStore_) {
-            if(data->search(key)) {
-                return true;
-            }    
-        }
-        return false;
+        return shard().keyspace->lookup(key) != nullptr;
+    }
+    // 设置键的过期时间，kNoExpire 表示取消，键不存在返回 false
+    bool setExpire(const std::string& key, int64_t at) {
+        return shard().keyspace->setExpire(key, at);
+    }
+    // 键的过期时刻：键不存在返回 -2，没有过期时间返回 kNoExpire（-1）
+    int64_t expireAt(const std::string& key) {
+        auto obj = shard().keyspace->lookup(key);
+        return obj ? obj->expireAt() : -2;
+    }
+    // 主动过期，deadline 为 getCurrentMicrosecond 的时间戳
+    size_t activeExpire(uint64_t deadline) {
+        return shard().keyspace->activeExpire(deadline);
+    }
+    // 带过期时间的键数
+    size_t expires() {
+        return shard().keyspace->expires();
+    }
+    // 淘汰抽样，见 Keyspace::sample
+    template <typename Func>
+    void sampleKeys(size_t start, size_t count, bool volatileOnly, Func &&func) {
+        shard().keyspace->sample(start, count, volatileOnly, std::forward<Func>(func));
+    }
+    // 淘汰键，返回估算释放的内存，键不存在返回 0
+    size_t evictKey(const std::string& key) {
+        return shard().keyspace->evict(key);
+    }
+    // 键占用内存的估算，见 Keyspace::keyMemoryUsage
+    bool keyMemoryUsage(const std::string& key, size_t samples, size_t &bytes) {
+        return shard().keyspace->keyMemoryUsage(key, samples, bytes);
+    }
+    // 内存的分类统计，累加到 stats
+    void memoryStats(MemoryStats &stats) {
+        shard().keyspace->memoryStats(stats);
+    }
+    // 键的版本号（WATCH），见 Keyspace::keyVersion
+    uint64_t keyVersion(const char *data, size_t len) {
+        return shard().keyspace->keyVersion(data, len);
+    }
+    // 键被写命令修改
+    void touchKey(const char *data, size_t len) {
+        shard().keyspace->touchKey(data, len);
+    }
+    // 空闲时推进键空间的渐进式 rehash
+    void activeRehash(int ms) {
+        shard().keyspace->activeRehash(ms);
+    }
+    // 在非所有者线程中查找键（需在 Epoch::Guard 内），按键的哈希直接定位所属分片
+    const RedisObject *lookupShared(const std::string& key) {
+        auto index = Keyspace::shardOf(key.data(), key.size(), shards_.size());
+        return shards_[index].keyspace->lookupShared(key);
+    }
+    // 键的类型（TYPE 命令），不存在返回 "none"
+    const char *keyType(const std::string& key) {
+        auto obj = shard().keyspace->lookup(key);
+        return obj ? RedisObject::typeName(obj->type()) : "none";
     }
 private:
     
     
-    // 存储键值对，值是抽象的数据类型
-    std::unordered_map<std::string, std::shared_ptr<RedisDataType>> dataStore_;
+    struct Shard {
+        Keyspace::Ptr keyspace;     // 本分片的键空间
+        // 各类型在键空间上的视图
+        std::shared_ptr<RedisString> strings;
+        std::shared_ptr<RedisHash> hashes;
+        std::shared_ptr<RedisList> lists;
+        std::shared_ptr<RedisSet> sets;
+        // 类型名 -> 上面的视图，只用于按类型名持久化与加载
+        std::unordered_map<std::string, std::shared_ptr<RedisDataType>> dataStore;
+    };
+
+    RedisString &view(RedisString *) { return *shard().strings; }
+    RedisHash &view(RedisHash *) { return *shard().hashes; }
+    RedisList &view(RedisList *) { return *shard().lists; }
+    RedisSet &view(RedisSet *) { return *shard().sets; }
+
+    // 当前线程所属的分片
+    Shard &shard() {
+        return shards_[Keyspace::currentShard()];
+    }
+
+    std::vector<Shard> shards_;                     // 不分片时只有一个
     PersistenceManager::Ptr persistenceManager_;    // 持久化管理器
 
     std::string regex_escape(const std::string& str) {
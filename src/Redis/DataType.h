@@ -3,53 +3,51 @@
 
 #include <vector>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
 #include <list>
 #include <regex>
-#include "SkipList.h"
+#include "Keyspace.h"
+#include "CmdArgs.h"
 namespace toolkit
 {
 // 抽象的 Redis 数据类型接口
+// 所有类型的键都保存在同一个 Keyspace 中，各子类是该键空间上按类型操作的视图
 class RedisDataType {
 
 public:
 
     using Ptr = std::shared_ptr<RedisDataType>;
+
+    explicit RedisDataType(Keyspace::Ptr keyspace) : keyspace_(std::move(keyspace)) {}
     virtual ~RedisDataType() = default;
 
-    // // 插入数据
-    // virtual void insert(const std::vector<std::string>& args) = 0;
-    // // 查询数据
-    // virtual std::string get(const std::vector<std::string>& args) const = 0;
-    // // 删除数据
-    // virtual bool remove(const std::vector<std::string>& args) = 0;
-    
     // 获取类型名称（如 "hash", "set", "list"）
     virtual std::string getType() const = 0;
-    // 序列化和反序列化
+    // 序列化和反序列化（只处理本类型的键）
     virtual std::string serialize() const = 0;
     virtual void deserialize(const std::string& data) = 0;
     // 获取匹配的键
-    virtual std::vector<std::string> keys(const std::regex& regexPattern) const = 0;
+    virtual std::vector<std::string> keys(const std::regex& regexPattern) const;
     // 得到所有键
-    virtual std::vector<std::string> getAllKeys() const = 0;
+    virtual std::vector<std::string> getAllKeys() const;
     // 搜索键是否存在
-    virtual bool search(const std::string & key) const = 0;
+    virtual bool search(const std::string & key) const;
     // 删除键
-    virtual bool erase(const std::string& key) = 0;
+    virtual bool erase(const std::string& key);
     // 获得相应类型的键总数
-    virtual int getsize() const = 0;
+    virtual int getsize() const;
+
+protected:
+    // 本视图对应的类型标签
+    virtual ObjectType objectType() const = 0;
 
+    Keyspace::Ptr keyspace_;
 };
 
 class RedisHash : public RedisDataType{
 public:
+    explicit RedisHash(Keyspace::Ptr keyspace) : RedisDataType(std::move(keyspace)) {}
+
     virtual std::string getType() const override;
-    virtual std::vector<std::string> keys(const std::regex& regexPattern) const;
-    std::vector<std::string> getAllKeys() const;
-    virtual bool search(const std::string & key) const override;
-    virtual bool erase(const std::string& key) override;
     // 序列化：将哈希表内容序列化为字符串
     std::string serialize() const override;
 
@@ -59,63 +57,59 @@ public:
     // HSET: 设置字段值
     void hset(const std::string& key, const std::string& field, const std::string& value);
 
-    // HGET: 获取字段值
-    std::shared_ptr<std::string> hget(const std::string& key, const std::string& field) const ;
+    // HGET: 获取字段值，不存在返回 nullptr
+    const std::string *hget(const std::string& key, const std::string& field) const ;
 
     // HDEL: 删除字段
     bool hdel(const std::string& key, const std::string& field);
 
     // HGETALL: 获取所有字段及其值
-    std::unordered_map<std::string, std::string> hgetall(const std::string& key) const ;
+    std::vector<std::pair<std::string, std::string>> hgetall(const std::string& key) const ;
 
-    int getsize() const {
-        return hashData_.size();
-    }
-private:
-    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> hashData_;
+    // HSCAN: 从 cursor 起遍历字段，至少取出 count 个（或遍历结束）追加到 result，返回下一个游标（0 表示结束）
+    size_t hscan(const std::string& key, size_t cursor, size_t count, std::vector<std::pair<std::string, std::string>>& result) const;
 
+protected:
+    ObjectType objectType() const override { return OBJ_HASH; }
 };
 
 
 class RedisSet : public RedisDataType {
-private:
-    std::unordered_map<std::string, std::unordered_set<std::string>> setData_;
 public:
-    // 序列化：将跳表内容序列化为字符串
+    explicit RedisSet(Keyspace::Ptr keyspace) : RedisDataType(std::move(keyspace)) {}
+
+    // 序列化：将集合内容序列化为字符串
     std::string serialize() const override;
-    // 反序列化：从字符串恢复跳表
+    // 反序列化：从字符串恢复集合
     void deserialize(const std::string& data) override ;
     // SADD: 添加元素到集合
     void sadd(const std::string& key, const std::string& value);
     // SREM: 从集合中删除元素
     bool srem(const std::string& key, const std::string& value);
     // SMEMBERS: 获取集合中的所有元素
-    std::unordered_set<std::string> smembers(const std::string& key) const;
+    std::vector<std::string> smembers(const std::string& key) const;
     // SISMEMBER: 检查元素是否在集合中
     bool sismember(const std::string& key, const std::string& value) const;
+    // SSCAN: 从 cursor 起遍历元素，至少取出 count 个（或遍历结束）追加到 result，返回下一个游标（0 表示结束）
+    size_t sscan(const std::string& key, size_t cursor, size_t count, std::vector<std::string>& result) const;
     
     // 获取类型名称（如 "hash", "set", "list"）
     virtual std::string getType() const override;
-    virtual std::vector<std::string> keys(const std::regex& regexPattern) const ;
-    std::vector<std::string> getAllKeys() const;
-    virtual bool search(const std::string & key) const override;
-    virtual bool erase(const std::string& key) override;
-    int getsize() const {
-        return setData_.size();
-    }
+
+protected:
+    ObjectType objectType() const override { return OBJ_SET; }
 };
 
 
 class RedisList : public RedisDataType {
-private:
-    std::unordered_map<std::string, std::deque<std::string>> listData_;
-
 public:
+    explicit RedisList(Keyspace::Ptr keyspace) : RedisDataType(std::move(keyspace)) {}
+
     virtual std::string getType() const override;
-    // 序列化：将跳表内容序列化为字符串
+    // 序列化：将列表内容序列化为字符串
     std::string serialize() const override;
 
-    // 反序列化：从字符串恢复跳表
+    // 反序列化：从字符串恢复列表
     void deserialize(const std::string& data) override;
 
     // LPUSH: 从左侧插入元素
@@ -129,15 +123,8 @@ public:
     // LRANGE: 获取列表的范围
     std::vector<std::string> lrange(const std::string& key, int start, int end) const;
 
-    virtual std::vector<std::string> keys(const std::regex& regexPattern) const ;
-    
-    std::vector<std::string> getAllKeys() const;
-    virtual bool search(const std::string & key) const override;
-    virtual bool erase(const std::string& key) override;
-    
-    int getsize() const {
-        return listData_.size();
-    }
+protected:
+    ObjectType objectType() const override { return OBJ_LIST; }
 };
 
 
@@ -145,38 +132,30 @@ class RedisString : public RedisDataType {
 public:
     using Ptr = std::shared_ptr<RedisString>;
 
-    RedisString() {
-        skipList_ = std::make_shared<SkipList<std::string, std::string>>();
-    }
-    // 序列化：将跳表内容序列化为字符串
+    explicit RedisString(Keyspace::Ptr keyspace) : RedisDataType(std::move(keyspace)) {}
+
+    // 序列化：将字符串键值对序列化为字符串
     std::string serialize() const override;
-    // 反序列化：从字符串恢复跳表
+    // 反序列化：从字符串恢复键值对
     void deserialize(const std::string& data) override;
-    // 插入或更新键值对
+    // 插入或更新键值对（覆盖该键原有的任意类型的值）
     void insert(const std::vector<std::string>& args);
-    // 获取键的值
-    std::shared_ptr<std::string> get(const std::vector<std::string>& args) const;
+    // 获取键的值，不存在返回 nullptr；返回的指针在下一次修改该键前有效
+    const std::string *get(const std::vector<std::string>& args) const;
+    // 命令路径上的读写：键与值直接取自参数切片，不构造临时的参数数组
+    void set(const StrView &key, const StrView &value);
+    const std::string *get(const StrView &key) const;
+    // 同 get，但键不是字符串时也返回 nullptr 而不抛出 WrongTypeError（MGET）
+    const std::string *find(const StrView &key) const;
+    // 修改已有键的值并保留其过期时间（INCR/DECR/APPEND 等），键不存在时与 set 相同
+    void update(const StrView &key, std::string value);
     // 删除指定键
     bool remove(const std::vector<std::string>& args);
-    // 获取所有键
-    std::vector<std::string> getAllKeys() const;
     // 获取数据类型名称
     std::string getType() const override;
-    // 清空存储
-    void clear();
-    // 打印存储内容（调试用）
-    void print() const;
-
-    virtual std::vector<std::string> keys(const std::regex& regexPattern) const ;
-    virtual bool search(const std::string & key) const override;
-    virtual bool erase(const std::string& key) override;
-    int getsize() const {
-        return skipList_->size();
-    }
-private:
-    // 使用 SkipList 实现键值存储
-    std::shared_ptr<SkipList<std::string, std::string>> skipList_;
 
+protected:
+    ObjectType objectType() const override { return OBJ_STRING; }
 };
 
 
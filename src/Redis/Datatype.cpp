@@ -1,79 +1,54 @@
-
+#include <algorithm>
+#include <sstream>
 #include "DataType.h"
 
 namespace toolkit
 {
 
+// 以下为各类型视图的通用实现：在键空间中只处理本类型的键
 
-template <typename MapType>
-std::vector<std::string> matchKeys(const MapType& container, const std::regex& regexPattern) {
+std::vector<std::string> RedisDataType::keys(const std::regex& regexPattern) const {
     std::vector<std::string> result;
-    for (const auto& [key, _] : container) {
-        if (std::regex_match(key, regexPattern)) {
+    auto type = objectType();
+    keyspace_->forEach([&](const std::string& key, const RedisObject& obj) {
+        if (obj.type() == type && std::regex_match(key, regexPattern)) {
             result.push_back(key);
         }
-    }
+    });
     return result;
 }
-// 
-std::vector<std::string> RedisHash::keys(const std::regex& regexPattern) const {
-    return matchKeys(hashData_, regexPattern);
-}
 
-std::vector<std::string> RedisSet::keys(const std::regex& regexPattern) const {
-    return matchKeys(setData_, regexPattern);
-}
-
-std::vector<std::string> RedisList::keys(const std::regex& regexPattern) const {
-    return matchKeys(listData_, regexPattern);
-}
-
-std::vector<std::string> RedisString::keys(const std::regex& regexPattern) const {
-    std::vector<std::string> matchcingKeys;
-    auto keys = skipList_->getAllKeys();
-    for(const auto& key : keys) {
-        if(std::regex_match(key, regexPattern)){
-            matchcingKeys.push_back(key);
+std::vector<std::string> RedisDataType::getAllKeys() const {
+    std::vector<std::string> result;
+    auto type = objectType();
+    keyspace_->forEach([&](const std::string& key, const RedisObject& obj) {
+        if (obj.type() == type) {
+            result.push_back(key);
         }
-    }
-    return matchcingKeys;
-}
-
-
-// search 方法
-bool RedisHash::search(const std::string& key) const {
-    return hashData_.find(key) != hashData_.end();
-}
-bool RedisSet::search(const std::string& key) const {
-    return setData_.find(key) != setData_.end();
-}
-bool RedisList::search(const std::string& key) const {
-    return listData_.find(key) != listData_.end();
-}
-bool RedisString::search(const std::string& key) const {
-    if(skipList_->search(key)){
-        return true;
-    }
-    return false;
-}
-
-// erase 方法
-
-bool RedisHash::erase(const std::string& key) {
-    return hashData_.erase(key) > 0;
+    });
+    return result;
 }
 
-bool RedisSet::erase(const std::string& key) {
-    return setData_.erase(key) > 0;
+bool RedisDataType::search(const std::string& key) const {
+    auto obj = keyspace_->lookup(key);
+    return obj && obj->type() == objectType();
 }
 
-bool RedisList::erase(const std::string& key) {
-    return listData_.erase(key) > 0;
+bool RedisDataType::erase(const std::string& key) {
+    auto obj = keyspace_->lookup(key);
+    if (!obj || obj->type() != objectType()) {
+        return false;
+    }
+    return keyspace_->erase(key);
 }
 
-
-bool RedisString::erase(const std::string& key) {
-    return skipList_->erase(key);
+int RedisDataType::getsize() const {
+    int sum = 0;
+    auto type = objectType();
+    keyspace_->forEach([&](const std::string&, const RedisObject& obj) {
+        sum += obj.type() == type;
+    });
+    return sum;
 }
 
 
@@ -83,18 +58,15 @@ bool RedisString::erase(const std::string& key) {
 std::string RedisHash::serialize() const {
     std::string serializedData;
 
-    for (const auto& keyPair : hashData_) {
-        const std::string& key = keyPair.first;
-        const auto& fields = keyPair.second;
-
-        for (const auto& fieldPair : fields) {
-            const std::string& field = fieldPair.first;
-            const std::string& value = fieldPair.second;
-
+    keyspace_->forEach([&](const std::string& key, const RedisObject& obj) {
+        if (obj.type() != OBJ_HASH) {
+            return;
+        }
+        static_cast<const HashObject&>(obj).value.forEach([&](const std::string& field, const std::string& value) {
             // 将每个键值对以 "key:field:value" 的格式追加到字符串中，字段间用 `|` 分隔
             serializedData += key + "|" + field + "|" + value + "\n";
-        }
-    }
+        });
+    });
 
     return serializedData;
 }
@@ -102,7 +74,7 @@ std::string RedisHash::serialize() const {
 // 反序列化：从字符串恢复哈希表
 void RedisHash::deserialize(const std::string& data) {
     // 清空当前数据
-    hashData_.clear();
+    keyspace_->clearType(OBJ_HASH);
 
     // 按行拆分
     std::istringstream stream(data);
@@ -119,44 +91,68 @@ void RedisHash::deserialize(const std::string& data) {
         }
 
         std::string key = line.substr(0, firstDelim);
+        if (!keyspace_->owns(key)) {
+            continue;   // 分片模式下只加载属于本分片的键
+        }
         std::string field = line.substr(firstDelim + 1, secondDelim - firstDelim - 1);
         std::string value = line.substr(secondDelim + 1);
 
-        // 恢复到 hashData_
-        hashData_[key][field] = value;
+        // 恢复到键空间，已被其他类型占用的键以快照为准
+        auto obj = keyspace_->lookup(key);
+        if (obj && obj->type() != OBJ_HASH) {
+            keyspace_->erase(key);
+        }
+        keyspace_->lookupOrCreate<HashObject>(key)->value[field] = value;
     }
 }
 
 // HSET: 设置字段值
 void RedisHash::hset(const std::string& key, const std::string& field, const std::string& value) {
-    hashData_[key][field] = value;
+    keyspace_->lookupOrCreate<HashObject>(key)->value[field] = value;
 }
 // HGET: 获取字段值
-std::shared_ptr<std::string> RedisHash::hget(const std::string& key, const std::string& field) const {
-    auto it = hashData_.find(key);
-    if (it != hashData_.end()) {
-        auto fieldIt = it->second.find(field);
-        if (fieldIt != it->second.end()) {
-            return std::make_shared<std::string>(fieldIt->second);
-        }
-    }
-    return nullptr;
+const std::string *RedisHash::hget(const std::string& key, const std::string& field) const {
+    auto hash = keyspace_->lookupTyped<HashObject>(key);
+    return hash ? hash->value.find(field) : nullptr;
 }
-// HDEL: 删除字段
+// HDEL: 删除字段，字段全部删除后删除该键
 bool RedisHash::hdel(const std::string& key, const std::string& field) {
-    auto it = hashData_.find(key);
-    if (it != hashData_.end()) {
-        return it->second.erase(field) > 0;
+    auto hash = keyspace_->lookupTyped<HashObject>(key);
+    if (!hash || !hash->value.erase(field)) {
+        return false;
     }
-    return false;
+    if (hash->value.empty()) {
+        keyspace_->erase(key);
+    }
+    return true;
 }
 // HGETALL: 获取所有字段及其值
-std::unordered_map<std::string, std::string> RedisHash::hgetall(const std::string& key) const {
-    auto it = hashData_.find(key);
-    if (it != hashData_.end()) {
-        return it->second;
+std::vector<std::pair<std::string, std::string>> RedisHash::hgetall(const std::string& key) const {
+    std::vector<std::pair<std::string, std::string>> result;
+    auto hash = keyspace_->lookupTyped<HashObject>(key);
+    if (hash) {
+        result.reserve(hash->value.size());
+        hash->value.forEach([&](const std::string& field, const std::string& value) {
+            result.emplace_back(field, value);
+        });
+    }
+    return result;
+}
+// HSCAN: 游标遍历字段，最多访问 count * 10 个桶
+size_t RedisHash::hscan(const std::string& key, size_t cursor, size_t count, std::vector<std::pair<std::string, std::string>>& result) const {
+    auto hash = keyspace_->lookupTyped<HashObject>(key);
+    if (!hash) {
+        return 0;
     }
-    return {};
+    size_t found = 0;
+    size_t steps = std::max<size_t>(count, 1) * 10;
+    do {
+        cursor = hash->value.scan(cursor, [&](const std::string& field, const std::string& value) {
+            result.emplace_back(field, value);
+            ++found;
+        });
+    } while (cursor && found < count && --steps);
+    return cursor;
 }
 // 获取数据类型名称
 std::string RedisHash::getType() const {
@@ -169,30 +165,32 @@ std::string RedisHash::getType() const {
 std::string RedisSet::serialize() const {
     std::string serializedData;
 
-    for (const auto& keyPair : setData_) {
-        const std::string& key = keyPair.first;
-        const auto& values = keyPair.second;
-
+    keyspace_->forEach([&](const std::string& key, const RedisObject& obj) {
+        if (obj.type() != OBJ_SET) {
+            return;
+        }
         // 添加 key
         serializedData += key + "|";
 
         // 添加 values，用逗号分隔
-        for (auto it = values.begin(); it != values.end(); ++it) {
-            if (it != values.begin()) {
+        bool first = true;
+        static_cast<const SetObject&>(obj).value.forEach([&](const std::string& value, const DictEmpty&) {
+            if (!first) {
                 serializedData += ",";
             }
-            serializedData += *it;
-        }
+            serializedData += value;
+            first = false;
+        });
 
         // 每个键值对结束加换行符
         serializedData += "\n";
-    }
+    });
 
     return serializedData;
 }
 void RedisSet::deserialize(const std::string& data) {
     // 清空当前数据
-    setData_.clear();
+    keyspace_->clearType(OBJ_SET);
 
     // 按行拆分
     std::istringstream stream(data);
@@ -208,51 +206,78 @@ void RedisSet::deserialize(const std::string& data) {
 
         // 提取 key 和 values
         std::string key = line.substr(0, delimPos);
+        if (!keyspace_->owns(key)) {
+            continue;   // 分片模式下只加载属于本分片的键
+        }
         std::string valuesStr = line.substr(delimPos + 1);
 
         // 按逗号分隔解析 values
-        std::unordered_set<std::string> values;
+        HashSet<std::string> values;
         std::istringstream valuesStream(valuesStr);
         std::string value;
 
         while (std::getline(valuesStream, value, ',')) {
-            values.insert(value);
+            values.emplace(value);
         }
 
-        // 将解析结果加入到 setData_
-        setData_[key] = std::move(values);
+        // 将解析结果加入到键空间
+        keyspace_->set(key, RedisObject::Ptr(new SetObject(std::move(values))));
     }
 }
 
 
 // SADD: 添加元素到集合
 void RedisSet::sadd(const std::string& key, const std::string& value) {
-    setData_[key].insert(value);
+    keyspace_->lookupOrCreate<SetObject>(key)->value.emplace(value);
 }
 
-// SREM: 从集合中删除元素
+// SREM: 从集合中删除元素，集合为空后删除该键
 bool RedisSet::srem(const std::string& key, const std::string& value) {
-    auto it = setData_.find(key);
-    if (it != setData_.end()) {
-        return it->second.erase(value) > 0;
+    auto set = keyspace_->lookupTyped<SetObject>(key);
+    if (!set || !set->value.erase(value)) {
+        return false;
     }
-    return false;
+    if (set->value.empty()) {
+        keyspace_->erase(key);
+    }
+    return true;
 }
 
 // SMEMBERS: 获取集合中的所有元素
-std::unordered_set<std::string> RedisSet::smembers(const std::string& key) const {
-    auto it = setData_.find(key);
-    if (it != setData_.end()) {
-        return it->second;
+std::vector<std::string> RedisSet::smembers(const std::string& key) const {
+    std::vector<std::string> result;
+    auto set = keyspace_->lookupTyped<SetObject>(key);
+    if (set) {
+        result.reserve(set->value.size());
+        set->value.forEach([&](const std::string& value, const DictEmpty&) {
+            result.push_back(value);
+        });
     }
-    return {};
+    return result;
+}
+
+// SSCAN: 游标遍历元素，最多访问 count * 10 个桶
+size_t RedisSet::sscan(const std::string& key, size_t cursor, size_t count, std::vector<std::string>& result) const {
+    auto set = keyspace_->lookupTyped<SetObject>(key);
+    if (!set) {
+        return 0;
+    }
+    size_t found = 0;
+    size_t steps = std::max<size_t>(count, 1) * 10;
+    do {
+        cursor = set->value.scan(cursor, [&](const std::string& value, const DictEmpty&) {
+            result.push_back(value);
+            ++found;
+        });
+    } while (cursor && found < count && --steps);
+    return cursor;
 }
 
 // SISMEMBER: 检查元素是否在集合中
 bool RedisSet::sismember(const std::string& key, const std::string& value) const {
-    auto it = setData_.find(key);
-    if (it != setData_.end()) {
-        return it->second.find(value) != it->second.end();
+    auto set = keyspace_->lookupTyped<SetObject>(key);
+    if (set) {
+        return set->value.find(value) != nullptr;
     }
     return false;
 }
@@ -270,7 +295,11 @@ std::string RedisList::serialize() const {
     std::ostringstream oss;
 
     // 遍历所有键值对
-    for (const auto& [key, deque] : listData_) {
+    keyspace_->forEach([&](const std::string& key, const RedisObject& obj) {
+        if (obj.type() != OBJ_LIST) {
+            return;
+        }
+        const auto& deque = static_cast<const ListObject&>(obj).value;
         // 将每个列表序列化为 "key|value1,value2,value3" 格式
         oss << key << "|";
         for (size_t i = 0; i < deque.size(); ++i) {
@@ -280,7 +309,7 @@ std::string RedisList::serialize() const {
             }
         }
         oss << "\n"; // 每个列表用换行符分隔
-    }
+    });
 
     return oss.str();
 }
@@ -288,7 +317,7 @@ std::string RedisList::serialize() const {
 // 反序列化：从字符串恢复列表
 void RedisList::deserialize(const std::string& data) {
     // 清空当前数据
-    listData_.clear();
+    keyspace_->clearType(OBJ_LIST);
 
     // 按行拆分
     std::istringstream stream(data);
@@ -303,6 +332,9 @@ void RedisList::deserialize(const std::string& data) {
         }
 
         std::string key = line.substr(0, delimPos);
+        if (!keyspace_->owns(key)) {
+            continue;   // 分片模式下只加载属于本分片的键
+        }
         std::string values = line.substr(delimPos + 1);
 
         // 按逗号分割列表值
@@ -314,39 +346,45 @@ void RedisList::deserialize(const std::string& data) {
             deque.push_back(value);
         }
 
-        // 恢复到 listData_
-        listData_[key] = std::move(deque);
+        // 恢复到键空间
+        keyspace_->set(key, RedisObject::Ptr(new ListObject(std::move(deque))));
     }
 }
 
 
 // LPUSH: 从左侧插入元素
 void RedisList::lpush(const std::string& key, const std::string& value) {
-    listData_[key].push_front(value);
+    keyspace_->lookupOrCreate<ListObject>(key)->value.push_front(value);
 }
 
 // RPUSH: 从右侧插入元素
 void RedisList::rpush(const std::string& key, const std::string& value) {
-    listData_[key].push_back(value);
+    keyspace_->lookupOrCreate<ListObject>(key)->value.push_back(value);
 }
 
-// LPOP: 从左侧弹出元素
+// LPOP: 从左侧弹出元素，列表为空后删除该键
 std::string RedisList::lpop(const std::string& key) {
-    auto it = listData_.find(key);
-    if (it != listData_.end() && !it->second.empty()) {
-        std::string value = it->second.front();
-        it->second.pop_front();
+    auto list = keyspace_->lookupTyped<ListObject>(key);
+    if (list && !list->value.empty()) {
+        std::string value = std::move(list->value.front());
+        list->value.pop_front();
+        if (list->value.empty()) {
+            keyspace_->erase(key);
+        }
         return value;
     }
     return "";
 }
 
-// RPOP: 从右侧弹出元素
+// RPOP: 从右侧弹出元素，列表为空后删除该键
 std::string RedisList::rpop(const std::string& key) {
-    auto it = listData_.find(key);
-    if (it != listData_.end() && !it->second.empty()) {
-        std::string value = it->second.back();
-        it->second.pop_back();
+    auto list = keyspace_->lookupTyped<ListObject>(key);
+    if (list && !list->value.empty()) {
+        std::string value = std::move(list->value.back());
+        list->value.pop_back();
+        if (list->value.empty()) {
+            keyspace_->erase(key);
+        }
         return value;
     }
     return "";
@@ -354,10 +392,10 @@ std::string RedisList::rpop(const std::string& key) {
 
 // LRANGE: 获取列表的范围
 std::vector<std::string> RedisList::lrange(const std::string& key, int start, int end) const {
-    auto it = listData_.find(key);
+    auto list = keyspace_->lookupTyped<ListObject>(key);
     std::vector<std::string> result;
-    if (it != listData_.end()) {
-        auto& deque = it->second;
+    if (list) {
+        auto& deque = list->value;
         int size = static_cast<int>(deque.size());
         start = (start < 0) ? size + start : start;
         end = (end < 0) ? size + end : end;
@@ -380,18 +418,20 @@ std::string RedisList::getType() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-// 序列化：将跳表内容序列化为字符串
+// 序列化：将字符串键值对序列化为字符串
 std::string RedisString::serialize() const {
     std::ostringstream oss;
-    for (const auto& [key, value] : skipList_->getAll()) {
-        oss << key << "=" << value << ";";
-    }
+    keyspace_->forEach([&](const std::string& key, const RedisObject& obj) {
+        if (obj.type() == OBJ_STRING) {
+            oss << key << "=" << static_cast<const StringObject&>(obj).value << ";";
+        }
+    });
     return oss.str();
 }
 
-// 反序列化：从字符串恢复跳表
+// 反序列化：从字符串恢复键值对
 void RedisString::deserialize(const std::string& data) {
-    skipList_->clear();
+    keyspace_->clearType(OBJ_STRING);
     std::istringstream iss(data);
     std::string pair;
 
@@ -400,8 +440,11 @@ void RedisString::deserialize(const std::string& data) {
         if (eqPos == std::string::npos) continue;
 
         std::string key = pair.substr(0, eqPos);
+        if (!keyspace_->owns(key)) {
+            continue;   // 分片模式下只加载属于本分片的键
+        }
         std::string value = pair.substr(eqPos + 1);
-        skipList_->insert(key, value);
+        insert({key, value});
     }
 }
 
@@ -410,15 +453,41 @@ void RedisString::insert(const std::vector<std::string>& args) {
     if (args.size() != 2) {
         throw std::invalid_argument("RedisString insert requires exactly 2 arguments: key and value");
     }
-    skipList_->insert(args[0], args[1]);
+    auto obj = new StringObject(args[1]);
+    obj->setEncoding(stringEncoding(obj->value));
+    keyspace_->set(args[0], RedisObject::Ptr(obj));
+}
+
+void RedisString::set(const StrView &key, const StrView &value) {
+    auto obj = new StringObject(value.toString());
+    obj->setEncoding(stringEncoding(obj->value));
+    keyspace_->set(key.scratch(), RedisObject::Ptr(obj));
+}
+
+void RedisString::update(const StrView &key, std::string value) {
+    auto obj = new StringObject(std::move(value));
+    obj->setEncoding(stringEncoding(obj->value));
+    keyspace_->update(key.scratch(), RedisObject::Ptr(obj));
+}
+
+const std::string *RedisString::get(const StrView &key) const {
+    auto str = keyspace_->lookupTyped<StringObject>(key.scratch());
+    return str ? &str->value : nullptr;
+}
+
+// 获取字符串键的值，其它类型的键视为不存在
+const std::string *RedisString::find(const StrView &key) const {
+    auto obj = keyspace_->lookup(key.scratch());
+    return obj && obj->type() == OBJ_STRING ? &static_cast<StringObject *>(obj)->value : nullptr;
 }
 
 // 获取键的值
-std::shared_ptr<std::string> RedisString::get(const std::vector<std::string>& args) const {
+const std::string *RedisString::get(const std::vector<std::string>& args) const {
     if (args.size() != 1) {
         throw std::invalid_argument("RedisString get requires exactly 1 argument: key");
     }
-    return skipList_->search(args[0]);
+    auto str = keyspace_->lookupTyped<StringObject>(args[0]);
+    return str ? &str->value : nullptr;
 }
 
 
@@ -428,40 +497,7 @@ bool RedisString::remove(const std::vector<std::string>& args) {
     if (args.size() != 1) {
         throw std::invalid_argument("RedisString remove requires exactly 1 argument: key");
     }
-    return skipList_->erase(args[0]);
-}
-
-
-// RedisList::getAllKeys
-std::vector<std::string> RedisList::getAllKeys() const {
-    std::vector<std::string> keys;
-    for (const auto& [key, _] : listData_) {
-        keys.push_back(key);
-    }
-    return keys;
-}
-
-// RedisSet::getAllKeys
-std::vector<std::string> RedisSet::getAllKeys() const {
-    std::vector<std::string> keys;
-    for (const auto& [key, _] : setData_) {
-        keys.push_back(key);
-    }
-    return keys;
-}
-
-// RedisHash::getAllKeys
-std::vector<std::string> RedisHash::getAllKeys() const {
-    std::vector<std::string> keys;
-    for (const auto& [key, _] : hashData_) {
-        keys.push_back(key);
-    }
-    return keys;
-}
-
-// 获取所有键
-std::vector<std::string> RedisString::getAllKeys() const {
-    return skipList_->getAllKeys();
+    return erase(args[0]);
 }
 
 // 获取数据类型名称
@@ -469,15 +505,5 @@ std::string RedisString::getType() const {
     return "STRING";
 }
 
-// 清空存储
-void RedisString::clear() {
-    skipList_->clear();
-}
-
-// 打印存储内容（调试用）
-void RedisString::print() const {
-    skipList_->print();
-}
-
     
 } // namespace toolkit
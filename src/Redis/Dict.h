@@ -0,0 +1,526 @@
+#ifndef DICT_H
+#define DICT_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <functional>
+#include "UsedMemory.h"
+
+namespace toolkit
+{
+
+// 集合类型不需要值，用空结构占位
+struct DictEmpty {};
+
+// 默认的回收策略：删除的节点与旧桶数组立即释放
+struct DictDelete {
+    template <typename T>
+    static void retire(T *ptr) {
+        delete ptr;
+    }
+    static void retireArray(void *ptr) {
+        UsedMemory::free(ptr);
+    }
+};
+
+// 渐进式 rehash 哈希表（参考 Redis 的 dict）
+// std::unordered_map 扩容时一次性搬迁全部元素，千万级键时会造成数百毫秒的停顿。
+// Dict 扩容时同时持有新旧两张表，每次增删查顺带搬迁一个桶，空闲时再由定时任务按时间片搬迁（rehashMilliseconds），
+// 单次操作的耗时与表的大小无关。
+// 注意：遍历（forEach）期间不能修改 Dict；find/emplace/erase 可能推进 rehash，非 const 的访问都视为修改。
+//
+// 单写多读：除写线程外，其它线程可以通过 findShared 并发查找。桶与链表指针都是原子的，新节点构造完成后才发布；
+// 删除的节点与旧桶数组交给 Reclaim 推迟释放（键空间使用 EpochReclaim），读者读到的节点在其临界区内一直有效。
+// rehash 搬迁节点会改变其 next 指针，读者可能因此错过目标，所以搬迁过程用序号（seqlock）保护，未命中且期间发生过搬迁时重试。
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>,
+          typename Reclaim = DictDelete>
+class Dict {
+public:
+    static const size_t kInitSize = 4;
+
+    Dict() = default;
+    ~Dict() {
+        clear();
+    }
+
+    Dict(const Dict &) = delete;
+    Dict &operator=(const Dict &) = delete;
+
+    Dict(Dict &&other) noexcept {
+        swap(other);
+    }
+    Dict &operator=(Dict &&other) noexcept {
+        if (this != &other) {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    size_t size() const {
+        return _ht[0].used + _ht[1].used;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    bool isRehashing() const {
+        return _rehashIdx >= 0;
+    }
+
+    // 两张表的桶总数
+    size_t bucketCount() const {
+        return _ht[0].size() + _ht[1].size();
+    }
+
+    // 查找，不存在返回 nullptr
+    V *find(const K &key) {
+        if (empty()) {
+            return nullptr;
+        }
+        if (isRehashing()) {
+            rehash(1);
+        }
+        auto entry = findEntry(key, _hash(key));
+        return entry ? &entry->value : nullptr;
+    }
+
+    const V *find(const K &key) const {
+        if (empty()) {
+            return nullptr;
+        }
+        auto entry = findEntry(key, _hash(key));
+        return entry ? &entry->value : nullptr;
+    }
+
+    // 查找表中保存的键，不存在返回 nullptr；节点不随 rehash 重新分配，返回的指针在该键被删除前一直有效
+    const K *findKey(const K &key) const {
+        if (empty()) {
+            return nullptr;
+        }
+        auto entry = findEntry(key, _hash(key));
+        return entry ? &entry->key : nullptr;
+    }
+
+    // 供其它线程并发查找（写线程之外的读者），不推进 rehash；返回的值在读者的回收临界区内有效
+    const V *findShared(const K &key) const {
+        auto hash = _hash(key);
+        while (true) {
+            auto seq = _seq.load(std::memory_order_acquire);
+            if (auto entry = findEntry(key, hash)) {
+                // 节点只会被搬迁，不会在临界区内被释放，命中总是有效的
+                return &entry->value;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (!(seq & 1) && _seq.load(std::memory_order_relaxed) == seq) {
+                return nullptr;
+            }
+            // 查找期间发生了搬迁，可能漏掉了目标，重新查找
+            std::this_thread::yield();
+        }
+    }
+
+    // 插入，键已存在时不修改；返回值的指针以及是否为新插入
+    template <typename... Args>
+    std::pair<V *, bool> emplace(const K &key, Args &&...args) {
+        if (isRehashing()) {
+            rehash(1);
+        }
+        expandIfNeeded();
+        auto hash = _hash(key);
+        if (auto entry = findEntry(key, hash)) {
+            return std::make_pair(&entry->value, false);
+        }
+        // rehash 期间新元素只写入新表；节点构造完成后才发布给读者
+        auto &ht = isRehashing() ? _ht[1] : _ht[0];
+        auto &bucket = ht.bucket(hash);
+        auto entry = new Entry(key, hash, bucket.load(std::memory_order_relaxed), std::forward<Args>(args)...);
+        bucket.store(entry, std::memory_order_release);
+        ++ht.used;
+        return std::make_pair(&entry->value, true);
+    }
+
+    V &operator[](const K &key) {
+        return *emplace(key).first;
+    }
+
+    bool erase(const K &key) {
+        if (empty()) {
+            return false;
+        }
+        if (isRehashing()) {
+            rehash(1);
+        }
+        auto hash = _hash(key);
+        for (int t = 0; t <= 1; ++t) {
+            auto &ht = _ht[t];
+            if (ht.size()) {
+                for (auto prev = &ht.bucket(hash); auto entry = prev->load(std::memory_order_relaxed);
+                     prev = &entry->next) {
+                    if (entry->hash == hash && _equal(entry->key, key)) {
+                        // 摘除后节点的 next 保持不变，正在访问它的读者仍能继续遍历
+                        prev->store(entry->next.load(std::memory_order_relaxed), std::memory_order_release);
+                        Reclaim::retire(entry);
+                        --ht.used;
+                        return true;
+                    }
+                }
+            }
+            if (!isRehashing()) {
+                break;
+            }
+        }
+        return false;
+    }
+
+    // 删除满足条件的元素，返回删除个数
+    template <typename Pred>
+    size_t eraseIf(Pred &&pred) {
+        size_t count = 0;
+        for (int t = 0; t <= 1; ++t) {
+            auto &ht = _ht[t];
+            for (size_t i = 0; i < ht.size(); ++i) {
+                for (auto prev = &ht.at(i); auto entry = prev->load(std::memory_order_relaxed);) {
+                    if (pred(entry->key, entry->value)) {
+                        prev->store(entry->next.load(std::memory_order_relaxed), std::memory_order_release);
+                        Reclaim::retire(entry);
+                        --ht.used;
+                        ++count;
+                    } else {
+                        prev = &entry->next;
+                    }
+                }
+            }
+        }
+        return count;
+    }
+
+    // 遍历所有元素，func(const K &, const V &)
+    template <typename Func>
+    void forEach(Func &&func) const {
+        for (int t = 0; t <= 1; ++t) {
+            auto &ht = _ht[t];
+            for (size_t i = 0; i < ht.size(); ++i) {
+                for (auto entry = ht.at(i).load(std::memory_order_relaxed); entry;
+                     entry = entry->next.load(std::memory_order_relaxed)) {
+                    func(entry->key, entry->value);
+                }
+            }
+        }
+    }
+
+    /**
+    * @brief 抽样：从第 start 个桶起依次取出至多 count 个元素，最多访问 count * 10 个桶（淘汰键时使用）
+    * rehash 期间两张表同时抽样；func(const K &, const V &)
+    * @return 取出的元素个数
+    */
+    template <typename Func>
+    size_t sample(size_t start, size_t count, Func &&func) const {
+        size_t found = 0;
+        for (size_t step = 0; found < count && step < count * 10 && !empty(); ++step) {
+            for (int t = 0; t <= 1; ++t) {
+                auto &ht = _ht[t];
+                if (!ht.size()) {
+                    continue;
+                }
+                for (auto entry = ht.at((start + step) & (ht.size() - 1)).load(std::memory_order_relaxed);
+                     entry && found < count; entry = entry->next.load(std::memory_order_relaxed)) {
+                    func(entry->key, entry->value);
+                    ++found;
+                }
+            }
+        }
+        return found;
+    }
+
+    /**
+    * @brief 游标遍历（SCAN）的一步：取出游标对应的桶中的元素，返回下一个游标，0 表示遍历结束
+    * 游标按桶下标的反向二进制递增（同 Redis 的 dictScan）：高位先变，表扩容或缩容后，已访问过的桶
+    * 在新表中对应的桶仍排在游标之前；rehash 期间访问小表的桶及其在大表中展开的所有桶。
+    * 因此两次调用之间表发生扩容、缩容或 rehash，遍历开始时已存在且一直未被删除的元素也至少返回一次（可能重复）。
+    * func(const K &, const V &)，调用期间不能修改 Dict
+    */
+    template <typename Func>
+    size_t scan(size_t cursor, Func &&func) const {
+        if (empty()) {
+            return 0;
+        }
+        if (!isRehashing()) {
+            auto mask = _ht[0].size() - 1;
+            scanBucket(_ht[0], cursor & mask, func);
+            return nextCursor(cursor, mask);
+        }
+        auto small = &_ht[0], large = &_ht[1];
+        if (small->size() > large->size()) {
+            std::swap(small, large);
+        }
+        auto m0 = small->size() - 1, m1 = large->size() - 1;
+        scanBucket(*small, cursor & m0, func);
+        // 小表的桶在大表中展开为低位相同的若干个桶，依次访问
+        do {
+            scanBucket(*large, cursor & m1, func);
+            cursor = nextCursor(cursor, m1);
+        } while (cursor & (m0 ^ m1));
+        return cursor;
+    }
+
+    // 表自身占用的内存：桶数组与节点（按分配器实际分配的大小），不含键和值内部另外分配的内存
+    size_t memoryUsage() const {
+        static const size_t kEntrySize = UsedMemory::allocSize(sizeof(Entry));
+        return UsedMemory::usableSize(_ht[0].array.load(std::memory_order_relaxed)) +
+               UsedMemory::usableSize(_ht[1].array.load(std::memory_order_relaxed)) + size() * kEntrySize;
+    }
+
+    // 释放所有元素（不经过 Reclaim，调用时不能有并发的读者）
+    void clear() {
+        for (int t = 0; t <= 1; ++t) {
+            auto &ht = _ht[t];
+            for (size_t i = 0; i < ht.size() && ht.used; ++i) {
+                for (auto entry = ht.at(i).load(std::memory_order_relaxed); entry;) {
+                    auto next = entry->next.load(std::memory_order_relaxed);
+                    delete entry;
+                    --ht.used;
+                    entry = next;
+                }
+            }
+            UsedMemory::free(ht.array.load(std::memory_order_relaxed));
+            ht.reset();
+        }
+        _rehashIdx = -1;
+    }
+
+    /**
+    * @brief 搬迁至多 n 个非空桶，最多访问 n * 10 个空桶，避免在稀疏的表上耗时过长
+    * @return 是否仍处于 rehash 中
+    */
+    bool rehash(size_t n) {
+        if (!isRehashing()) {
+            return false;
+        }
+        size_t emptyVisits = n * 10;
+        auto &from = _ht[0];
+        auto &to = _ht[1];
+        WriteSection section(_seq);
+        while (n-- && from.used) {
+            while (!from.at(_rehashIdx).load(std::memory_order_relaxed)) {
+                ++_rehashIdx;
+                if (--emptyVisits == 0) {
+                    return true;
+                }
+            }
+            for (auto entry = from.at(_rehashIdx).load(std::memory_order_relaxed); entry;) {
+                auto next = entry->next.load(std::memory_order_relaxed);
+                auto &bucket = to.bucket(entry->hash);
+                entry->next.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                bucket.store(entry, std::memory_order_release);
+                --from.used;
+                ++to.used;
+                entry = next;
+            }
+            from.at(_rehashIdx++).store(nullptr, std::memory_order_release);
+        }
+        if (from.used == 0) {
+            // 搬迁完毕，新表成为主表；旧桶数组可能仍有读者在访问，交给 Reclaim 释放
+            Reclaim::retireArray(from.array.load(std::memory_order_relaxed));
+            from.array.store(to.array.load(std::memory_order_relaxed), std::memory_order_release);
+            from.used = to.used;
+            to.array.store(nullptr, std::memory_order_release);
+            to.used = 0;
+            _rehashIdx = -1;
+            return false;
+        }
+        return true;
+    }
+
+    // 在 ms 毫秒内尽可能多地搬迁（空闲定时任务调用），返回搬迁的桶数
+    size_t rehashMilliseconds(int ms) {
+        auto start = std::chrono::steady_clock::now();
+        size_t count = 0;
+        while (rehash(100)) {
+            count += 100;
+            if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(ms)) {
+                break;
+            }
+        }
+        return count;
+    }
+
+    // 负载过低时开始缩容，返回是否开始了 rehash（空闲定时任务调用）
+    bool shrinkIfNeeded() {
+        auto &ht = _ht[0];
+        if (isRehashing() || ht.size() <= kInitSize || ht.used * 10 >= ht.size()) {
+            return false;
+        }
+        return startRehash(ht.used);
+    }
+
+private:
+    struct Entry {
+        template <typename... Args>
+        Entry(const K &k, size_t h, Entry *n, Args &&...args)
+            : key(k), value(std::forward<Args>(args)...), hash(h), next(n) {}
+
+        K key;
+        V value;
+        size_t hash;        // 缓存哈希值，rehash 时不需要重新计算
+        std::atomic<Entry *> next;
+    };
+
+    // 桶数组，掩码与桶放在同一块内存中，读者取到数组指针即可得到一致的大小
+    struct Buckets {
+        size_t mask;
+        std::atomic<Entry *> slots[1];
+    };
+
+    struct Table {
+        std::atomic<Buckets *> array{nullptr};
+        size_t used = 0;    // 元素个数（只由写线程访问）
+
+        // 桶数，总是 2 的幂
+        size_t size() const {
+            auto arr = array.load(std::memory_order_relaxed);
+            return arr ? arr->mask + 1 : 0;
+        }
+        std::atomic<Entry *> &at(size_t index) const {
+            return array.load(std::memory_order_relaxed)->slots[index];
+        }
+        std::atomic<Entry *> &bucket(size_t hash) const {
+            auto arr = array.load(std::memory_order_relaxed);
+            return arr->slots[hash & arr->mask];
+        }
+        void reset() {
+            array.store(nullptr, std::memory_order_relaxed);
+            used = 0;
+        }
+    };
+
+    // rehash 搬迁节点期间序号为奇数
+    class WriteSection {
+    public:
+        explicit WriteSection(std::atomic<uint64_t> &seq) : _seq(seq) {
+            _seq.store(_seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        ~WriteSection() {
+            _seq.store(_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<uint64_t> &_seq;
+    };
+
+    template <typename Func>
+    static void scanBucket(const Table &ht, size_t index, Func &func) {
+        for (auto entry = ht.at(index).load(std::memory_order_relaxed); entry;
+             entry = entry->next.load(std::memory_order_relaxed)) {
+            func(entry->key, entry->value);
+        }
+    }
+
+    // 反向二进制加一：掩码以外的位置 1 后反转、加一、再反转，进位从桶下标的最高位向低位传递
+    static size_t nextCursor(size_t cursor, size_t mask) {
+        cursor |= ~mask;
+        cursor = reverseBits(cursor);
+        ++cursor;
+        return reverseBits(cursor);
+    }
+
+    static size_t reverseBits(size_t v) {
+        size_t bits = sizeof(v) * 8;
+        size_t mask = ~size_t(0);
+        while ((bits >>= 1) > 0) {
+            mask ^= mask << bits;
+            v = ((v >> bits) & mask) | ((v << bits) & ~mask);
+        }
+        return v;
+    }
+
+    // 写线程与 findShared 共用；读者按先旧表后新表的顺序查找，每张表只取一次数组指针
+    Entry *findEntry(const K &key, size_t hash) const {
+        for (int t = 0; t <= 1; ++t) {
+            auto arr = _ht[t].array.load(std::memory_order_acquire);
+            if (arr) {
+                for (auto entry = arr->slots[hash & arr->mask].load(std::memory_order_acquire); entry;
+                     entry = entry->next.load(std::memory_order_acquire)) {
+                    if (entry->hash == hash && _equal(entry->key, key)) {
+                        return entry;
+                    }
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    // 负载因子达到 1 时开始扩容到 2 倍
+    void expandIfNeeded() {
+        if (isRehashing()) {
+            return;
+        }
+        auto &ht = _ht[0];
+        if (ht.size() == 0) {
+            ht.array.store(allocBuckets(kInitSize), std::memory_order_release);
+        } else if (ht.used >= ht.size()) {
+            startRehash(ht.used * 2);
+        }
+    }
+
+    bool startRehash(size_t minSize) {
+        auto size = nextPower(minSize);
+        if (size == _ht[0].size()) {
+            return false;
+        }
+        _ht[1].array.store(allocBuckets(size), std::memory_order_release);
+        _ht[1].used = 0;
+        _rehashIdx = 0;
+        return true;
+    }
+
+    static Buckets *allocBuckets(size_t size) {
+        // calloc 分配的大块内存由内核按页清零，不会在扩容瞬间 memset 整张表（全零即为空的原子指针）
+        auto ret = static_cast<Buckets *>(UsedMemory::calloc(1, sizeof(Buckets) + (size - 1) * sizeof(std::atomic<Entry *>)));
+        if (!ret) {
+            throw std::bad_alloc();
+        }
+        ret->mask = size - 1;
+        return ret;
+    }
+
+    static size_t nextPower(size_t size) {
+        size_t ret = kInitSize;
+        while (ret < size) {
+            ret <<= 1;
+        }
+        return ret;
+    }
+
+    // 只用于移动构造与移动赋值，调用时不能有并发的读者
+    void swap(Dict &other) {
+        for (int t = 0; t <= 1; ++t) {
+            auto array = _ht[t].array.load(std::memory_order_relaxed);
+            _ht[t].array.store(other._ht[t].array.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other._ht[t].array.store(array, std::memory_order_relaxed);
+            std::swap(_ht[t].used, other._ht[t].used);
+        }
+        std::swap(_rehashIdx, other._rehashIdx);
+    }
+
+private:
+    Table _ht[2];
+    int64_t _rehashIdx = -1;    // 旧表中下一个待搬迁的桶，-1 表示不在 rehash 中
+    std::atomic<uint64_t> _seq{0};  // rehash 搬迁序号，奇数表示正在搬迁
+    Hash _hash;
+    Equal _equal;
+};
+
+template <typename K, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+using DictSet = Dict<K, DictEmpty, Hash, Equal>;
+
+} // namespace toolkit
+
+#endif
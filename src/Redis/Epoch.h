@@ -0,0 +1,158 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include "UsedMemory.h"
+
+namespace toolkit
+{
+
+// 基于纪元的内存回收（epoch-based reclamation）
+// poller 线程无锁地读取键空间时，写线程（执行线程或分片所有者）删除的节点、替换下来的值不能立即释放。
+// 读者进入临界区（Guard）时登记当前的全局纪元；写者把待释放对象按纪元放入本线程的回收袋（retire），
+// 当所有处于临界区的读者都已登记到当前纪元时全局纪元前进一步，两个纪元之前回收袋中的对象此时不可能再被读者引用，可以释放。
+// 读者只有一次写和一次内存屏障的开销，不会阻塞写者；写者的释放只是被推迟。
+class Epoch {
+    struct Record;
+
+public:
+    using Deleter = void (*)(void *);
+
+    static Epoch &Instance() {
+        static Epoch instance;
+        return instance;
+    }
+    Epoch(const Epoch &) = delete;
+    Epoch &operator=(const Epoch &) = delete;
+
+    // 读者临界区：作用域内读到的节点与值在离开作用域前不会被释放（不可嵌套）
+    class Guard {
+    public:
+        Guard() : _record(Epoch::Instance().record()) {
+            _record->epoch.store(Epoch::Instance()._global.load(std::memory_order_relaxed) | kActive,
+                                 std::memory_order_release);
+            // 登记必须在之后的任何读取之前对写者可见
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        ~Guard() {
+            _record->epoch.store(0, std::memory_order_release);
+        }
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+    private:
+        Record *_record;
+    };
+
+    // 推迟释放 ptr，只能在写线程中调用
+    void retire(void *ptr, Deleter deleter) {
+        auto rec = record();
+        auto epoch = _global.load(std::memory_order_acquire);
+        rec->bags[(epoch / kStep) % 3].emplace_back(ptr, deleter);
+        if (++rec->retired % kCollectInterval == 0) {
+            collect();
+        }
+    }
+
+    template <typename T>
+    void retire(T *ptr) {
+        retire(ptr, [](void *p) { delete static_cast<T *>(p); });
+    }
+
+    // 尝试推进全局纪元，并释放本线程中已经安全的对象（写线程空闲时调用）
+    void collect() {
+        auto rec = record();
+        auto epoch = _global.load(std::memory_order_acquire);
+        if (rec->collected != epoch) {
+            // 全局纪元自本线程上次释放后已前进：2 个纪元之前放入的回收袋已经安全
+            freeBags(rec, epoch);
+        }
+        if (tryAdvance(epoch)) {
+            freeBags(rec, epoch + kStep);
+        }
+    }
+
+    uint64_t epoch() const {
+        return _global.load(std::memory_order_relaxed) / kStep;
+    }
+
+    // 本线程尚未释放的对象数
+    size_t pending() {
+        auto rec = record();
+        return rec->bags[0].size() + rec->bags[1].size() + rec->bags[2].size();
+    }
+
+private:
+    // 纪元的最低位用作读者的活跃标记，因此全局纪元每次加 2
+    static const uint64_t kActive = 1;
+    static const uint64_t kStep = 2;
+    static const uint64_t kCollectInterval = 64;
+
+    struct Record {
+        std::atomic<uint64_t> epoch{0};     // 读者登记的纪元 | kActive，不在临界区时为 0
+        Record *next = nullptr;
+        // 以下只由所属线程访问
+        std::vector<std::pair<void *, Deleter>> bags[3];
+        uint64_t retired = 0;
+        uint64_t collected = 0;             // 上次释放时的全局纪元
+    };
+
+    Epoch() = default;
+
+    // 当前线程的登记记录，第一次使用时创建并挂到全局链表上（线程退出后记录保留，不再活跃）
+    Record *record() {
+        static thread_local Record *rec = nullptr;
+        if (!rec) {
+            rec = new Record();
+            auto head = _records.load(std::memory_order_relaxed);
+            do {
+                rec->next = head;
+            } while (!_records.compare_exchange_weak(head, rec, std::memory_order_release, std::memory_order_relaxed));
+        }
+        return rec;
+    }
+
+    // 所有活跃读者都已登记到 epoch 时推进全局纪元
+    bool tryAdvance(uint64_t epoch) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (auto rec = _records.load(std::memory_order_acquire); rec; rec = rec->next) {
+            auto local = rec->epoch.load(std::memory_order_acquire);
+            if ((local & kActive) && (local & ~kActive) != epoch) {
+                return false;
+            }
+        }
+        return _global.compare_exchange_strong(epoch, epoch + kStep, std::memory_order_acq_rel);
+    }
+
+    // 全局纪元为 epoch 时，放入纪元 epoch - 2 的回收袋（即下一轮将要复用的袋）中的对象已经安全
+    void freeBags(Record *rec, uint64_t epoch) {
+        auto &bag = rec->bags[(epoch / kStep + 1) % 3];
+        for (auto &item : bag) {
+            item.second(item.first);
+        }
+        bag.clear();
+        rec->collected = epoch;
+    }
+
+    std::atomic<uint64_t> _global{kStep};
+    std::atomic<Record *> _records{nullptr};
+};
+
+// 哈希表的回收策略：节点与桶数组经 Epoch 推迟释放（见 Dict 的 Reclaim 参数）
+struct EpochReclaim {
+    template <typename T>
+    static void retire(T *ptr) {
+        Epoch::Instance().retire(ptr);
+    }
+    static void retireArray(void *ptr) {
+        Epoch::Instance().retire(ptr, [](void *p) { UsedMemory::free(p); });
+    }
+};
+
+} // namespace toolkit
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef EVICTIONPOOL_H
+#define EVICTIONPOOL_H
+
+#include <string>
+#include <limits>
+#include <utility>
+#include <cstdint>
+#include "RedisObject.h"
+#include "RedisConfig.h"
+
+namespace toolkit
+{
+
+// 近似 LRU/LFU 淘汰的候选池（参考 Redis 的 evictionPoolEntry）
+// 每次淘汰前从各数据库抽样若干键，按分数放入池中，池中只保留至今抽到的分数最高的 kSize 个键，
+// 淘汰时取分数最高的一个；池在多次淘汰之间保留，之前抽样的结果不会浪费，抽样数不多也能接近真正的 LRU/LFU。
+// 池中的键可能已被删除或淘汰，淘汰时键不存在则跳过。每个拥有键空间的线程一个，只能在该线程中使用。
+class EvictionPool {
+public:
+    static const size_t kSize = 16;
+
+    // 淘汰的优先级，越大越先淘汰：LRU 为空闲秒数，LFU 为 255 减去访问计数，TTL 为越早过期越大
+    static uint64_t score(EvictionPolicy policy, const RedisObject &obj) {
+        switch (policy) {
+            case EVICT_ALLKEYS_LFU:
+                return 255 - obj.lfuCounter();
+            case EVICT_VOLATILE_TTL:
+                return std::numeric_limits<uint64_t>::max() - static_cast<uint64_t>(obj.expireAt());
+            default:
+                return obj.idleTime();
+        }
+    }
+
+    // 放入候选键；池已满且分数不高于池中最低的分数时忽略
+    void insert(uint64_t score, int dbIndex, const std::string &key) {
+        // 池按分数升序排列，找到第一个分数更高的位置
+        size_t pos = 0;
+        while (pos < _count && _entries[pos].score < score) {
+            ++pos;
+        }
+        if (_count == kSize) {
+            if (pos == 0) {
+                return;
+            }
+            // 丢弃分数最低的一个，pos 之前的左移一位；复用被丢弃的键的内存
+            --pos;
+            for (size_t i = 0; i < pos; ++i) {
+                _entries[i].swap(_entries[i + 1]);
+            }
+        } else {
+            for (size_t i = _count; i > pos; --i) {
+                _entries[i].swap(_entries[i - 1]);
+            }
+            ++_count;
+        }
+        auto &entry = _entries[pos];
+        entry.score = score;
+        entry.dbIndex = dbIndex;
+        entry.key.assign(key);
+    }
+
+    // 取出分数最高的候选键，池为空返回 false
+    bool pop(int &dbIndex, std::string &key) {
+        if (!_count) {
+            return false;
+        }
+        auto &entry = _entries[--_count];
+        dbIndex = entry.dbIndex;
+        key.swap(entry.key);
+        return true;
+    }
+
+    bool empty() const {
+        return _count == 0;
+    }
+
+    // 下一次抽样的起始位置
+    size_t randomStart() {
+        _seed ^= _seed << 13;
+        _seed ^= _seed >> 7;
+        _seed ^= _seed << 17;
+        return static_cast<size_t>(_seed);
+    }
+
+private:
+    struct Entry {
+        uint64_t score = 0;
+        int dbIndex = 0;
+        std::string key;
+
+        void swap(Entry &other) {
+            std::swap(score, other.score);
+            std::swap(dbIndex, other.dbIndex);
+            key.swap(other.key);
+        }
+    };
+
+    Entry _entries[kSize];
+    size_t _count = 0;
+    uint64_t _seed = 0x2545F4914F6CDD1DULL;
+};
+
+} // namespace toolkit
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef FAIRSCHEDULER_H
+#define FAIRSCHEDULER_H
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+#include "CmdQueue.h"
+#include "CommandTable.h"
+
+namespace toolkit
+{
+
+// 执行线程的公平调度器
+// 执行线程把命令队列中已到达的命令按所属客户端（会话）放入各自的子队列，再轮流从各子队列取命令执行，
+// 每个客户端每轮最多执行 budget 条，pipeline 大量命令的客户端不会让其它客户端排在它的全部命令之后。
+// 控制命令（CMD_CONTROL：PING/INFO/COMMAND 与事务控制命令）在其客户端没有更早的命令排队时进入优先通道，每次调度先执行。
+// 同一客户端的命令始终按到达顺序执行。只能在执行线程中使用。
+class FairScheduler {
+public:
+    using Command = CommandQueue::Command;
+
+    /**
+    * @brief 创建调度器
+    * @param budget 每个客户端每轮最多连续执行的命令数
+    * @param capacity 最多暂存的命令数，达到后执行线程不再从命令队列中取命令（由命令队列向 poller 施加背压）
+    * @param fair 为 false 时所有命令进入同一个子队列，按到达顺序执行
+    */
+    FairScheduler(size_t budget, size_t capacity, bool fair = true)
+        : _budget(std::max<size_t>(budget, 1)), _capacity(std::max<size_t>(capacity, 1)), _fair(fair) {}
+
+    FairScheduler(const FairScheduler &) = delete;
+    FairScheduler &operator=(const FairScheduler &) = delete;
+
+    void push(Command cmd) {
+        auto owner = _fair ? cmd.owner() : nullptr;
+        auto &lane = _lanes[owner];
+        if (!lane) {
+            lane.reset(new Lane());
+        }
+        ++_size;
+        if (_fair && lane->commands.empty() && control(cmd)) {
+            // 该客户端没有更早的命令在排队，越过其它客户端直接执行也不会打乱它自己的顺序
+            _priority.push(std::move(cmd));
+            return;
+        }
+        lane->commands.push(std::move(cmd));
+        if (!lane->active) {
+            lane->active = true;
+            _active.push(lane.get());
+        }
+        sweep();
+    }
+
+    /**
+    * @brief 按调度顺序取出至多 limit 条命令，依次交给 func 执行
+    * @return 执行的命令数
+    */
+    template <typename Func>
+    size_t drain(size_t limit, Func &&func) {
+        size_t count = 0;
+        Command cmd;
+        while (count < limit && !_priority.empty()) {
+            _priority.pop(cmd);
+            --_size;
+            ++_prioritized;
+            func(cmd);
+            ++count;
+        }
+        while (count < limit && !_active.empty()) {
+            auto lane = _active.front();
+            lane->commands.pop(cmd);
+            --_size;
+            if (lane->commands.empty()) {
+                lane->active = false;
+                _active.pop();
+                _served = 0;
+            } else if (++_served >= _budget) {
+                // 用完本轮的配额，排到队尾
+                _active.pop();
+                _active.push(lane);
+                _served = 0;
+            }
+            func(cmd);
+            ++count;
+        }
+        return count;
+    }
+
+    // 暂存的命令数
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    bool full() const {
+        return _size >= _capacity;
+    }
+
+    // 有命令等待执行的客户端数
+    size_t activeClients() const {
+        return _active.size();
+    }
+
+    // 有多个客户端的命令在排队（或优先通道非空），需要轮流执行
+    bool contended() const {
+        return _active.size() > 1 || !_priority.empty();
+    }
+
+    // 经优先通道执行的命令数
+    uint64_t prioritized() const {
+        return _prioritized;
+    }
+
+private:
+    // 只在队尾写入、队首读取的环形队列，容量按 2 的幂增长且不收缩，稳定运行后不分配内存
+    template <typename T>
+    class Ring {
+    public:
+        void push(T value) {
+            if (_count == _items.size()) {
+                grow();
+            }
+            _items[(_head + _count) & (_items.size() - 1)] = std::move(value);
+            ++_count;
+        }
+        void pop(T &value) {
+            value = std::move(_items[_head]);
+            _items[_head] = T();
+            _head = (_head + 1) & (_items.size() - 1);
+            --_count;
+        }
+        void pop() {
+            T value;
+            pop(value);
+        }
+        T &front() {
+            return _items[_head];
+        }
+        size_t size() const {
+            return _count;
+        }
+        bool empty() const {
+            return _count == 0;
+        }
+
+    private:
+        void grow() {
+            std::vector<T> items(_items.empty() ? 4 : _items.size() * 2);
+            for (size_t i = 0; i < _count; ++i) {
+                items[i] = std::move(_items[(_head + i) & (_items.size() - 1)]);
+            }
+            _items.swap(items);
+            _head = 0;
+        }
+
+        std::vector<T> _items;
+        size_t _head = 0;
+        size_t _count = 0;
+    };
+
+    struct Lane {
+        Ring<Command> commands;
+        bool active = false;    // 是否在轮转队列中
+    };
+
+    static bool control(const Command &cmd) {
+        auto desc = cmd.desc();
+        return desc && desc->spec && (desc->spec->flags & CMD_CONTROL);
+    }
+
+    // 会话断开后其子队列不会再用到，空闲子队列较多时统一删除
+    void sweep() {
+        if (_lanes.size() < _sweepAt) {
+            return;
+        }
+        for (auto it = _lanes.begin(); it != _lanes.end();) {
+            if (it->second->commands.empty()) {
+                it = _lanes.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        _sweepAt = _lanes.size() * 2 > kMinSweep ? _lanes.size() * 2 : kMinSweep;
+    }
+
+    static const size_t kMinSweep = 1024;
+
+    size_t _budget;
+    size_t _capacity;
+    bool _fair;
+    size_t _size = 0;
+    size_t _served = 0;                 // 轮转队列队首的客户端本轮已执行的命令数
+    size_t _sweepAt = kMinSweep;
+    uint64_t _prioritized = 0;
+    std::unordered_map<const void *, std::unique_ptr<Lane>> _lanes;    // 客户端 -> 子队列
+    Ring<Lane *> _active;               // 有命令排队的客户端，按轮转顺序
+    Ring<Command> _priority;            // 优先通道
+};
+
+} // namespace toolkit
+
+#endif
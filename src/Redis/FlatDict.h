@@ -0,0 +1,395 @@
+#ifndef FLATDICT_H
+#define FLATDICT_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <functional>
+#include "UsedMemory.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace toolkit
+{
+
+// 开放寻址哈希表（参考 SwissTable）
+// 元素直接存放在连续的槽数组中，另有一个控制字节数组：每个槽一个字节，存哈希值的低 7 位（满槽）或空/删除标记。
+// 查找时用 SSE2 一次比较 16 个控制字节，只有标签相同的槽才去比较键，命中通常只需访问一次控制字节和一次槽，
+// 没有 std::unordered_map / Dict 每个元素一个节点带来的指针跳转和额外内存。
+// 代价是扩容时一次性搬迁所有元素（没有渐进式 rehash），接口与 Dict 保持一致以便互相替换。
+// 注意：插入和删除都可能使已返回的指针失效，遍历（forEach）期间不能修改。
+template <typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class FlatDict {
+public:
+    static const size_t kGroupWidth = 16;
+    static const size_t kInitSize = kGroupWidth;
+
+    FlatDict() = default;
+    ~FlatDict() {
+        clear();
+    }
+
+    FlatDict(const FlatDict &) = delete;
+    FlatDict &operator=(const FlatDict &) = delete;
+
+    FlatDict(FlatDict &&other) noexcept {
+        swap(other);
+    }
+    FlatDict &operator=(FlatDict &&other) noexcept {
+        if (this != &other) {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    // 没有渐进式 rehash，以下几个接口只为与 Dict 保持一致
+    bool isRehashing() const {
+        return false;
+    }
+
+    bool rehash(size_t) {
+        return false;
+    }
+
+    size_t rehashMilliseconds(int) {
+        return 0;
+    }
+
+    size_t bucketCount() const {
+        return _capacity;
+    }
+
+    // 查找，不存在返回 nullptr
+    V *find(const K &key) {
+        auto index = findIndex(key, _hash(key));
+        return index == kNotFound ? nullptr : &_slots[index].value;
+    }
+
+    const V *find(const K &key) const {
+        auto index = findIndex(key, _hash(key));
+        return index == kNotFound ? nullptr : &_slots[index].value;
+    }
+
+    // 插入，键已存在时不修改；返回值的指针以及是否为新插入
+    template <typename... Args>
+    std::pair<V *, bool> emplace(const K &key, Args &&...args) {
+        auto hash = _hash(key);
+        auto index = findIndex(key, hash);
+        if (index != kNotFound) {
+            return std::make_pair(&_slots[index].value, false);
+        }
+        // 已用槽（含删除标记）超过 7/8 时扩容；删除标记较多时原大小重建即可清理
+        if (!_capacity) {
+            resize(kInitSize);
+        } else if ((_size + _deleted + 1) * 8 > _capacity * 7) {
+            resize(_size * 2 >= _capacity ? _capacity * 2 : _capacity);
+        }
+        index = findFree(hash);
+        if (_ctrl[index] == kDeleted) {
+            --_deleted;
+        }
+        setCtrl(index, h2(hash));
+        new (&_slots[index]) Slot(key, std::forward<Args>(args)...);
+        ++_size;
+        return std::make_pair(&_slots[index].value, true);
+    }
+
+    V &operator[](const K &key) {
+        return *emplace(key).first;
+    }
+
+    bool erase(const K &key) {
+        auto index = findIndex(key, _hash(key));
+        if (index == kNotFound) {
+            return false;
+        }
+        eraseAt(index);
+        return true;
+    }
+
+    // 删除满足条件的元素，返回删除个数
+    template <typename Pred>
+    size_t eraseIf(Pred &&pred) {
+        size_t count = 0;
+        for (size_t i = 0; i < _capacity; ++i) {
+            if (isFull(_ctrl[i]) && pred(_slots[i].key, _slots[i].value)) {
+                eraseAt(i);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    // 遍历所有元素，func(const K &, const V &)
+    template <typename Func>
+    void forEach(Func &&func) const {
+        for (size_t i = 0; i < _capacity; ++i) {
+            if (isFull(_ctrl[i])) {
+                func(_slots[i].key, _slots[i].value);
+            }
+        }
+    }
+
+    /**
+    * @brief 抽样：从第 start 个槽起依次取出至多 count 个元素，最多访问 count * 16 个槽（淘汰键时使用）
+    * func(const K &, const V &)
+    * @return 取出的元素个数
+    */
+    template <typename Func>
+    size_t sample(size_t start, size_t count, Func &&func) const {
+        size_t found = 0;
+        for (size_t step = 0; found < count && step < count * 16 && _size; ++step) {
+            auto i = (start + step) & _mask;
+            if (isFull(_ctrl[i])) {
+                func(_slots[i].key, _slots[i].value);
+                ++found;
+            }
+        }
+        return found;
+    }
+
+    /**
+    * @brief 游标遍历（SCAN）的一步：取出游标对应的槽中的元素，返回下一个游标，0 表示遍历结束
+    * 游标按槽下标的反向二进制递增（与 Dict 相同），两次调用之间没有扩容时每个元素恰好返回一次；
+    * 扩容会按新的容量重新放置所有元素，跨越扩容的遍历可能漏掉或重复返回元素。func(const K &, const V &)
+    */
+    template <typename Func>
+    size_t scan(size_t cursor, Func &&func) const {
+        if (!_size) {
+            return 0;
+        }
+        auto index = cursor & _mask;
+        if (isFull(_ctrl[index])) {
+            func(_slots[index].key, _slots[index].value);
+        }
+        cursor |= ~_mask;
+        cursor = reverseBits(cursor);
+        ++cursor;
+        return reverseBits(cursor);
+    }
+
+    // 表自身占用的内存：槽数组与控制字节（按分配器实际分配的大小），不含键和值内部另外分配的内存
+    size_t memoryUsage() const {
+        return UsedMemory::usableSize(_ctrl) + UsedMemory::usableSize(_slots);
+    }
+
+    void clear() {
+        for (size_t i = 0; i < _capacity && _size; ++i) {
+            if (isFull(_ctrl[i])) {
+                _slots[i].~Slot();
+                --_size;
+            }
+        }
+        UsedMemory::free(_ctrl);
+        UsedMemory::free(_slots);
+        _ctrl = nullptr;
+        _slots = nullptr;
+        _capacity = _mask = _size = _deleted = 0;
+    }
+
+    // 负载过低（低于 1/10）时原地重建为较小的表，返回是否重建（空闲定时任务调用）
+    bool shrinkIfNeeded() {
+        if (_capacity <= kInitSize || _size * 10 >= _capacity) {
+            return false;
+        }
+        size_t capacity = kInitSize;
+        while (capacity * 7 < _size * 8 * 2) {
+            capacity <<= 1;
+        }
+        if (capacity >= _capacity) {
+            return false;
+        }
+        resize(capacity);
+        return true;
+    }
+
+private:
+    // 控制字节：满槽为哈希值低 7 位（0~127），空槽与删除标记的最高位为 1
+    static const int8_t kEmpty = -128;
+    static const int8_t kDeleted = -2;
+    static const size_t kNotFound = static_cast<size_t>(-1);
+
+    struct Slot {
+        template <typename... Args>
+        Slot(const K &k, Args &&...args) : key(k), value(std::forward<Args>(args)...) {}
+
+        K key;
+        V value;
+    };
+
+    static bool isFull(int8_t ctrl) {
+        return ctrl >= 0;
+    }
+
+    static size_t reverseBits(size_t v) {
+        size_t bits = sizeof(v) * 8;
+        size_t mask = ~size_t(0);
+        while ((bits >>= 1) > 0) {
+            mask ^= mask << bits;
+            v = ((v >> bits) & mask) | ((v << bits) & ~mask);
+        }
+        return v;
+    }
+
+    static int8_t h2(size_t hash) {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    static size_t h1(size_t hash) {
+        return hash >> 7;
+    }
+
+    // 从 ctrl 开始的 16 个控制字节中等于 tag 的位置掩码
+    static uint32_t match(const int8_t *ctrl, int8_t tag) {
+#if defined(__SSE2__)
+        auto group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i) {
+            mask |= static_cast<uint32_t>(ctrl[i] == tag) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // 空槽或删除标记（最高位为 1）的位置掩码
+    static uint32_t matchFree(const int8_t *ctrl) {
+#if defined(__SSE2__)
+        auto group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(group));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i) {
+            mask |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // 探测序列：每次跳过的组数递增（1, 2, 3 ...），容量为 2 的幂时可以遍历所有组
+    size_t findIndex(const K &key, size_t hash) const {
+        if (!_capacity) {
+            return kNotFound;
+        }
+        auto tag = h2(hash);
+        size_t pos = h1(hash) & _mask;
+        for (size_t step = kGroupWidth;; step += kGroupWidth) {
+            auto group = _ctrl + pos;
+            for (auto bits = match(group, tag); bits; bits &= bits - 1) {
+                auto index = (pos + __builtin_ctz(bits)) & _mask;
+                if (_equal(_slots[index].key, key)) {
+                    return index;
+                }
+            }
+            // 组中有空槽说明探测链到此为止
+            if (match(group, kEmpty)) {
+                return kNotFound;
+            }
+            pos = (pos + step) & _mask;
+        }
+    }
+
+    size_t findFree(size_t hash) const {
+        size_t pos = h1(hash) & _mask;
+        for (size_t step = kGroupWidth;; step += kGroupWidth) {
+            auto bits = matchFree(_ctrl + pos);
+            if (bits) {
+                return (pos + __builtin_ctz(bits)) & _mask;
+            }
+            pos = (pos + step) & _mask;
+        }
+    }
+
+    // 控制字节数组末尾多出 16 字节，复制开头的 16 个字节，这样从任意位置都能一次读完整的一组
+    void setCtrl(size_t index, int8_t ctrl) {
+        _ctrl[index] = ctrl;
+        if (index < kGroupWidth) {
+            _ctrl[_capacity + index] = ctrl;
+        }
+    }
+
+    void eraseAt(size_t index) {
+        _slots[index].~Slot();
+        --_size;
+        // 前后相邻的空槽加起来不足一组时，曾经有探测链经过这里（组内当时没有空槽），只能标记为删除
+        auto before = match(_ctrl + ((index - kGroupWidth) & _mask), kEmpty);
+        auto after = match(_ctrl + index, kEmpty);
+        bool wasNeverFull = before && after &&
+                            static_cast<size_t>(__builtin_ctz(after) + __builtin_clz(before << 16)) < kGroupWidth;
+        if (wasNeverFull) {
+            setCtrl(index, kEmpty);
+        } else {
+            setCtrl(index, kDeleted);
+            ++_deleted;
+        }
+    }
+
+    void resize(size_t capacity) {
+        auto oldCtrl = _ctrl;
+        auto oldSlots = _slots;
+        auto oldCapacity = _capacity;
+
+        _ctrl = static_cast<int8_t *>(UsedMemory::malloc(capacity + kGroupWidth));
+        _slots = static_cast<Slot *>(UsedMemory::malloc(capacity * sizeof(Slot)));
+        if (!_ctrl || !_slots) {
+            UsedMemory::free(_ctrl);
+            UsedMemory::free(_slots);
+            _ctrl = oldCtrl;
+            _slots = oldSlots;
+            throw std::bad_alloc();
+        }
+        memset(_ctrl, kEmpty, capacity + kGroupWidth);
+        _capacity = capacity;
+        _mask = capacity - 1;
+        _deleted = 0;
+
+        for (size_t i = 0; i < oldCapacity; ++i) {
+            if (isFull(oldCtrl[i])) {
+                auto hash = _hash(oldSlots[i].key);
+                auto index = findFree(hash);
+                setCtrl(index, h2(hash));
+                new (&_slots[index]) Slot(std::move(oldSlots[i]));
+                oldSlots[i].~Slot();
+            }
+        }
+        UsedMemory::free(oldCtrl);
+        UsedMemory::free(oldSlots);
+    }
+
+    void swap(FlatDict &other) {
+        std::swap(_ctrl, other._ctrl);
+        std::swap(_slots, other._slots);
+        std::swap(_capacity, other._capacity);
+        std::swap(_mask, other._mask);
+        std::swap(_size, other._size);
+        std::swap(_deleted, other._deleted);
+    }
+
+private:
+    int8_t *_ctrl = nullptr;    // 控制字节，_capacity + kGroupWidth 个
+    Slot *_slots = nullptr;
+    size_t _capacity = 0;       // 槽数，总是 2 的幂且不小于 kGroupWidth
+    size_t _mask = 0;
+    size_t _size = 0;
+    size_t _deleted = 0;        // 删除标记个数，同样占用探测链
+    Hash _hash;
+    Equal _equal;
+};
+
+} // namespace toolkit
+
+#endif
@@ -45,103 +45,27 @@ enum Command{
     MULTI,
     EXEC,
     DISCARD,
+    WATCH,
+    UNWATCH,
     COMMAND,
     SADD,
     SREM,
     SMEMBERS,
     SISMEMEBER,
+    INFO,
+    TYPE,
+    PING,
+    EXPIRE,
+    PEXPIRE,
+    TTL,
+    PERSIST,
+    MEMORY,
+    SCAN,
+    HSCAN,
+    SSCAN,
     INVALID_COMMAND
 };
 
-static std::unordered_map<std::string,enum Command>commandMaps={
-    {"set",SET},
-    {"setnx",SETNX},
-    {"setex",SETEX},
-    {"get",GET},
-    {"select",SELECT},
-    {"dbsize",DBSIZE},
-    {"exists",EXISTS},
-    {"del",DEL},
-    {"rename",RENAME},
-    {"incr",INCR},
-    {"incrby",INCRBY},
-    {"incrbyfloat",INCRBYFLOAT},
-    {"decr",DECR},
-    {"decrby",DECRBY},
-    {"mset",MSET},
-    {"mget",MGET},
-    {"hmset",HMSET},
-    {"hmget",HMGET},
-    {"strlen",STRLEN},
-    {"append",APPEND},
-    {"keys",KEYS},
-    {"lpush",LPUSH},
-    {"rpush",RPUSH},
-    {"lpop",LPOP},
-    {"rpop",RPOP},
-    {"lrange",LRANGE},
-    {"hset",HSET},
-    {"hget",HGET},
-    {"hdel",HDEL},
-    {"hgetall",HGETALL},
-    {"hkeys",HKEYS},
-    {"hvals",HVALS},
-    {"multi",MULTI},
-    {"exec",EXEC},
-    {"discard",DISCARD},
-    {"command",COMMAND},
-    {"sadd",SADD},
-    {"srem",SREM},
-    {"smembers",SMEMBERS},
-    {"sismember",SISMEMEBER}
-};
-
-static std::unordered_map<std::string, std::string> cmdDataTypeMaps={
-    {"set","STRING"},
-    {"setnx","STRING"},
-    {"setex","STRING"},
-    {"get","STRING"},
-    {"select","ALL"},
-    {"dbsize","ALL"},
-    {"exists","ALL"},
-    {"del","ALL"},
-    //{"rename",RENAME},
-    {"incr","STRING"},
-    {"incrby","STRING"},
-    //{"incrbyfloat",INCRBYFLOAT},
-    {"decr","STRING"},
-    {"decrby","STRING"},
-    {"mset","STRING"},
-    {"mget","STRING"},
-    {"hmset","HASH"},
-    {"hmget","HASH"},
-    {"strlen","STRING"},
-    {"append","STRING"},
-    {"keys","ALL"},
-    {"lpush","LIST"},
-    {"rpush","LIST"},
-    {"lpop","LIST"},
-    {"rpop","LIST"},
-    {"lrange","LIST"},
-     {"hset","HASH"},
-     {"hget","HASH"},
-     {"hdel","HASH"},
-     {"hgetall","HASH"},
-    // {"hkeys",HKEYS},
-    // {"hvals",HVALS},
-     {"multi","ALL"},
-     {"exec","ALL"},
-     {"discard","ALL"},
-     {"command","ALL"},
-     {"sadd","SET"},
-    {"srem","SET"},
-    {"smembers","SET"},
-    {"sismember","SET"}
-};
-
-
-
-
-
+// 各命令的名称、参数个数、标志与键位置见 CommandTable.h
 
 #endif
\ No newline at end of file
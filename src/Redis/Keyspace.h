@@ -0,0 +1,535 @@
+#ifndef KEYSPACE_H
+#define KEYSPACE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include "RedisObject.h"
+#include "RedisStats.h"
+
+namespace toolkit
+{
+
+// 每个数据库一个的键空间：键 -> 带类型标签的值对象
+// DEL / EXISTS / TYPE 只需一次哈希查找；同一个键只能有一种类型，类型不符时抛出 WrongTypeError
+// 底层哈希表见 HashTable：默认的 Dict 扩容不会造成长时间停顿，FlatDict 查找更快但扩容时一次性搬迁
+// 只有拥有本键空间的线程可以修改；使用 Dict 时其它线程可以在 Epoch::Guard 内通过 lookupShared 并发读取
+// 键空间占用内存的分类统计（MEMORY STATS），各数据库、各分片分别统计后累加
+struct MemoryStats {
+    size_t keys = 0;
+    size_t datasetBytes = 0;        // 键名与值（含值内部的分配）
+    size_t mainOverhead = 0;        // 键空间哈希表的桶数组与节点
+    size_t expiresOverhead = 0;     // 过期时间的登记
+    size_t typeKeys[4] = {};        // 按 ObjectType 分类的键数与内存
+    size_t typeBytes[4] = {};
+
+    MemoryStats &operator+=(const MemoryStats &other) {
+        keys += other.keys;
+        datasetBytes += other.datasetBytes;
+        mainOverhead += other.mainOverhead;
+        expiresOverhead += other.expiresOverhead;
+        for (int i = 0; i < 4; ++i) {
+            typeKeys[i] += other.typeKeys[i];
+            typeBytes[i] += other.typeBytes[i];
+        }
+        return *this;
+    }
+};
+
+// 过期登记（_expires）按键名的内容而不是指针比较与哈希，可以直接用参数中的键名查找
+struct StringPtrHash {
+    size_t operator()(const std::string *key) const {
+        return std::hash<std::string>()(*key);
+    }
+};
+
+struct StringPtrEqual {
+    bool operator()(const std::string *a, const std::string *b) const {
+        return *a == *b;
+    }
+};
+
+// 键的过期时间记在值对象上，访问时发现已过期立即删除（惰性过期）；带过期时间的键另外登记在 _expires 中，
+// 由定时任务按游标抽样删除已过期但一直没有被访问的键（主动过期，见 activeExpire）。
+// _expires 与键空间使用同一种哈希表，同样渐进式 rehash；使用 Dict 时登记项引用主表节点中的键名，不另外复制
+// SCAN 通过 scan 按反向二进制游标分批遍历，不会像 KEYS 一样一次取出所有键
+// 内存超出 maxmemory 时，RedisHelper::performEvictions 通过 sample 抽样、evict 淘汰键（见 EvictionPool）
+class Keyspace {
+public:
+    using Ptr = std::shared_ptr<Keyspace>;
+    static const size_t kMemorySamples = 5;     // 估算集合、哈希、列表的内存时默认抽样的元素数
+#ifdef REDIS_FLAT_HASH
+    using Map = FlatDict<std::string, ObjectRef>;
+    // FlatDict 的元素会随扩容搬迁，过期登记只能另存一份键名
+    using ExpireKey = std::string;
+    using Expires = FlatDict<ExpireKey, int64_t>;
+#else
+    using Map = Dict<std::string, ObjectRef, std::hash<std::string>, std::equal_to<std::string>, EpochReclaim>;
+    // Dict 的节点在键被删除前不会重新分配，登记主表节点中键名的地址；只有所有者线程访问，不需要推迟回收
+    using ExpireKey = const std::string *;
+    using Expires = Dict<ExpireKey, int64_t, StringPtrHash, StringPtrEqual>;
+#endif
+
+    /**
+    * @brief 创建键空间
+    * @param shard 分片模式下本键空间对应的分片
+    * @param shardCount 分片总数，1 表示不分片
+    */
+    explicit Keyspace(size_t shard = 0, size_t shardCount = 1) : _shard(shard), _shardCount(shardCount) {}
+
+    // 键所属的分片（FNV-1a）；与哈希表使用的 std::hash 相互独立，避免同一分片内的键集中在部分桶上
+    static size_t shardOf(const char *data, size_t len, size_t shardCount) {
+        if (shardCount <= 1) {
+            return 0;
+        }
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < len; ++i) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash % shardCount);
+    }
+
+    // 当前线程拥有的分片：分片模式下为所在 poller 的序号，单执行线程模式下恒为 0
+    static size_t &currentShard() {
+        static thread_local size_t shard = 0;
+        return shard;
+    }
+
+    // 键是否属于本分片（从快照加载时过滤）
+    bool owns(const std::string &key) const {
+        return _shardCount <= 1 || shardOf(key.data(), key.size(), _shardCount) == _shard;
+    }
+
+    // 查找键，不存在返回 nullptr
+    RedisObject *lookup(const std::string &key) {
+        auto slot = _dict.find(key);
+        if (!slot || !*slot) {
+            return nullptr;
+        }
+        if ((*slot)->expireAt() != RedisObject::kNoExpire && expireIfNeeded(key, getCurrentMillisecond())) {
+            return nullptr;
+        }
+        (*slot)->touch();
+        return slot->get();
+    }
+
+    // 是否支持其它线程并发读取（FlatDict 扩容与删除会原地搬迁元素，不支持）
+    static bool sharedReads() {
+#ifdef REDIS_FLAT_HASH
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    /**
+    * @brief 在非所有者线程中查找键，不存在返回 nullptr
+    * 必须在 Epoch::Guard 作用域内调用，返回的对象在离开作用域前有效；
+    * 只有整体替换（而不是原地修改）的值才能安全读取其内容，目前只有字符串满足
+    */
+    const RedisObject *lookupShared(const std::string &key) const {
+#ifdef REDIS_FLAT_HASH
+        return nullptr;
+#else
+        auto slot = _dict.findShared(key);
+        auto obj = slot ? slot->get() : nullptr;
+        if (obj) {
+            // 已过期的键由所有者线程删除，这里只当作不存在
+            if (obj->expired(getCurrentMillisecond())) {
+                return nullptr;
+            }
+            obj->touch();
+        }
+        return obj;
+#endif
+    }
+
+    // 按类型查找键，不存在返回 nullptr，类型不符抛出 WrongTypeError
+    template <typename T>
+    T *lookupTyped(const std::string &key) {
+        auto obj = lookup(key);
+        if (!obj) {
+            return nullptr;
+        }
+        if (obj->type() != T::kType) {
+            throw WrongTypeError();
+        }
+        return static_cast<T *>(obj);
+    }
+
+    // 按类型查找键，不存在时创建，类型不符抛出 WrongTypeError
+    template <typename T>
+    T *lookupOrCreate(const std::string &key) {
+        auto &slot = _dict[key];
+        if (slot && slot->expired(getCurrentMillisecond())) {
+            // 已过期的旧值不再可见，按新键处理
+            onExpired(key, false);
+            slot.replace(nullptr);
+        }
+        if (!slot) {
+            slot.replace(new T());
+            return static_cast<T *>(slot.get());
+        }
+        if (slot->type() != T::kType) {
+            throw WrongTypeError();
+        }
+        slot->touch();
+        return static_cast<T *>(slot.get());
+    }
+
+    // 写入键，覆盖原有的任意类型的值（SET 语义）
+    void set(const std::string &key, RedisObject::Ptr obj) {
+        // 新键直接带着值插入，读者不会看到空槽
+        auto result = _dict.emplace(key, obj.get());
+        auto raw = obj.release();
+        if (!result.second) {
+            // 新值不带过期时间
+            auto old = result.first->get();
+            if (old && old->expireAt() != RedisObject::kNoExpire) {
+                removeExpire(key);
+            }
+            result.first->replace(raw);
+        }
+    }
+
+    // 修改已有键的值，保留原有的过期时间（INCR、APPEND 等），键不存在时与 set 相同。
+    // 值仍然整体替换而不是原地修改，其它线程的并发读（lookupShared）不受影响
+    void update(const std::string &key, RedisObject::Ptr obj) {
+        auto result = _dict.emplace(key, obj.get());
+        auto raw = obj.release();
+        if (!result.second) {
+            // 过期时间在替换前设置，读者看到新值时它已经带着过期时间；_expires 中的记录不变
+            auto old = result.first->get();
+            if (old) {
+                raw->setExpireAt(old->expireAt());
+            }
+            result.first->replace(raw);
+        }
+    }
+
+    bool erase(const std::string &key) {
+        // 先删除过期登记，它可能引用着主表节点中的键名
+        removeExpire(key);
+        return _dict.erase(key) > 0;
+    }
+
+    /**
+    * @brief 设置键的过期时间
+    * @param at 过期时刻（getCurrentMillisecond 的时间戳），kNoExpire 表示取消过期时间
+    * @return 键不存在返回 false
+    */
+    bool setExpire(const std::string &key, int64_t at) {
+        auto obj = lookup(key);
+        if (!obj) {
+            return false;
+        }
+        obj->setExpireAt(at);
+        if (at == RedisObject::kNoExpire) {
+            removeExpire(key);
+        } else {
+            addExpire(key, at);
+        }
+        return true;
+    }
+
+    // 带过期时间的键数
+    size_t expires() const {
+        return _expires.size();
+    }
+
+    /**
+    * @brief 主动过期：从带过期时间的键中按 scan 游标每次取 kExpireSamples 个检查，删除其中已过期的，
+    * 已过期的比例超过 1/4 且未到 deadline（getCurrentMicrosecond）时继续下一次抽样
+    * @return 删除的键数
+    */
+    size_t activeExpire(uint64_t deadline) {
+        size_t removed = 0;
+        std::vector<std::string> batch;
+        while (!_expires.empty()) {
+            auto now = static_cast<int64_t>(getCurrentMillisecond());
+            size_t sampled = 0;
+            size_t steps = kExpireSamples * 4;
+            batch.clear();
+            // 空桶也计入访问次数，稀疏时不会扫描整个表；游标遍历跨越扩容、缩容与 rehash 也不会漏掉键，
+            // 游标回到 0 时本轮抽样结束，小表上同一个键不会在一轮中被取到两次
+            do {
+                _expireCursor = _expires.scan(_expireCursor, [&](const ExpireKey &key, const int64_t &at) {
+                    ++sampled;
+                    if (at <= now) {
+                        batch.push_back(expireName(key));
+                    }
+                });
+            } while (_expireCursor && sampled < kExpireSamples && --steps);
+            size_t expired = 0;
+            for (auto &key : batch) {
+                expired += expireIfNeeded(key, now, true);
+            }
+            removed += expired;
+            if (expired * 4 <= sampled || getCurrentMicrosecond() >= deadline) {
+                break;
+            }
+        }
+        return removed;
+    }
+
+    /**
+    * @brief 淘汰抽样：从 start 对应的位置起取出至多 count 个键，func(const std::string &, const RedisObject &)
+    * @param volatileOnly 只在带过期时间的键中抽样
+    * 不推进 rehash、不更新访问记录
+    */
+    template <typename Func>
+    void sample(size_t start, size_t count, bool volatileOnly, Func &&func) const {
+        if (!volatileOnly) {
+            _dict.sample(start, count, [&](const std::string &key, const ObjectRef &obj) {
+                if (obj) {
+                    func(key, *obj);
+                }
+            });
+            return;
+        }
+        _expires.sample(start, count, [&](const ExpireKey &key, const int64_t &) {
+            auto slot = _dict.find(expireName(key));
+            if (slot && *slot) {
+                func(expireName(key), **slot);
+            }
+        });
+    }
+
+    /**
+    * @brief 键占用内存的估算（MEMORY USAGE）：键空间中的节点（按平均值分摊桶数组）、键名、值以及过期时间的登记（同样按平均值分摊）
+    * @param samples 集合、哈希、列表抽样的元素数，0 表示计算所有元素
+    */
+    size_t memoryUsage(const std::string &key, const RedisObject &obj, size_t samples = kMemorySamples) const {
+        size_t size = _dict.memoryUsage() / std::max<size_t>(_dict.size(), 1) + valueMemory(key) + obj.memoryUsage(samples);
+        if (obj.expireAt() != RedisObject::kNoExpire) {
+            size += _expires.memoryUsage() / std::max<size_t>(_expires.size(), 1) + expireKeyMemory(key);
+        }
+        return size;
+    }
+
+    // 键占用内存的估算（MEMORY USAGE），不更新访问记录；键不存在返回 false
+    bool keyMemoryUsage(const std::string &key, size_t samples, size_t &bytes) {
+        auto slot = _dict.find(key);
+        if (!slot || !*slot) {
+            return false;
+        }
+        if ((*slot)->expireAt() != RedisObject::kNoExpire && expireIfNeeded(key, getCurrentMillisecond())) {
+            return false;
+        }
+        bytes = memoryUsage(key, **slot, samples);
+        return true;
+    }
+
+    // 键空间占用内存的分类统计（MEMORY STATS），累加到 stats；需遍历所有键
+    void memoryStats(MemoryStats &stats) const {
+        stats.mainOverhead += _dict.memoryUsage();
+        stats.expiresOverhead += _expires.memoryUsage();
+        _dict.forEach([&](const std::string &key, const ObjectRef &obj) {
+            if (!obj) {
+                return;
+            }
+            auto bytes = valueMemory(key) + obj->memoryUsage(kMemorySamples);
+            ++stats.keys;
+            ++stats.typeKeys[obj->type()];
+            stats.datasetBytes += bytes;
+            stats.typeBytes[obj->type()] += bytes;
+        });
+#ifdef REDIS_FLAT_HASH
+        _expires.forEach([&](const ExpireKey &key, const int64_t &) {
+            stats.expiresOverhead += expireKeyMemory(key);
+        });
+#endif
+    }
+
+    /**
+    * @brief 淘汰键（maxmemory），与删除相同，另外使 WATCH 了该键的事务失效
+    * @return 估算释放的内存，键不存在返回 0
+    */
+    size_t evict(const std::string &key) {
+        auto slot = static_cast<const Map &>(_dict).find(key);
+        if (!slot || !*slot) {
+            return 0;
+        }
+        // 集合等按抽样估算，淘汰大的值时不必遍历所有元素
+        auto freed = memoryUsage(key, **slot);
+        erase(key);
+        touchKey(key.data(), key.size());
+        return freed;
+    }
+
+    size_t size() const {
+        return _dict.size();
+    }
+
+    // 遍历所有键
+    template <typename Func>
+    void forEach(Func &&func) const {
+        auto now = static_cast<int64_t>(getCurrentMillisecond());
+        _dict.forEach([&](const std::string &key, const ObjectRef &obj) {
+            if (obj && !obj->expired(now)) {
+                func(key, *obj);
+            }
+        });
+    }
+
+    /**
+    * @brief 游标遍历键空间（SCAN），见 Dict::scan；遍历期间发现的已过期键不返回，遍历结束后删除
+    * @param count 至少访问的键数（未过滤前），最多访问 count * 10 个桶，保证每次调用的耗时有上限
+    * @return 下一个游标，0 表示遍历结束
+    */
+    template <typename Func>
+    size_t scan(size_t cursor, size_t count, Func &&func) {
+        auto now = static_cast<int64_t>(getCurrentMillisecond());
+        static thread_local std::vector<std::string> expired;
+        size_t visited = 0;
+        size_t steps = std::max<size_t>(count, 1) * 10;
+        do {
+            cursor = _dict.scan(cursor, [&](const std::string &key, const ObjectRef &obj) {
+                if (!obj) {
+                    return;
+                }
+                ++visited;
+                if (obj->expired(now)) {
+                    expired.push_back(key);
+                    return;
+                }
+                func(key, *obj);
+            });
+        } while (cursor && visited < count && --steps);
+        for (auto &key : expired) {
+            expireIfNeeded(key, now);
+        }
+        expired.clear();
+        return cursor;
+    }
+
+    // 删除某种类型的所有键（按类型加载快照前调用）
+    void clearType(ObjectType type) {
+        _dict.eraseIf([this, type](const std::string &key, const ObjectRef &obj) {
+            if (obj && obj->type() == type) {
+                removeExpire(key);
+                return true;
+            }
+            return false;
+        });
+    }
+
+    // 键的版本号（WATCH）：键被写命令修改后版本号增大
+    // 版本号按键的哈希记在固定数量的槽位中，不同的键可能共用一个槽位，冲突只会让 EXEC 多放弃一次，不会漏掉修改；
+    // 槽位表在第一次 WATCH 时才分配，从未使用 WATCH 的键空间写入时不需要记录版本
+    uint64_t keyVersion(const char *data, size_t len) {
+        if (_versions.empty()) {
+            _versions.assign(kVersionSlots, 0);
+        }
+        return _versions[versionSlot(data, len)];
+    }
+
+    // 键被修改，增大其版本号
+    void touchKey(const char *data, size_t len) {
+        if (!_versions.empty()) {
+            ++_versions[versionSlot(data, len)];
+        }
+    }
+
+    // 空闲时的 rehash：负载过低先开始缩容，再在 ms 毫秒内尽量推进 rehash（键空间与过期登记各自进行）
+    void activeRehash(int ms) {
+        _dict.shrinkIfNeeded();
+        if (_dict.isRehashing()) {
+            _dict.rehashMilliseconds(ms);
+        }
+        _expires.shrinkIfNeeded();
+        if (_expires.isRehashing()) {
+            _expires.rehashMilliseconds(ms);
+        }
+    }
+
+private:
+    static const size_t kExpireSamples = 20;    // 主动过期每次抽样的键数
+
+    static const std::string &expireName(const std::string &key) {
+        return key;
+    }
+    static const std::string &expireName(const std::string *key) {
+        return *key;
+    }
+
+    // 过期登记另外保存的键名占用的内存，使用 Dict 时与主表共用键名
+    static size_t expireKeyMemory(const std::string &key) {
+#ifdef REDIS_FLAT_HASH
+        return valueMemory(key);
+#else
+        return 0;
+#endif
+    }
+
+    // 登记键的过期时间，键必须存在
+    void addExpire(const std::string &key, int64_t at) {
+#ifdef REDIS_FLAT_HASH
+        _expires[key] = at;
+#else
+        if (auto stored = _dict.findKey(key)) {
+            _expires[stored] = at;
+        }
+#endif
+    }
+
+    void removeExpire(const std::string &key) {
+        if (_expires.empty()) {
+            return;
+        }
+#ifdef REDIS_FLAT_HASH
+        _expires.erase(key);
+#else
+        _expires.erase(&key);
+#endif
+    }
+    static const size_t kVersionBits = 16;
+    static const size_t kVersionSlots = size_t(1) << kVersionBits;
+
+    // 取 FNV-1a 的高位，与 shardOf 使用的低位（取模）相互独立
+    static size_t versionSlot(const char *data, size_t len) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < len; ++i) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash >> (64 - kVersionBits));
+    }
+
+    // 键已过期时删除并返回 true；_expires 中的记录与值对象不一致时（如已被覆盖）以值对象为准
+    bool expireIfNeeded(const std::string &key, int64_t now, bool active = false) {
+        auto slot = _dict.find(key);
+        auto obj = slot ? slot->get() : nullptr;
+        if (!obj || obj->expireAt() == RedisObject::kNoExpire) {
+            removeExpire(key);
+            return false;
+        }
+        if (!obj->expired(now)) {
+            addExpire(key, obj->expireAt());
+            return false;
+        }
+        onExpired(key, active);
+        _dict.erase(key);
+        return true;
+    }
+
+    void onExpired(const std::string &key, bool active) {
+        removeExpire(key);
+        touchKey(key.data(), key.size());
+        RedisStats::Instance().onExpired(active);
+    }
+
+    Map _dict;
+    Expires _expires;               // 带过期时间的键 -> 过期时刻，须在 _dict 之后声明（先于它析构）
+    size_t _expireCursor = 0;       // 主动过期抽样的 scan 游标
+    size_t _shard;
+    size_t _shardCount;
+    std::vector<uint64_t> _versions;    // 键的版本号槽位，见 keyVersion
+};
+
+} // namespace toolkit
+
+#endif
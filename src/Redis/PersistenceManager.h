@@ -64,26 +64,13 @@ public:
             std::string key = it->key().ToString();
             std::string serializeData = it->value().ToString();
             
-            // 后续可以增加类型
-            if(key == "STRING") {
-                auto redisString = std::make_shared<RedisString>();
-                redisString->deserialize(serializeData);
-                dataStore[key] = redisString;
-            }else if(key == "HASH") {
-                auto redisHash = std::make_shared<RedisHash>();
-                redisHash->deserialize(serializeData);
-                dataStore[key] = redisHash;
-            }else if(key == "SET") {
-                auto redisSet = std::make_shared<RedisSet>();
-                redisSet->deserialize(serializeData);
-                dataStore[key] = redisSet;
-            }else if(key == "LIST") {
-                auto redisList = std::make_shared<RedisList>();
-                redisList->deserialize(serializeData);
-                dataStore[key] = redisList;
-            }else {
+            // 各类型视图在 DataManager 构造时已创建，这里只恢复其数据
+            auto dataIt = dataStore.find(key);
+            if (dataIt == dataStore.end() || !dataIt->second) {
+                delete it;
                 throw std::runtime_error("Failed to load data form disk.");
             }
+            dataIt->second->deserialize(serializeData);
         }
         delete it;
     }
@@ -0,0 +1,82 @@
+#ifndef REDISCONFIG_H
+#define REDISCONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+namespace toolkit
+{
+
+// 内存达到 maxmemory 后的淘汰策略
+enum EvictionPolicy {
+    EVICT_NOEVICTION,       // 不淘汰，可能增加内存的写命令回复 -OOM
+    EVICT_ALLKEYS_LRU,      // 在所有键中淘汰最久未访问的
+    EVICT_ALLKEYS_LFU,      // 在所有键中淘汰访问频率最低的
+    EVICT_VOLATILE_LRU,     // 在带过期时间的键中淘汰最久未访问的
+    EVICT_VOLATILE_TTL      // 在带过期时间的键中淘汰最早过期的
+};
+
+inline const char *evictionPolicyName(EvictionPolicy policy) {
+    switch (policy) {
+        case EVICT_ALLKEYS_LRU: return "allkeys-lru";
+        case EVICT_ALLKEYS_LFU: return "allkeys-lfu";
+        case EVICT_VOLATILE_LRU: return "volatile-lru";
+        case EVICT_VOLATILE_TTL: return "volatile-ttl";
+        default: return "noeviction";
+    }
+}
+
+// 按名称解析淘汰策略，名称无效返回 false
+inline bool parseEvictionPolicy(const char *name, EvictionPolicy &policy) {
+    for (auto candidate : {EVICT_NOEVICTION, EVICT_ALLKEYS_LRU, EVICT_ALLKEYS_LFU, EVICT_VOLATILE_LRU,
+                           EVICT_VOLATILE_TTL}) {
+        if (strcmp(name, evictionPolicyName(candidate)) == 0) {
+            policy = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 服务器启动配置，由 main 解析命令行参数后填写，启动后只读
+class RedisConfig {
+public:
+    static RedisConfig &Instance() {
+        static RedisConfig instance;
+        return instance;
+    }
+    RedisConfig(const RedisConfig &) = delete;
+    RedisConfig &operator=(const RedisConfig &) = delete;
+
+    uint16_t port = 6380;               // 监听端口
+    bool replyBatching = true;          // 是否合并回复：同一会话在一轮处理中产生的回复只在结束时 flush 一次
+    size_t executorBatch = 128;         // 执行线程每轮最多连续执行的命令条数，之后统一 flush 回复
+    size_t executorThreads = 1;         // 执行线程数，多于 1 个时键空间按执行线程分片，命令按键的哈希分配
+    bool sharded = false;               // 分片模式：键空间按 poller 线程分片，命令在键所属分片的 poller 上直接执行
+    size_t shardCount = 1;              // 分片数，分片模式下等于 poller 线程数，否则等于执行线程数
+    bool fairScheduling = true;         // 执行线程按客户端轮流执行命令（见 FairScheduler），关闭后按到达顺序执行
+    size_t clientBudget = 16;           // 公平调度时每个客户端每轮最多连续执行的命令条数
+    size_t commandQueueSize = 65536;    // 命令队列容量（2 的幂），队列满时 poller 线程等待执行线程腾出空间
+    size_t maxQueueDepth = 0;           // 命令队列中等待的命令数达到该值后新命令回复 -BUSY，0 表示不限制
+    uint64_t maxQueueAgeMs = 0;         // 命令排队超过该时间（毫秒）后不再执行，回复 -BUSY，0 表示不限制
+    bool pollerReads = true;            // 只读命令（GET/MGET/STRLEN/EXISTS/TYPE/TTL）在 poller 线程中直接读取键空间
+    bool activeRehashing = true;        // 是否由定时任务在空闲时推进键空间的渐进式 rehash
+    int activeRehashMs = 1;             // 每次定时任务推进 rehash 的时间片（毫秒）
+    float activeRehashInterval = 0.1f;  // 定时任务周期（秒）
+    bool activeExpire = true;           // 是否由定时任务抽样删除已过期但没有被访问的键
+    int activeExpireMs = 2;             // 每次主动过期最多占用的时间（毫秒），超出后留到下一个周期
+    float activeExpireInterval = 0.1f;  // 主动过期周期（秒）
+    uint64_t clientTimeoutMs = 0;       // 连接空闲（没有发送命令）超过该时间（毫秒）后断开，0 表示不限制
+    size_t maxmemory = 0;               // 内存上限（字节，见 UsedMemory），写命令执行前超出时按 maxmemoryPolicy 淘汰键，0 表示不限制
+    EvictionPolicy maxmemoryPolicy = EVICT_NOEVICTION;
+    int maxmemorySamples = 5;           // 淘汰时每个数据库每次抽样的键数
+
+private:
+    RedisConfig() = default;
+};
+
+} // namespace toolkit
+
+#endif
@@ -1,14 +1,19 @@
 #ifndef REDISHELPER_H
 #define REDISHELPER_H
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <thread>
-#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include "SkipList.h"
 #include "PersistenceManager.h"
 #include "DataManager.h"
+#include "RedisConfig.h"
+#include "EvictionPool.h"
+#include "UsedMemory.h"
 #include "Global.h"
 
 namespace toolkit {
@@ -22,68 +27,262 @@ public:
         return instance;
     }
 
-    // 根据传入的命令返回需要操作的相应数据类型（string/hash/set等）
-    RedisDataType::Ptr getDataType(const std::string& cmd) {
-        std::string type = cmdDataTypeMaps[cmd];
-        if(type == "ALL") {
-            return nullptr;
-        }
-        return dataManager_[currentDbIndex_]->getDataType(type);
+    static const int kDbCount = 16;
+
+    static bool isValidDb(long dbIndex) {
+        return dbIndex >= 0 && dbIndex < kDbCount;
     }
 
+    // 以下接口中的 dbIndex 为会话当前选择的数据库（SELECT 是会话自身的状态，见 Session::getDbIndex）
+    // 分片模式下访问的是当前线程所属分片（Keyspace::currentShard）上的数据
+
+    // 当前线程所属分片上数据类型 T 的视图（见 TypedParser）
+    template <typename T>
+    T &store(int dbIndex) {
+        return dataManager_[dbIndex]->store<T>();
+    }
 
     // 获取匹配模式的所有键
-    std::vector<std::string> keys(const std::string &pattern) {
-        auto ret = dataManager_[currentDbIndex_]->keys(pattern);
+    std::vector<std::string> keys(int dbIndex, const std::string &pattern) {
+        auto ret = dataManager_[dbIndex]->keys(pattern);
         return ret;     // 按值返回：std::vector 支持移动语义，返回局部变量时编译器会优化为移动操作，不会有性能损失。
     }
 
     // 获取键总数（dbsize)
-    int dbsize() {
-        return dataManager_[currentDbIndex_]->dbsize();
+    int dbsize(int dbIndex) {
+        return dataManager_[dbIndex]->dbsize();
     }
     // 删除键
-    bool eraseKey(const std::string& key) {
-        return dataManager_[currentDbIndex_]->eraseKey(key);
+    bool eraseKey(int dbIndex, const std::string& key) {
+        return dataManager_[dbIndex]->eraseKey(key);
     }
 
     // 搜索建
-    bool exists(const std::string& key) {
-        return dataManager_[currentDbIndex_]->searchKey(key);
+    bool exists(int dbIndex, const std::string& key) {
+        return dataManager_[dbIndex]->searchKey(key);
+    }
+    // 键的类型
+    const char *keyType(int dbIndex, const std::string& key) {
+        return dataManager_[dbIndex]->keyType(key);
+    }
+    /**
+    * @brief 设置键在 at（getCurrentMillisecond 的时间戳）过期，at 已过去时直接删除键
+    * @return 键不存在返回 false
+    */
+    bool expireKey(int dbIndex, const StrView& key, int64_t at) {
+        auto &name = key.scratch();
+        if (at <= static_cast<int64_t>(getCurrentMillisecond())) {
+            return dataManager_[dbIndex]->eraseKey(name);
+        }
+        return dataManager_[dbIndex]->setExpire(name, at);
+    }
+    // 取消键的过期时间，键不存在或没有过期时间返回 false
+    bool persistKey(int dbIndex, const StrView& key) {
+        auto &name = key.scratch();
+        if (dataManager_[dbIndex]->expireAt(name) < 0) {
+            return false;
+        }
+        return dataManager_[dbIndex]->setExpire(name, RedisObject::kNoExpire);
+    }
+    // 键的剩余生存时间（毫秒）：键不存在返回 -2，没有过期时间返回 -1
+    int64_t keyTtl(int dbIndex, const StrView& key) {
+        return ttlOf(dataManager_[dbIndex]->expireAt(key.scratch()));
+    }
+    // poller 线程上的并发读取剩余生存时间，必须在 Epoch::Guard 内调用
+    int64_t keyTtlShared(int dbIndex, const StrView& key) {
+        auto obj = lookupShared(dbIndex, key);
+        return ttlOf(obj ? obj->expireAt() : -2);
+    }
+    // 主动过期：轮流检查各数据库，总耗时不超过 ms 毫秒（只能在拥有数据的线程中调用）
+    void activeExpire(int ms) {
+        auto deadline = getCurrentMicrosecond() + static_cast<uint64_t>(ms) * 1000;
+        for (auto &dataManager : dataManager_) {
+            if (getCurrentMicrosecond() >= deadline) {
+                break;
+            }
+            dataManager->activeExpire(deadline);
+        }
+        RedisStats::Instance().onExpireCycle();
+    }
+    /**
+    * @brief 写命令执行前检查 maxmemory：已用内存超出时按淘汰策略淘汰当前线程所属分片上的键，
+    * 直到估算释放的内存足以回到上限以内（只能在拥有数据的线程中调用）
+    * @return 未超出或淘汰后足够返回 true；策略为 noeviction 或没有可淘汰的键时返回 false，
+    *         此时可能增加内存的命令（CMD_DENYOOM）应回复 -OOM
+    */
+    bool performEvictions() {
+        auto &config = RedisConfig::Instance();
+        if (!config.maxmemory || UsedMemory::get() <= config.maxmemory) {
+            return true;
+        }
+        // 之前删除的键可能还在 Epoch 的回收袋中，先释放已经安全的部分
+        Epoch::Instance().collect();
+        auto used = UsedMemory::get();
+        if (used <= config.maxmemory) {
+            return true;
+        }
+        if (config.maxmemoryPolicy == EVICT_NOEVICTION) {
+            return false;
+        }
+        // 淘汰的键同样经 Epoch 推迟释放，已用内存不会立即下降，按键的内存估算累计释放量；
+        // 已用内存是全局的，多个分片各自只淘汰自己的一份，避免同时超出时各淘汰一遍
+        auto start = std::chrono::steady_clock::now();
+        auto toFree = (used - config.maxmemory + config.shardCount - 1) / std::max<size_t>(config.shardCount, 1);
+        size_t freed = 0;
+        size_t evicted = 0;
+        static thread_local EvictionPool pool;
+        static thread_local std::string key;
+        int dbIndex = 0;
+        while (freed < toFree) {
+            if (!fillEvictionPool(pool, config.maxmemoryPolicy, config.maxmemorySamples) && pool.empty()) {
+                break;
+            }
+            if (!pool.pop(dbIndex, key)) {
+                break;
+            }
+            auto bytes = dataManager_[dbIndex]->evictKey(key);
+            if (bytes) {
+                freed += bytes;
+                ++evicted;
+            }
+        }
+        Epoch::Instance().collect();
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        RedisStats::Instance().onEvicted(evicted, static_cast<uint64_t>(us.count()));
+        return freed >= toFree;
+    }
+    // 游标遍历当前线程所属分片上的键（SCAN），见 Keyspace::scan
+    template <typename Func>
+    size_t scan(int dbIndex, size_t cursor, size_t count, Func &&func) {
+        return dataManager_[dbIndex]->scanKeys(cursor, count, std::forward<Func>(func));
+    }
+    // 键占用内存的估算（MEMORY USAGE），键不存在返回 false
+    bool keyMemoryUsage(int dbIndex, const std::string& key, size_t samples, size_t &bytes) {
+        return dataManager_[dbIndex]->keyMemoryUsage(key, samples, bytes);
+    }
+    // 当前线程所属分片上各数据库的内存统计（MEMORY STATS），累加到 stats[dbIndex]
+    void memoryStats(std::vector<MemoryStats> &stats) {
+        stats.resize(kDbCount);
+        for (int i = 0; i < kDbCount; ++i) {
+            dataManager_[i]->memoryStats(stats[i]);
+        }
+    }
+    // 键的版本号（WATCH/EXEC 比较），只能在键所属分片的线程中调用
+    uint64_t keyVersion(int dbIndex, const StrView& key) {
+        return dataManager_[dbIndex]->keyVersion(key.data(), key.size());
     }
+    // 写命令修改了键，使 WATCH 了该键的事务在 EXEC 时放弃
+    void touchKey(int dbIndex, const StrView& key) {
+        dataManager_[dbIndex]->touchKey(key.data(), key.size());
+    }
+    // poller 线程上的并发读（只读命令），必须在 Epoch::Guard 内调用，返回值在离开作用域前有效
+    const RedisObject *lookupShared(int dbIndex, const StrView& key) {
+        return dataManager_[dbIndex]->lookupShared(key.scratch());
+    }
+    // 并发读取字符串键，不存在返回 nullptr，类型不符抛出 WrongTypeError
+    const std::string *getStringShared(int dbIndex, const StrView& key) {
+        auto obj = lookupShared(dbIndex, key);
+        if (!obj) {
+            return nullptr;
+        }
+        if (obj->type() != OBJ_STRING) {
+            throw WrongTypeError();
+        }
+        return &static_cast<const StringObject *>(obj)->value;
+    }
+    // 同 getStringShared，键不是字符串时也返回 nullptr（MGET）
+    const std::string *findStringShared(int dbIndex, const StrView& key) {
+        auto obj = lookupShared(dbIndex, key);
+        return obj && obj->type() == OBJ_STRING ? &static_cast<const StringObject *>(obj)->value : nullptr;
+    }
+    // 空闲时推进所有数据库键空间的渐进式 rehash，每个库最多 ms 毫秒（只能在拥有数据的线程中调用）
+    // 顺带释放本线程推迟回收的内存，写入停止后也不会一直占着
+    void activeRehash(int ms) {
+        for (auto &dataManager : dataManager_) {
+            dataManager->activeRehash(ms);
+        }
+        Epoch::Instance().collect();
+    }
+
+    // 持久化所有数据库（只在没有其它线程访问数据时调用；运行中的定期刷盘见 snapshotShard 与 persistSnapshots）
     void persistChanges(bool sync = false) {
-        dataManager_[currentDbIndex_]->persistDataToDisk(sync);
+        for (auto &dataManager : dataManager_) {
+            dataManager->persistDataToDisk(sync);
+        }
     }
 
-    void loadFromStorage() {
-        dataManager_[currentDbIndex_]->loadDataFromDisk();
+    // 一个分片上各数据库的快照，下标为数据库编号
+    using Snapshot = std::vector<std::unordered_map<std::string, std::string>>;
+
+    // 当前线程所属分片上所有数据库的快照（只能在拥有数据的线程中调用）
+    Snapshot snapshotShard() {
+        Snapshot snapshot;
+        snapshot.reserve(dataManager_.size());
+        for (auto &dataManager : dataManager_) {
+            snapshot.emplace_back(dataManager->snapshotShard());
+        }
+        return snapshot;
+    }
+
+    // 把各分片的快照写入磁盘（快照被移走），shards[i] 为分片 i 的快照，可在任意线程中调用
+    void persistSnapshots(std::vector<Snapshot> &shards, bool sync = false) {
+        for (size_t db = 0; db < dataManager_.size(); ++db) {
+            std::vector<std::unordered_map<std::string, std::string>> snapshots;
+            snapshots.reserve(shards.size());
+            for (auto &shard : shards) {
+                snapshots.push_back(std::move(shard[db]));
+            }
+            dataManager_[db]->persistSnapshots(snapshots, sync);
+        }
     }
 
-    // 切换当前数据库
-    void selectDatabase(int dbIndex) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if(dbIndex < 0 || dbIndex >= 16) {
-            return ;
+    // 启动时加载所有数据库，之后 SELECT 不再读盘
+    void loadFromStorage() {
+        for (auto &dataManager : dataManager_) {
+            dataManager->loadDataFromDisk();
         }
-        currentDbIndex_ = dbIndex;
-        dataManager_[currentDbIndex_]->loadDataFromDisk();
     }
 
     ~RedisHelper() { };
 
 private:
     // 因为辅助类 RedisHelper 只会存在单个实例，
-    RedisHelper() : currentDbIndex_(0) {
+    RedisHelper() {
         // 初始化16个数据库的数据管理器
-        dataManager_.resize(16);
-        for(int i = 0; i < 16; ++i) {
-            dataManager_[i] = std::make_shared<DataManager>(i);
+        dataManager_.resize(kDbCount);
+        for(int i = 0; i < kDbCount; ++i) {
+            dataManager_[i] = std::make_shared<DataManager>(i, RedisConfig::Instance().shardCount);
+        }
+    }
+
+    // 从各数据库抽样 samples 个键放入淘汰候选池，返回抽到的键数
+    size_t fillEvictionPool(EvictionPool &pool, EvictionPolicy policy, int samples) {
+        bool volatileOnly = policy == EVICT_VOLATILE_LRU || policy == EVICT_VOLATILE_TTL;
+        size_t sampled = 0;
+        for (int i = 0; i < kDbCount; ++i) {
+            auto &dataManager = dataManager_[i];
+            if (volatileOnly ? dataManager->expires() == 0 : dataManager->dbsize() == 0) {
+                continue;
+            }
+            dataManager->sampleKeys(pool.randomStart(), samples, volatileOnly,
+                                    [&](const std::string &name, const RedisObject &obj) {
+                pool.insert(EvictionPool::score(policy, obj), i, name);
+                ++sampled;
+            });
+        }
+        return sampled;
+    }
+
+    // 过期时刻换算为剩余毫秒数，-2/-1（不存在/永不过期）原样返回
+    static int64_t ttlOf(int64_t at) {
+        if (at < 0) {
+            return at;
         }
+        auto left = at - static_cast<int64_t>(getCurrentMillisecond());
+        return left > 0 ? left : 0;
     }
 
-    int currentDbIndex_ = 0;
     std::vector<DataManager::Ptr> dataManager_;
-    std::mutex mutex_;
     // DataManager::Ptr dataManager_;      // 数据管理器
 };
 
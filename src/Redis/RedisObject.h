@@ -0,0 +1,310 @@
+#ifndef REDISOBJECT_H
+#define REDISOBJECT_H
+
+#include <string>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "Util/util.h"
+#include "Dict.h"
+#include "FlatDict.h"
+#include "Epoch.h"
+
+namespace toolkit
+{
+
+// 键空间、集合、哈希使用的哈希表实现
+// 默认为渐进式 rehash 的 Dict（扩容无停顿）；编译时定义 REDIS_FLAT_HASH（make FLAT_HASH=1）改用开放寻址的 FlatDict（查找更快、内存更省）
+#ifdef REDIS_FLAT_HASH
+template <typename K, typename V>
+using HashTable = FlatDict<K, V>;
+#else
+template <typename K, typename V>
+using HashTable = Dict<K, V>;
+#endif
+
+template <typename K>
+using HashSet = HashTable<K, DictEmpty>;
+
+inline const char *hashTableName() {
+#ifdef REDIS_FLAT_HASH
+    return "flat";
+#else
+    return "dict";
+#endif
+}
+
+// 键的值类型
+enum ObjectType : uint8_t {
+    OBJ_STRING,
+    OBJ_LIST,
+    OBJ_SET,
+    OBJ_HASH
+};
+
+// 值的内部编码
+enum ObjectEncoding : uint8_t {
+    ENC_RAW,            // 普通字符串
+    ENC_INT,            // 可以表示为 64 位整数的字符串
+    ENC_EMBSTR,         // 短字符串（<= 44 字节）
+    ENC_DEQUE,          // 列表
+    ENC_HASHTABLE       // 集合 / 哈希
+};
+
+// 对不匹配类型的键执行命令时抛出，由执行线程统一回复 -WRONGTYPE
+class WrongTypeError : public std::runtime_error {
+public:
+    WrongTypeError() : std::runtime_error("WRONGTYPE Operation against a key holding the wrong kind of value") {}
+};
+
+// 键空间中的一个值：类型标签 + 每个键的元数据，具体数据在 TypedObject 中
+class RedisObject {
+public:
+    using Ptr = std::unique_ptr<RedisObject>;
+
+    static const int64_t kNoExpire = -1;
+
+    virtual ~RedisObject() = default;
+
+    ObjectType type() const { return _type; }
+
+    ObjectEncoding encoding() const { return _encoding; }
+    void setEncoding(ObjectEncoding encoding) { _encoding = encoding; }
+
+    // 访问记录，poller 线程上的并发读也会更新；与 Redis 相同，LRU 与 LFU 共用一个字段：
+    // LRU 时为最近一次访问的时钟（秒），LFU 时高 16 位为计数最近一次衰减的时间（分钟），低 8 位为对数访问计数
+    uint32_t lru() const { return _lru.load(std::memory_order_relaxed); }
+    void touch() {
+        if (lfuMode()) {
+            _lru.store(lfuTouch(lru()), std::memory_order_relaxed);
+        } else {
+            _lru.store(lruClock(), std::memory_order_relaxed);
+        }
+    }
+
+    // 访问记录按 LFU 维护（淘汰策略为 allkeys-lfu），启动时设置
+    static bool &lfuMode() {
+        static bool lfu = false;
+        return lfu;
+    }
+
+    // 距最近一次访问的秒数（LRU）
+    uint32_t idleTime() const {
+        auto now = lruClock();
+        auto last = lru();
+        return now >= last ? now - last : 0;
+    }
+
+    // 按经过的时间衰减后的访问计数（LFU），不修改记录
+    uint8_t lfuCounter() const {
+        return lfuDecay(lru());
+    }
+
+    // 值占用内存的估算（字节）：对象本身加上值内部另外分配的内存，samples 见 valueMemory
+    virtual size_t memoryUsage(size_t samples) const = 0;
+
+    // 过期时间（getCurrentMillisecond 的时间戳），kNoExpire 表示永不过期；poller 线程上的并发读也会读取
+    int64_t expireAt() const { return _expireAt.load(std::memory_order_relaxed); }
+    void setExpireAt(int64_t ms) { _expireAt.store(ms, std::memory_order_relaxed); }
+    bool expired(int64_t now) const {
+        auto at = expireAt();
+        return at != kNoExpire && at <= now;
+    }
+
+    static uint32_t lruClock() {
+        return static_cast<uint32_t>(getCurrentMillisecond() / 1000);
+    }
+
+    static const uint32_t kLfuInitValue = 5;    // 新键的访问计数，避免刚写入就被淘汰
+    static const uint32_t kLfuLogFactor = 10;   // 计数越大增长越慢，约 100 万次访问达到 255
+    static const uint32_t kLfuDecayMinutes = 1; // 每经过这么多分钟计数减 1
+
+    static const char *typeName(ObjectType type) {
+        switch (type) {
+            case OBJ_STRING: return "string";
+            case OBJ_LIST: return "list";
+            case OBJ_SET: return "set";
+            case OBJ_HASH: return "hash";
+            default: return "none";
+        }
+    }
+
+    static const char *encodingName(ObjectEncoding encoding) {
+        switch (encoding) {
+            case ENC_RAW: return "raw";
+            case ENC_INT: return "int";
+            case ENC_EMBSTR: return "embstr";
+            case ENC_DEQUE: return "deque";
+            case ENC_HASHTABLE: return "hashtable";
+            default: return "unknown";
+        }
+    }
+
+protected:
+    RedisObject(ObjectType type, ObjectEncoding encoding)
+        : _type(type), _encoding(encoding), _lru(lfuMode() ? (lfuMinutes() << 8) | kLfuInitValue : lruClock()) {}
+
+private:
+    static uint32_t lfuMinutes() {
+        return static_cast<uint32_t>(getCurrentMillisecond() / 60000) & 0xFFFF;
+    }
+
+    static uint8_t lfuDecay(uint32_t value) {
+        auto last = value >> 8;
+        auto counter = value & 0xFF;
+        auto now = lfuMinutes();
+        auto elapsed = now >= last ? now - last : 0x10000 - last + now;
+        auto periods = elapsed / kLfuDecayMinutes;
+        return static_cast<uint8_t>(periods >= counter ? 0 : counter - periods);
+    }
+
+    // 先衰减再按概率 1 / ((counter - kLfuInitValue) * kLfuLogFactor + 1) 加 1
+    static uint32_t lfuTouch(uint32_t value) {
+        uint32_t counter = lfuDecay(value);
+        if (counter < 255) {
+            static thread_local uint64_t seed = 0x9E3779B97F4A7C15ULL;
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            auto base = counter > kLfuInitValue ? counter - kLfuInitValue : 0;
+            if ((seed >> 11) * (1.0 / 9007199254740992.0) * (base * kLfuLogFactor + 1) < 1.0) {
+                ++counter;
+            }
+        }
+        return (lfuMinutes() << 8) | counter;
+    }
+
+    ObjectType _type;
+    ObjectEncoding _encoding;
+    std::atomic<uint32_t> _lru;
+    std::atomic<int64_t> _expireAt{kNoExpire};
+};
+
+// 值内部另外分配的内存（按分配器实际分配的大小）
+// samples 为 0 时计算所有元素；否则只计算前 samples 个元素，按平均值估算整体（MEMORY USAGE 的 SAMPLES）
+
+// 字符串在堆上另外分配的内存（短字符串存放在对象内部）
+inline size_t valueMemory(const std::string &str, size_t samples = 0) {
+    static const size_t kInline = std::string().capacity();
+    return str.capacity() > kInline ? UsedMemory::usableSize(str.data()) : 0;
+}
+
+// std::deque 按 512 字节的块存放元素，另有一个块指针数组（至少 8 项）
+inline size_t valueMemory(const std::deque<std::string> &list, size_t samples = 0) {
+    static const size_t kBlockSize = UsedMemory::allocSize(512);
+    auto blocks = list.size() * sizeof(std::string) / 512 + 1;
+    size_t size = blocks * kBlockSize + UsedMemory::allocSize(std::max<size_t>(blocks + 2, 8) * sizeof(void *));
+    if (!samples || samples >= list.size()) {
+        for (auto &item : list) {
+            size += valueMemory(item);
+        }
+        return size;
+    }
+    size_t sampled = 0;
+    for (size_t i = 0; i < samples; ++i) {
+        sampled += valueMemory(list[i]);
+    }
+    return size + sampled * list.size() / samples;
+}
+
+inline size_t valueMemory(const DictEmpty &, size_t samples = 0) {
+    return 0;
+}
+
+template <typename V>
+size_t valueMemory(const HashTable<std::string, V> &table, size_t samples = 0) {
+    size_t size = table.memoryUsage();
+    size_t elements = 0;
+    auto func = [&](const std::string &key, const V &value) {
+        elements += valueMemory(key) + valueMemory(value);
+    };
+    if (!samples || samples >= table.size()) {
+        table.forEach(func);
+        return size + elements;
+    }
+    auto sampled = table.sample(0, samples, func);
+    return sampled ? size + elements * table.size() / sampled : size;
+}
+
+// 带具体数据的值对象，T 为存储类型，Type 为对应的类型标签
+// 通过类型标签比较后 static_cast，查找时不需要 dynamic_cast
+template <typename T, ObjectType Type, ObjectEncoding Encoding>
+class TypedObject : public RedisObject {
+public:
+    static const ObjectType kType = Type;
+
+    TypedObject() : RedisObject(Type, Encoding) {}
+    explicit TypedObject(T value) : RedisObject(Type, Encoding), value(std::move(value)) {}
+
+    size_t memoryUsage(size_t samples) const override {
+        static const size_t kObjectSize = UsedMemory::allocSize(sizeof(TypedObject));
+        return kObjectSize + valueMemory(value, samples);
+    }
+
+    T value;
+};
+
+using StringObject = TypedObject<std::string, OBJ_STRING, ENC_RAW>;
+using ListObject = TypedObject<std::deque<std::string>, OBJ_LIST, ENC_DEQUE>;
+using SetObject = TypedObject<HashSet<std::string>, OBJ_SET, ENC_HASHTABLE>;
+using HashObject = TypedObject<HashTable<std::string, std::string>, OBJ_HASH, ENC_HASHTABLE>;
+
+// 键空间中指向值对象的槽：独占所有权，指针的读写是原子的。
+// poller 线程上的读者可能仍在访问被替换下来的旧值，因此替换时旧值经 Epoch 推迟释放；
+// 槽本身析构时（所在节点已经过 Epoch 回收）直接释放。
+class ObjectRef {
+public:
+    ObjectRef() = default;
+    explicit ObjectRef(RedisObject *obj) : _obj(obj) {}
+    ObjectRef(ObjectRef &&other) noexcept : _obj(other.release()) {}
+    ObjectRef &operator=(ObjectRef &&other) noexcept {
+        replace(other.release());
+        return *this;
+    }
+    ~ObjectRef() {
+        delete _obj.load(std::memory_order_relaxed);
+    }
+
+    RedisObject *get() const { return _obj.load(std::memory_order_acquire); }
+    RedisObject *operator->() const { return get(); }
+    RedisObject &operator*() const { return *get(); }
+    explicit operator bool() const { return get() != nullptr; }
+
+    RedisObject *release() {
+        return _obj.exchange(nullptr, std::memory_order_relaxed);
+    }
+
+    // 替换为 obj（构造完成后才对读者可见），旧值推迟释放
+    void replace(RedisObject *obj) {
+        auto old = _obj.load(std::memory_order_relaxed);
+        _obj.store(obj, std::memory_order_release);
+        if (old) {
+            Epoch::Instance().retire(old);
+        }
+    }
+
+private:
+    std::atomic<RedisObject *> _obj{nullptr};
+};
+
+// 根据字符串内容选择编码
+inline ObjectEncoding stringEncoding(const std::string &value) {
+    if (!value.empty() && value.size() < 20) {
+        size_t i = value[0] == '-' ? 1 : 0;
+        bool digits = i < value.size() && (value[i] != '0' || value.size() == i + 1);
+        for (; digits && i < value.size(); ++i) {
+            digits = value[i] >= '0' && value[i] <= '9';
+        }
+        if (digits) {
+            return ENC_INT;
+        }
+    }
+    return value.size() <= 44 ? ENC_EMBSTR : ENC_RAW;
+}
+
+} // namespace toolkit
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "Network/TcpServer.h"
 #include "CmdParserFactory.h"  
+#include "RedisConfig.h"
 
 namespace toolkit
 {
@@ -39,16 +40,90 @@ public:
                 if (!strong_self) {
                     return false;
                 }
-                strong_self->_cmdParserFactor->getRedisHelper()->persistChanges();
+                strong_self->persistChanges();
                 return true;
 
                 }, _poller);
         }
+        // 分片需在接受连接之前绑定到所有者线程：分片模式下 poller i 独占分片 i，多执行线程时执行线程 i 独占分片 i
+        if (RedisConfig::Instance().sharded) {
+            ShardRouter::Instance().start(EventPollerPool::Instance());
+        } else if (CommandQueueManager::Instance().getExecutorSize() > 1) {
+            ShardRouter::Instance().start(CommandQueueManager::Instance());
+        }
+        if (RedisConfig::Instance().activeRehashing) {
+            // 键空间只能在拥有它的线程中访问，定时任务只负责把 rehash 任务投递过去：
+            // 启用分片路由时投递到每个分片的所有者线程，否则投递到命令队列
+            auto &config = RedisConfig::Instance();
+            auto ms = config.activeRehashMs;
+            _activeRehashTimer = std::make_shared<Timer>(config.activeRehashInterval, [ms]() {
+                auto &router = ShardRouter::Instance();
+                if (router.enabled()) {
+                    router.broadcast([ms]() {
+                        RedisHelper::instance()->activeRehash(ms);
+                    });
+                } else {
+                    CommandQueueManager::Instance().pushCommand([ms]() {
+                        RedisHelper::instance()->activeRehash(ms);
+                    });
+                }
+                return true;
+            }, _poller);
+        }
+        if (RedisConfig::Instance().activeExpire) {
+            // 与 rehash 相同，主动过期投递到拥有键空间的线程执行，每次最多占用 activeExpireMs
+            auto &config = RedisConfig::Instance();
+            auto ms = config.activeExpireMs;
+            _activeExpireTimer = std::make_shared<Timer>(config.activeExpireInterval, [ms]() {
+                auto &router = ShardRouter::Instance();
+                if (router.enabled()) {
+                    router.broadcast([ms]() {
+                        RedisHelper::instance()->activeExpire(ms);
+                    });
+                } else {
+                    CommandQueueManager::Instance().pushCommand([ms]() {
+                        RedisHelper::instance()->activeExpire(ms);
+                    });
+                }
+                return true;
+            }, _poller);
+        }
         this->start(port, host, backlog, cb);
     }
 private:
+    // 定期刷盘：与 rehash、过期相同，各分片的快照在拥有它的线程中生成，全部生成后回到本 poller 写入 LevelDB，
+    // 序列化时不会有其它线程修改或 rehash 键空间
+    void persistChanges() {
+        auto helper = _cmdParserFactor->getRedisHelper();
+        auto &router = ShardRouter::Instance();
+        auto shards = router.enabled() ? router.shardCount() : 1;
+        auto snapshots = std::make_shared<std::vector<RedisHelper::Snapshot>>(shards);
+        auto poller = _poller;
+        auto write = [helper, snapshots, poller]() {
+            poller->async([helper, snapshots]() {
+                helper->persistSnapshots(*snapshots);
+            }, false);
+        };
+        if (!router.enabled()) {
+            CommandQueueManager::Instance().pushCommand([helper, snapshots, write]() {
+                (*snapshots)[0] = helper->snapshotShard();
+                write();
+            });
+            return;
+        }
+        std::vector<size_t> all(shards);
+        for (size_t i = 0; i < shards; ++i) {
+            all[i] = i;
+        }
+        router.scatter(all, [helper, snapshots](size_t shard) {
+            (*snapshots)[shard] = helper->snapshotShard();
+        }, write);
+    }
+
     CmdParserFactory::Ptr _cmdParserFactor;     // 命令解析工厂
     Timer::Ptr _redisServerTimer;       // 全局的redis Server的时间定时刷盘器
+    Timer::Ptr _activeRehashTimer;      // 空闲 rehash 定时器
+    Timer::Ptr _activeExpireTimer;      // 主动过期定时器
 };   
 } // namespace toolkit
 
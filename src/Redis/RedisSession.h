@@ -1,11 +1,19 @@
 #ifndef REDISSESSION_H
 #define REDISSESSION_H
 
+#include <atomic>
 #include "Util/logger.h"
 #include "Util/TimeTicker.h"
 #include "RedisServer.h"
 #include "Network/Session.h"
 #include "CmdQueue.h"
+#include "CmdQueueManager.h"
+#include "RespParser.h"
+#include "CmdArgs.h"
+#include "CmdDesc.h"
+#include "SharedReply.h"
+#include "RedisConfig.h"
+#include "RedisStats.h"
 #include "SkipList.h"
 #include "CmdParserFactory.h"
 
@@ -18,55 +26,76 @@ public:
     RedisSession (const Socket::Ptr &sock) :
             Session(sock) {
         _cmdParserFactor = CmdParserFactory::Instance();
+        // 合并回复模式下 send 只把回复放入 socket 的发送缓存，由执行线程每轮结束或 onRecv 结束时统一 flush
+        setSendFlushFlag(!RedisConfig::Instance().replyBatching);
+        // 分片模式下在其它分片执行的命令，回复经排序器按命令顺序发送
+        _sequencer.setSender([this](const Buffer::Ptr &buf) {
+            RedisStats::Instance().onReply();
+            _unflushed.store(true, std::memory_order_relaxed);
+            Session::send(buf);
+        }, [this]() {
+            if (RedisConfig::Instance().replyBatching) {
+                flushReplies();
+            }
+        });
         //DebugL << "New RedisSession created: " << sock->get_local_ip() << ":" <<sock->get_local_port();
     }
     ~RedisSession () {
         //DebugL << "RedisSession destroyed.";
     }
+    // 启用 clientTimeoutMs 时在 poller 的时间轮上为连接挂一个空闲检测定时器，到期时按最后一次收到数据的时间重新计算下次检测
+    void attachServer(const Server &server) override {
+        auto timeout = RedisConfig::Instance().clientTimeoutMs;
+        if (!timeout) {
+            return;
+        }
+        _lastActive = getCurrentMillisecond();
+        std::weak_ptr<RedisSession> weakSelf = std::static_pointer_cast<RedisSession>(shared_from_this());
+        getPoller()->doDelayTask(timeout, [weakSelf, timeout]() -> uint64_t {
+            auto strongSelf = weakSelf.lock();
+            return strongSelf ? strongSelf->checkIdle(timeout) : 0;
+        });
+    }
+
     virtual void onRecv(const Buffer::Ptr &buf) override{
         //处理客户端发送过来的数据  [AUTO-TRANSLATED:c095b82e]
         // Handle data sent from the client
-        std::string received_data = buf->toString();
-        //DebugL << "Receive data: " << received_data;
-
-        // 1. 初步命令解析：由 RESP 格式转化为vector存储的多个 string 格式
-        std::vector<std::string> tokens = parseRESPCommand(received_data);
-        if (tokens.empty()) {
-            send("-Protocol error\r\n");
+        _lastActive = getCurrentMillisecond();
+        if (_closing) {
+            // 协议错误后等待断开，之后收到的数据不再处理
             return;
         }
-        // 2. 得到相应命令的解析器
-        const std::string cmd = tokens.front();
-        std::shared_ptr<CommandParser> commandParser = _cmdParserFactor->getParser(cmd);
-        if(commandParser == nullptr) {
-            send("-ERR unknown command\r\n");
+        // 1. 收到的 buf 是 poller 线程共享的读缓存，不能被持有；整块追加到会话自己的接收缓存中，
+        //    上次未解析完的数据也在其中，解析器从断点继续解析
+        appendRecvData(buf->data(), buf->size());
+        dispatchCommands();
+        // 3. 本次读取中在 poller 线程直接产生的回复（错误、+QUEUED 等）一次性发出
+        if (RedisConfig::Instance().replyBatching) {
+            flushReplies();
         }
-        auto self = std::dynamic_pointer_cast<Session>(shared_from_this());
-        // 3. 如果处于事务中且非事务控制命令，加入事务队列
-        if(_transactionContext.isTransactionActive() && cmd != "exec" && cmd != "discard") {
-            if(commandParser->parserCommand(tokens, self)){
-                _transactionContext.addCommandToQueue([commandParser, tokens, self](std::ostringstream& result){
-                    commandParser->parserAndExecuter(tokens, self);
-                });
-                send("+QUEUED\r\n");    // 注意一定要发送响应
-                return;
-            }
-            _transactionContext.endTransaction(); 
-            return;
-        }
-        // 4. 非事务模式或事务控制命令，解析器解析并将命令加入命令队列等待执行
-        if(commandParser) {
-            try{
-                commandParser->parserAndExecuter(tokens, self);
-            } catch (std::exception & ex){
-                send("-ERR unknown command\r\n");
-            } 
+    }
+
+    void holdCommands() override {
+        _held = true;
+    }
+
+    void resumeCommands() override {
+        _held = false;
+        dispatchCommands();
+        if (RedisConfig::Instance().replyBatching) {
+            flushReplies();
         }
     }
+
     virtual void onError(const SockException &err) override{
         //客户端断开连接或其他原因导致该对象脱离TCPServer管理  [AUTO-TRANSLATED:6b958a7b]
         // Client disconnects or other reasons cause the object to be removed from TCPServer management
         //WarnL << err;
+        _closed.store(true, std::memory_order_release);
+    }
+
+    bool closed() const override {
+        return _closed.load(std::memory_order_acquire);
     }
     virtual void onManager() override{
         //DebugL <<"Connect:" << this->get_peer_ip() <<" : " << this->get_peer_port() << " is alived !";
@@ -81,54 +110,239 @@ public:
         // }
     }
 
+    using Session::send;
+    ssize_t send(Buffer::Ptr buf) override {
+        // 在其它分片上为本会话执行命令时，回复先捕获下来再投递回本会话
+        if (auto replies = ReplySequencer::Capture::target(this)) {
+            auto size = buf->size();
+            replies->emplace_back(std::move(buf));
+            return size;
+        }
+        // 前面还有未回复的命令，排在它们之后发送
+        if (!_sequencer.idle()) {
+            auto size = buf->size();
+            _sequencer.deliver(_sequencer.reserve(), {std::move(buf)});
+            return size;
+        }
+        // 单执行线程模式下 poller 线程直接产生的回复（错误、+QUEUED 等），前面还有命令在命令队列中排队时，
+        // 也经命令队列发送，排在它们的回复之后
+        if (!_sequencer.quiescent() && getPoller()->isCurrentThread()) {
+            auto size = buf->size();
+            auto self = std::static_pointer_cast<Session>(shared_from_this());
+            CommandQueueManager::Instance().pushSessionTask(self, [self, buf]() {
+                self->send(buf);
+            });
+            return size;
+        }
+        RedisStats::Instance().onReply();
+        _unflushed.store(true, std::memory_order_relaxed);
+        return Session::send(std::move(buf));
+    }
+
+    // 只有发送缓存中确有新回复时才计入 reply_flushes，没有产生回复的 onRecv / 执行轮次不计
+    void flushReplies() override {
+        bool pending = _unflushed.exchange(false, std::memory_order_relaxed);
+        if (flushAll() == 0 && pending) {
+            RedisStats::Instance().onFlush();
+        }
+    }
+
+    ReplySequencer *getReplySequencer() override {
+        return &_sequencer;
+    }
+
     // 提供事务上下文的接口
     virtual TransactionContext& getTransactionContext() override {
         return _transactionContext;
     }
-    
+
+    // 当前选择的数据库，SELECT 在 poller 线程中修改，事务回放时可能在执行线程中读取
+    int getDbIndex() const override {
+        return _dbIndex.load(std::memory_order_relaxed);
+    }
+    void setDbIndex(int dbIndex) override {
+        _dbIndex.store(dbIndex, std::memory_order_relaxed);
+    }
+
 private:
     Ticker _ticker;
     CmdParserFactory::Ptr _cmdParserFactor;
     TransactionContext _transactionContext;
+    std::atomic<int> _dbIndex{0};           // 当前选择的数据库
+    std::atomic<bool> _closed{false};       // 客户端已断开（onError）
+    std::atomic<bool> _unflushed{false};    // 上次 flushReplies 之后有回复进入发送缓存
+    bool _held = false;                     // 暂停分发命令（见 holdCommands），只在 poller 线程中访问
+    bool _closing = false;                  // 协议错误后等待断开（见 shutdownAfterReplies），只在 poller 线程中访问
+    uint64_t _lastActive = 0;               // 最后一次收到数据的时间（毫秒），只在 poller 线程中访问
+    ReplySequencer _sequencer;              // 分片模式下的回复排序
 
 
-    std::vector<std::string> parseRESPCommand(const std::string &data) {
-        std::vector<std::string> result;
-        std::istringstream stream(data);
-        std::string line;
+    BufferRaw::Ptr _recvBuf;                // 接收缓存，已解析命令的参数切片指向其中
+    size_t _recvOffset = 0;                 // 接收缓存中未解析数据的起始位置
+    RespDecoder _decoder;                   // RESP 增量解析器
+    std::vector<RespDecoder::Slice> _slices;
 
-        std::function<void(std::istringstream &, int)> parseRESP = [&](std::istringstream &stream, int depth = 0) -> void {
-            while (std::getline(stream, line)) {
-                // 去除行尾的 \r
-                if (!line.empty() && line.back() == '\r') {
-                    line.pop_back();
+    // 把收到的数据追加到接收缓存
+    void appendRecvData(const char *data, size_t len) {
+        size_t pending = _recvBuf ? _recvBuf->size() - _recvOffset : 0;
+        if (_recvBuf && _recvBuf.use_count() == 1) {
+            // 没有命令再引用该缓存，可以原地复用：先把残留数据挪到头部
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_recvBuf->getCapacity() >= pending + len) {
+                if (_recvOffset) {
+                    memmove(_recvBuf->data(), _recvBuf->data() + _recvOffset, pending);
+                    _recvOffset = 0;
                 }
+                memcpy(_recvBuf->data() + pending, data, len);
+                _recvBuf->setSize(pending + len);
+                return;
+            }
+        }
+        // 缓存仍被已分发的命令引用或容量不足，新建缓存并只拷贝残留数据；
+        // 大 value 分多次到达时按解析器预期的长度一次分配到位
+        auto buf = BufferRaw::create();
+        buf->setCapacity(std::max(pending + len, _decoder.expectedSize()));
+        if (pending) {
+            memcpy(buf->data(), _recvBuf->data() + _recvOffset, pending);
+        }
+        memcpy(buf->data() + pending, data, len);
+        buf->setSize(pending + len);
+        _recvBuf = std::move(buf);
+        _recvOffset = 0;
+    }
 
-                if (line.empty()) {
-                    continue;
-                }
+    // 空闲检测：返回下次检测的延时，超时断开连接后返回 0；还有命令未回复时不算空闲
+    uint64_t checkIdle(uint64_t timeout) {
+        if (closed()) {
+            return 0;
+        }
+        auto idle = getCurrentMillisecond() - _lastActive;
+        if (idle < timeout) {
+            return timeout - idle;
+        }
+        if (!_sequencer.quiescent()) {
+            return timeout;
+        }
+        RedisStats::Instance().onClientTimeout();
+        shutdown(SockException(Err_timeout, "client idle timeout"));
+        return 0;
+    }
 
-                if (line[0] == '*') {
-                    // 解析数组结构
-                    int num_elements = std::stoi(line.substr(1));
-                    while (num_elements-- > 0) {
-                        parseRESP(stream, depth + 1);
-                    }
-                } else if (line[0] == '$') {
-                    // 解析 Bulk String
-                    int bulk_length = std::stoi(line.substr(1));
-                    if (bulk_length > 0 && std::getline(stream, line)) {
-                        if (!line.empty() && line.back() == '\r') {
-                            line.pop_back();
-                        }
-                        result.push_back(line.substr(0, bulk_length));
-                    }
-                }
+    // 解析接收缓存中的完整命令并依次分发（pipeline），暂停期间（holdCommands）不分发
+    void dispatchCommands() {
+        if (!_recvBuf) {
+            return;
+        }
+        auto data = _recvBuf->data();
+        auto len = _recvBuf->size();
+        while (!_held && _recvOffset < len) {
+            size_t consumed = 0;
+            auto status = _decoder.decode(data + _recvOffset, len - _recvOffset, consumed, _slices);
+            if (status == RespDecoder::NEED_MORE) {
+                break;
+            }
+            if (status == RespDecoder::PROTOCOL_ERROR) {
+                send("-ERR Protocol error: " + _decoder.getError() + "\r\n");
+                _recvBuf = nullptr;
+                _recvOffset = 0;
+                _decoder.reset();
+                shutdownAfterReplies();
+                return;
+            }
+            auto base = data + _recvOffset;
+            _recvOffset += consumed;
+            if (_slices.empty()) {
+                continue;
+            }
+            // 2. 参数以切片形式引用接收缓存，命令持有该缓存直到执行完毕；一次读取中的每条完整命令依次分发（pipeline）
+            //    命令描述符从本线程的对象池中取出，不分配内存
+            auto cmd = CmdDesc::create(_recvBuf);
+            cmd->args.reserve(_slices.size());
+            for (auto &slice : _slices) {
+                cmd->args.push(base + slice.offset, slice.size);
+            }
+            onCommand(cmd);
+        }
+    }
+
+    // 协议错误后断开连接。错误回复与 send 一样排在此前命令的回复之后，断开也要排在它之后，否则回复会随连接关闭丢失
+    void shutdownAfterReplies() {
+        _closing = true;
+        std::weak_ptr<RedisSession> weakSelf = std::static_pointer_cast<RedisSession>(shared_from_this());
+        auto close = [weakSelf]() {
+            if (auto strongSelf = weakSelf.lock()) {
+                strongSelf->shutdownWhenFlushed();
             }
         };
+        if (!_sequencer.idle()) {
+            // 分片模式：回复由排序器按序发送，全部发出后断开
+            _sequencer.whenIdle(close);
+        } else if (!_sequencer.quiescent()) {
+            // 单执行线程模式：错误回复已作为会话任务进入命令队列，断开排在其后，回到 poller 线程执行
+            auto self = std::static_pointer_cast<Session>(shared_from_this());
+            auto poller = getPoller();
+            CommandQueueManager::Instance().pushSessionTask(self, [poller, close]() {
+                poller->async(close, false);
+            });
+        } else {
+            close();
+        }
+    }
 
-        parseRESP(stream, 0);
-        return result;
+    // 发送缓存中的数据全部写入 socket 后断开；对端读得慢时 flushAll 写不完，直接断开会丢掉剩余的回复（poller 线程中调用）
+    void shutdownWhenFlushed() {
+        flushAll();
+        auto &sock = getSock();
+        if (!sock || !sock->isSocketBusy()) {
+            shutdown(SockException(Err_shutdown, "redis protocol error"));
+            return;
+        }
+        std::weak_ptr<RedisSession> weakSelf = std::static_pointer_cast<RedisSession>(shared_from_this());
+        sock->setOnFlush([weakSelf]() {
+            if (auto strongSelf = weakSelf.lock()) {
+                strongSelf->shutdown(SockException(Err_shutdown, "redis protocol error"));
+            }
+            return false;
+        });
+    }
+
+    // 事务中不入队、立即处理的命令（MULTI 与 WATCH 在事务中直接报错）
+    static bool transactionControl(Command id) {
+        return id == EXEC || id == DISCARD || id == MULTI || id == WATCH;
+    }
+
+    // 分发一条已解析的命令
+    void onCommand(const CmdDesc::Ptr &cmd) {
+        // 1. 得到相应命令的解析器
+        auto spec = CommandTable::lookup(cmd->args.front());
+        auto commandParser = spec ? _cmdParserFactor->getParser(*spec) : nullptr;
+        if(commandParser == nullptr) {
+            if (_transactionContext.isTransactionActive()) {
+                _transactionContext.markDirty();
+            }
+            send("-ERR unknown command\r\n");
+            return;
+        }
+        cmd->spec = spec;
+        cmd->parser = commandParser;
+        cmd->session = std::static_pointer_cast<Session>(shared_from_this());
+        // 2. 如果处于事务中且非事务控制命令，加入事务队列；解析失败的命令使 EXEC 放弃整个事务
+        if(_transactionContext.isTransactionActive() && !transactionControl(spec->id)) {
+            if(commandParser->parserCommand(cmd->args, cmd->session)){
+                // 事务中的 SELECT 不立即切换，各命令的数据库由 EXEC 按顺序确定
+                _transactionContext.addCommandToQueue(cmd);
+                send(SharedReply::queued());    // 注意一定要发送响应
+                return;
+            }
+            _transactionContext.markDirty();
+            return;
+        }
+        // 3. 非事务模式或事务控制命令，解析器解析并将命令加入命令队列等待执行
+        try{
+            commandParser->parserAndExecuter(cmd);
+        } catch (std::exception & ex){
+            send("-ERR unknown command\r\n");
+        }
     }
     
 };
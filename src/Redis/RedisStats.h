@@ -0,0 +1,101 @@
+#ifndef REDISSTATS_H
+#define REDISSTATS_H
+
+#include <atomic>
+#include <string>
+#include <sstream>
+#include <cstdint>
+#include "Network/BufferSock.h"
+#include "RedisConfig.h"
+#include "RedisObject.h"
+#include "UsedMemory.h"
+
+namespace toolkit
+{
+
+// 运行时统计，各线程只做原子累加，INFO 命令读取
+class RedisStats {
+public:
+    static RedisStats &Instance() {
+        static RedisStats instance;
+        return instance;
+    }
+    RedisStats(const RedisStats &) = delete;
+    RedisStats &operator=(const RedisStats &) = delete;
+
+    void onCommand() { _commands.fetch_add(1, std::memory_order_relaxed); }
+    void onReply() { _replies.fetch_add(1, std::memory_order_relaxed); }
+    void onFlush() { _flushes.fetch_add(1, std::memory_order_relaxed); }
+    void onPollerRead() { _pollerReads.fetch_add(1, std::memory_order_relaxed); }
+    void onShedDepth() { _shedDepth.fetch_add(1, std::memory_order_relaxed); }
+    void onShedAge() { _shedAge.fetch_add(1, std::memory_order_relaxed); }
+    void onDropClosed() { _droppedClosed.fetch_add(1, std::memory_order_relaxed); }
+    void onExpired(bool active) {
+        _expired.fetch_add(1, std::memory_order_relaxed);
+        if (active) {
+            _expiredActive.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    void onExpireCycle() { _expireCycles.fetch_add(1, std::memory_order_relaxed); }
+    void onClientTimeout() { _timedoutClients.fetch_add(1, std::memory_order_relaxed); }
+    void onEvicted(uint64_t keys, uint64_t us) {
+        _evicted.fetch_add(keys, std::memory_order_relaxed);
+        _evictionUs.fetch_add(us, std::memory_order_relaxed);
+    }
+
+    // 生成 INFO 命令的输出
+    std::string info() const {
+        auto commands = _commands.load(std::memory_order_relaxed);
+        auto replies = _replies.load(std::memory_order_relaxed);
+        auto flushes = _flushes.load(std::memory_order_relaxed);
+        auto syscalls = BufferList::getSyscallCount();
+
+        std::ostringstream oss;
+        oss << "# Stats\r\n";
+        oss << "total_commands_processed:" << commands << "\r\n";
+        oss << "total_replies:" << replies << "\r\n";
+        oss << "reply_flushes:" << flushes << "\r\n";
+        oss << "write_syscalls:" << syscalls << "\r\n";
+        oss << "syscalls_per_reply:" << (replies ? static_cast<double>(syscalls) / replies : 0.0) << "\r\n";
+        oss << "reply_batching:" << (RedisConfig::Instance().replyBatching ? "yes" : "no") << "\r\n";
+        oss << "hash_table:" << hashTableName() << "\r\n";
+        oss << "poller_reads:" << _pollerReads.load(std::memory_order_relaxed) << "\r\n";
+        oss << "max_queue_depth:" << RedisConfig::Instance().maxQueueDepth << "\r\n";
+        oss << "max_queue_age_ms:" << RedisConfig::Instance().maxQueueAgeMs << "\r\n";
+        oss << "shed_queue_depth:" << _shedDepth.load(std::memory_order_relaxed) << "\r\n";
+        oss << "shed_queue_age:" << _shedAge.load(std::memory_order_relaxed) << "\r\n";
+        oss << "dropped_disconnected:" << _droppedClosed.load(std::memory_order_relaxed) << "\r\n";
+        oss << "expired_keys:" << _expired.load(std::memory_order_relaxed) << "\r\n";
+        oss << "expired_keys_active:" << _expiredActive.load(std::memory_order_relaxed) << "\r\n";
+        oss << "active_expire_cycles:" << _expireCycles.load(std::memory_order_relaxed) << "\r\n";
+        oss << "timedout_clients:" << _timedoutClients.load(std::memory_order_relaxed) << "\r\n";
+        oss << "evicted_keys:" << _evicted.load(std::memory_order_relaxed) << "\r\n";
+        oss << "eviction_time_us:" << _evictionUs.load(std::memory_order_relaxed) << "\r\n";
+        oss << "# Memory\r\n";
+        oss << "used_memory:" << UsedMemory::get() << "\r\n";
+        oss << "maxmemory:" << RedisConfig::Instance().maxmemory << "\r\n";
+        oss << "maxmemory_policy:" << evictionPolicyName(RedisConfig::Instance().maxmemoryPolicy) << "\r\n";
+        return oss.str();
+    }
+
+private:
+    RedisStats() = default;
+
+    std::atomic<uint64_t> _commands{0};     // 执行线程执行的命令数
+    std::atomic<uint64_t> _replies{0};      // 发送给客户端的回复数
+    std::atomic<uint64_t> _flushes{0};      // 批量模式下确有回复待发送的 flush 次数
+    std::atomic<uint64_t> _pollerReads{0};  // 在 poller 线程中直接执行的只读命令数
+    std::atomic<uint64_t> _shedDepth{0};    // 命令队列超过 maxQueueDepth 时拒绝的命令数
+    std::atomic<uint64_t> _shedAge{0};      // 排队超过 maxQueueAgeMs 后放弃执行的命令数
+    std::atomic<uint64_t> _droppedClosed{0};    // 客户端已断开、不再执行的命令数
+    std::atomic<uint64_t> _expired{0};          // 因过期删除的键数（惰性与主动过期）
+    std::atomic<uint64_t> _expiredActive{0};    // 其中由主动过期删除的键数
+    std::atomic<uint64_t> _expireCycles{0};     // 主动过期的执行次数
+    std::atomic<uint64_t> _timedoutClients{0};  // 因空闲超时断开的连接数
+    std::atomic<uint64_t> _evicted{0};          // 因超出 maxmemory 淘汰的键数
+    std::atomic<uint64_t> _evictionUs{0};       // 淘汰累计耗时（微秒）
+};
+
+} // namespace toolkit
+
+#endif
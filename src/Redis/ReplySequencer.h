@@ -0,0 +1,133 @@
+#ifndef REPLYSEQUENCER_H
+#define REPLYSEQUENCER_H
+
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "Network/Buffer.h"
+
+namespace toolkit
+{
+
+// 会话回复排序器
+// 分片模式下同一会话 pipeline 中的命令可能在不同分片（不同线程）上并发执行，完成顺序与到达顺序不一致。
+// 每条不能立即回复的命令在会话所在 poller 线程中预留一个序号，执行线程把回复捕获下来（Capture）投递回会话，
+// 排序器按序号依次发送，保证回复顺序与命令顺序一致。
+// 除 Capture 与 endQueued 外，其余接口只能在会话所在 poller 线程中调用。
+class ReplySequencer {
+public:
+    using Sender = std::function<void(const Buffer::Ptr &)>;
+    using Flusher = std::function<void()>;
+
+    // 在执行线程中捕获某个会话的回复：作用域内该会话的 send 只写入 replies
+    class Capture {
+    public:
+        Capture(const void *owner, std::vector<Buffer::Ptr> &replies) : _owner(owner), _replies(replies), _prev(current()) {
+            current() = this;
+        }
+        ~Capture() {
+            current() = _prev;
+        }
+
+        // 当前线程正在为 owner 捕获回复时返回捕获目标，否则返回 nullptr
+        static std::vector<Buffer::Ptr> *target(const void *owner) {
+            auto capture = current();
+            return capture && capture->_owner == owner ? &capture->_replies : nullptr;
+        }
+
+    private:
+        static Capture *&current() {
+            static thread_local Capture *capture = nullptr;
+            return capture;
+        }
+
+        const void *_owner;
+        std::vector<Buffer::Ptr> &_replies;
+        Capture *_prev;
+    };
+
+    void setSender(Sender sender, Flusher flusher) {
+        _sender = std::move(sender);
+        _flusher = std::move(flusher);
+    }
+
+    // 没有未完成的命令，可以直接发送回复
+    bool idle() const {
+        return _next == _sent;
+    }
+
+    // 单执行线程模式下命令进入命令队列与执行完毕时调用，执行线程直接发送回复，只需计数
+    void beginQueued() {
+        _queued.fetch_add(1, std::memory_order_relaxed);
+    }
+    void endQueued() {
+        _queued.fetch_sub(1, std::memory_order_release);
+    }
+
+    // 此前的命令都已执行完毕且回复已发出：只读命令可以在 poller 线程中直接执行，不会读到该会话尚未执行的写之前的值
+    bool quiescent() const {
+        return idle() && _queued.load(std::memory_order_acquire) == 0;
+    }
+
+    // 已预留的回复全部发出后执行 task（如协议错误后断开连接），当前已空闲时立即执行
+    void whenIdle(std::function<void()> task) {
+        if (idle()) {
+            task();
+            return;
+        }
+        _onIdle = std::move(task);
+    }
+
+    // 为一条命令预留回复序号
+    uint64_t reserve() {
+        _pending.emplace_back();
+        return _next++;
+    }
+
+    // 命令 seq 的回复已就绪，发送所有已按序就绪的回复
+    void deliver(uint64_t seq, std::vector<Buffer::Ptr> replies) {
+        if (seq < _sent || seq >= _next) {
+            return;
+        }
+        auto &slot = _pending[seq - _sent];
+        slot.ready = true;
+        slot.replies = std::move(replies);
+        bool sent = false;
+        while (!_pending.empty() && _pending.front().ready) {
+            for (auto &buf : _pending.front().replies) {
+                _sender(buf);
+            }
+            _pending.pop_front();
+            ++_sent;
+            sent = true;
+        }
+        if (sent && _flusher) {
+            _flusher();
+        }
+        if (idle() && _onIdle) {
+            auto task = std::move(_onIdle);
+            _onIdle = nullptr;
+            task();
+        }
+    }
+
+private:
+    struct Slot {
+        bool ready = false;
+        std::vector<Buffer::Ptr> replies;
+    };
+
+    uint64_t _next = 0;             // 下一个预留的序号
+    uint64_t _sent = 0;             // 下一个待发送的序号
+    std::atomic<uint32_t> _queued{0};   // 已进入命令队列尚未执行完毕的命令数
+    std::deque<Slot> _pending;      // [_sent, _next) 的回复
+    Sender _sender;
+    Flusher _flusher;
+    std::function<void()> _onIdle;  // 见 whenIdle
+};
+
+} // namespace toolkit
+
+#endif
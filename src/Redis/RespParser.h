@@ -0,0 +1,206 @@
+#ifndef RESPPARSER_H
+#define RESPPARSER_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include "RespScan.h"
+
+namespace toolkit
+{
+
+// RESP 协议增量解析器
+// 每个会话持有一个实例，解析状态（当前数组剩余元素个数、当前 bulk 长度、已解析的位置与参数）跨 onRecv 保留，
+// 因此半包可以在下一次收到数据时从断点继续解析，粘包（pipeline）时一次可以解析出多条命令。
+// 解析结果只记录参数在命令中的偏移和长度，不拷贝参数内容。
+class RespDecoder {
+public:
+    enum Status {
+        NEED_MORE,          // 数据不完整，需要等待更多数据
+        COMPLETE,           // 解析出一条完整命令
+        PROTOCOL_ERROR      // 协议错误，需要断开连接
+    };
+
+    // 参数在命令起始位置之后的偏移和长度
+    struct Slice {
+        size_t offset;
+        size_t size;
+    };
+
+    static const int64_t kMaxMultiBulkLen = 1024 * 1024;        // 单条命令最大参数个数
+    static const int64_t kMaxBulkLen = 512LL * 1024 * 1024;     // 单个参数最大长度
+    static const size_t kMaxInlineLen = 64 * 1024;              // inline 命令最大长度
+
+    /**
+    * @brief 从 data 中解析一条命令
+    * @param data 待解析数据，必须从上次 NEED_MORE 时未消耗的位置开始
+    * @param len 数据长度
+    * @param consumed 本次调用消耗的字节数，NEED_MORE 时为 0
+    * @param args 解析完成时存放参数切片，偏移相对于 data
+    * @return 解析状态，返回 COMPLETE 时可继续从 data + consumed 处解析下一条命令（args 可能为空，如空数组/空行）
+    */
+    Status decode(const char *data, size_t len, size_t &consumed, std::vector<Slice> &args) {
+        consumed = 0;
+        if (_multibulk_len == 0) {
+            // 跳过命令之间多余的空行
+            size_t start = 0;
+            while (start < len && (data[start] == '\r' || data[start] == '\n')) {
+                ++start;
+            }
+            if (start == len) {
+                consumed = len;
+                args.clear();
+                return COMPLETE;
+            }
+            if (data[start] != '*') {
+                return decodeInline(data, len, start, consumed, args);
+            }
+            // 解析数组头 *<n>\r\n
+            size_t lineLen;
+            int64_t n;
+            auto status = readNumberLine(data + start, len - start, lineLen, n);
+            if (status != COMPLETE) {
+                return status;
+            }
+            if (n > kMaxMultiBulkLen) {
+                _error = "invalid multibulk length";
+                return PROTOCOL_ERROR;
+            }
+            if (n <= 0) {
+                // 空数组：返回空参数，由调用方忽略
+                consumed = start + lineLen;
+                args.clear();
+                return COMPLETE;
+            }
+            _multibulk_len = n;
+            _pos = start + lineLen;
+            _args.clear();
+            _args.reserve(static_cast<size_t>(n));
+        }
+
+        while (_multibulk_len > 0) {
+            if (_bulk_len < 0) {
+                // 解析 bulk 头 $<len>\r\n
+                if (_pos >= len) {
+                    return NEED_MORE;
+                }
+                if (data[_pos] != '$') {
+                    _error = std::string("expected '$', got '") + data[_pos] + "'";
+                    return PROTOCOL_ERROR;
+                }
+                size_t lineLen;
+                int64_t n;
+                auto status = readNumberLine(data + _pos, len - _pos, lineLen, n);
+                if (status != COMPLETE) {
+                    return status;
+                }
+                if (n < 0 || n > kMaxBulkLen) {
+                    _error = "invalid bulk length";
+                    return PROTOCOL_ERROR;
+                }
+                _pos += lineLen;
+                _bulk_len = n;
+            }
+            // 解析 bulk 内容，需要 _bulk_len + 2 字节（含 \r\n）
+            if (len < _pos + static_cast<size_t>(_bulk_len) + 2) {
+                return NEED_MORE;
+            }
+            _args.push_back(Slice{_pos, static_cast<size_t>(_bulk_len)});
+            _pos += static_cast<size_t>(_bulk_len) + 2;
+            _bulk_len = -1;
+            --_multibulk_len;
+        }
+
+        consumed = _pos;
+        _pos = 0;
+        args.swap(_args);
+        _args.clear();
+        return COMPLETE;
+    }
+
+    // 当前未完成命令至少需要的总字节数（从未消耗数据的起始位置算起），用于提前分配接收缓存
+    size_t expectedSize() const {
+        return _bulk_len >= 0 ? _pos + static_cast<size_t>(_bulk_len) + 2 : _pos;
+    }
+
+    // 最近一次协议错误的描述
+    const std::string &getError() const {
+        return _error;
+    }
+
+    // 是否正处于一条命令的中间状态
+    bool isPending() const {
+        return _multibulk_len > 0;
+    }
+
+    void reset() {
+        _multibulk_len = 0;
+        _bulk_len = -1;
+        _pos = 0;
+        _args.clear();
+        _error.clear();
+    }
+
+private:
+    // 解析形如 *<n>\r\n 或 $<n>\r\n 的行，line 指向类型字节
+    Status readNumberLine(const char *line, size_t len, size_t &lineLen, int64_t &value) {
+        auto cr = RespScan::findCR(line, line + len);
+        if (!cr || static_cast<size_t>(cr - line) + 1 >= len) {
+            if (len > kMaxInlineLen) {
+                _error = "too big count string";
+                return PROTOCOL_ERROR;
+            }
+            return NEED_MORE;
+        }
+        if (cr[1] != '\n' || !RespScan::parseLength(line + 1, cr, value)) {
+            _error = line[0] == '*' ? "invalid multibulk length" : "invalid bulk length";
+            return PROTOCOL_ERROR;
+        }
+        lineLen = static_cast<size_t>(cr - line) + 2;
+        return COMPLETE;
+    }
+
+    // inline 命令（如 telnet 直接输入 "PING\r\n"），以空白分隔参数
+    Status decodeInline(const char *data, size_t len, size_t start, size_t &consumed, std::vector<Slice> &args) {
+        auto begin = data + start;
+        auto nl = RespScan::findLF(begin, data + len);
+        if (!nl) {
+            if (len - start > kMaxInlineLen) {
+                _error = "too big inline request";
+                return PROTOCOL_ERROR;
+            }
+            return NEED_MORE;
+        }
+        auto end = nl;
+        if (end > begin && end[-1] == '\r') {
+            --end;
+        }
+        args.clear();
+        for (auto p = begin; p < end;) {
+            while (p < end && (*p == ' ' || *p == '\t')) {
+                ++p;
+            }
+            auto argBegin = p;
+            while (p < end && *p != ' ' && *p != '\t') {
+                ++p;
+            }
+            if (p > argBegin) {
+                args.push_back(Slice{static_cast<size_t>(argBegin - data), static_cast<size_t>(p - argBegin)});
+            }
+        }
+        consumed = static_cast<size_t>(nl - data) + 1;
+        return COMPLETE;
+    }
+
+private:
+    int64_t _multibulk_len = 0;         // 当前数组剩余未解析的元素个数
+    int64_t _bulk_len = -1;             // 当前 bulk 的长度，-1 表示尚未解析 bulk 头
+    size_t _pos = 0;                    // 当前命令已解析到的位置（相对未消耗数据的起始位置）
+    std::vector<Slice> _args;           // 当前命令已解析出的参数
+    std::string _error;
+};
+
+} // namespace toolkit
+
+#endif
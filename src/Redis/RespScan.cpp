@@ -0,0 +1,138 @@
+#include <cstring>
+#include "RespScan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define RESP_SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace toolkit
+{
+
+// 标量实现：一次读取 8 字节，用 "haszero" 位运算判断其中是否包含目标字节
+static const char *findScalar(const char *begin, const char *end, char c) {
+    const uint64_t pattern = 0x0101010101010101ULL * static_cast<uint8_t>(c);
+    while (end - begin >= 8) {
+        uint64_t word;
+        memcpy(&word, begin, 8);
+        word ^= pattern;
+        if ((word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL) {
+            break;
+        }
+        begin += 8;
+    }
+    for (; begin < end; ++begin) {
+        if (*begin == c) {
+            return begin;
+        }
+    }
+    return nullptr;
+}
+
+#ifdef RESP_SCAN_X86
+
+__attribute__((target("sse2")))
+static const char *findSSE2(const char *begin, const char *end, char c) {
+    const __m128i pattern = _mm_set1_epi8(c);
+    while (end - begin >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern));
+        if (mask) {
+            return begin + __builtin_ctz(mask);
+        }
+        begin += 16;
+    }
+    return findScalar(begin, end, c);
+}
+
+__attribute__((target("avx2")))
+static const char *findAVX2(const char *begin, const char *end, char c) {
+    const __m256i pattern = _mm256_set1_epi8(c);
+    while (end - begin >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, pattern)));
+        if (mask) {
+            return begin + __builtin_ctz(mask);
+        }
+        begin += 32;
+    }
+    return findSSE2(begin, end, c);
+}
+
+#endif // RESP_SCAN_X86
+
+static RespScan::Kernel s_kernel = RespScan::KERNEL_SCALAR;
+
+static RespScan::Kernel bestKernel() {
+#ifdef RESP_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return RespScan::KERNEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return RespScan::KERNEL_SSE2;
+    }
+#endif
+    return RespScan::KERNEL_SCALAR;
+}
+
+static RespScan::FindFunc resolve(RespScan::Kernel kernel) {
+    auto best = bestKernel();
+    if (kernel == RespScan::KERNEL_AUTO || kernel > best) {
+        kernel = best;
+    }
+    s_kernel = kernel;
+    switch (kernel) {
+#ifdef RESP_SCAN_X86
+        case RespScan::KERNEL_AVX2: return findAVX2;
+        case RespScan::KERNEL_SSE2: return findSSE2;
+#endif
+        default: return findScalar;
+    }
+}
+
+RespScan::FindFunc RespScan::_find = resolve(RespScan::KERNEL_AUTO);
+
+RespScan::Kernel RespScan::select(Kernel kernel) {
+    _find = resolve(kernel);
+    return s_kernel;
+}
+
+RespScan::Kernel RespScan::current() {
+    return s_kernel;
+}
+
+const char *RespScan::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case KERNEL_AUTO: return "auto";
+        case KERNEL_SCALAR: return "scalar";
+        case KERNEL_SSE2: return "sse2";
+        case KERNEL_AVX2: return "avx2";
+        default: return "unknown";
+    }
+}
+
+bool RespScan::parseLength(const char *begin, const char *end, int64_t &value) {
+    bool negative = false;
+    if (begin < end && *begin == '-') {
+        negative = true;
+        ++begin;
+    }
+    auto len = end - begin;
+    if (len <= 0 || len > 18) {
+        return false;
+    }
+    // 长度头通常只有 1~5 位，逐位累加即可；用无符号减法把范围判断合并为一次比较
+    int64_t v = 0;
+    for (; begin < end; ++begin) {
+        unsigned digit = static_cast<unsigned char>(*begin) - '0';
+        if (digit > 9) {
+            return false;
+        }
+        v = v * 10 + digit;
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+} // namespace toolkit
@@ -0,0 +1,61 @@
+#ifndef RESPSCAN_H
+#define RESPSCAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace toolkit
+{
+
+// RESP 解析用的字节扫描内核
+// 查找 \r / \n 是解析 RESP 的主要开销（尤其是大 value 的 MSET/HMSET），这里提供 AVX2 / SSE2 / 标量三种实现，
+// 进程首次使用时按 CPU 支持情况选择最快的一种。
+class RespScan {
+public:
+    enum Kernel {
+        KERNEL_AUTO,        // 根据 CPU 自动选择
+        KERNEL_SCALAR,      // 标量实现（每次比较 8 字节）
+        KERNEL_SSE2,        // 每次比较 16 字节
+        KERNEL_AVX2         // 每次比较 32 字节
+    };
+
+    // 在 [begin, end) 中查找第一个 c，找不到返回 nullptr
+    static const char *find(const char *begin, const char *end, char c) {
+        return _find(begin, end, c);
+    }
+
+    static const char *findCR(const char *begin, const char *end) {
+        return _find(begin, end, '\r');
+    }
+
+    static const char *findLF(const char *begin, const char *end) {
+        return _find(begin, end, '\n');
+    }
+
+    /**
+    * @brief 解析 RESP 头部中的十进制长度，如 "$1024" 中的 "1024"
+    * @param begin 数字起始位置（可带负号）
+    * @param end 数字结束位置（即 \r 的位置）
+    * @return 格式非法或溢出时返回 false
+    */
+    static bool parseLength(const char *begin, const char *end, int64_t &value);
+
+    /**
+    * @brief 切换扫描内核，CPU 不支持时退回到可用的最快实现
+    * @return 实际使用的内核
+    */
+    static Kernel select(Kernel kernel = KERNEL_AUTO);
+
+    // 当前使用的内核
+    static Kernel current();
+    static const char *kernelName(Kernel kernel);
+
+    using FindFunc = const char *(*)(const char *, const char *, char);
+
+private:
+    static FindFunc _find;
+};
+
+} // namespace toolkit
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef RESPWRITER_H
+#define RESPWRITER_H
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include "Network/Buffer.h"
+#include "Util/ResourcePool.h"
+#include "Util/onceToken.h"
+#include "CmdArgs.h"
+
+namespace toolkit
+{
+
+// RESP 回复构造器
+// 直接把数组头、bulk、整数等编码进一块从循环池取出的 BufferRaw，构造完成后整块交给 socket 发送，
+// 避免 ostringstream / string 拼接产生的多次分配和最后再拷贝进发送缓存的开销。
+// 调用方应按元素个数和长度预估容量（见 bulkLength），大回复一般只需分配一次。
+class RespWriter {
+public:
+    explicit RespWriter(size_t capacity = 0) {
+        _buf = pool().obtain2();
+        _buf->setSize(0);
+        _buf->setCapacity(capacity > kMinCapacity ? capacity : kMinCapacity);
+    }
+
+    // *<n>\r\n
+    RespWriter &array(size_t n) {
+        writeHeader('*', static_cast<int64_t>(n));
+        return *this;
+    }
+
+    // $<len>\r\n<data>\r\n
+    RespWriter &bulk(const char *data, size_t len) {
+        writeHeader('$', static_cast<int64_t>(len));
+        append(data, len);
+        append("\r\n", 2);
+        return *this;
+    }
+
+    RespWriter &bulk(const StrView &value) {
+        return bulk(value.data(), value.size());
+    }
+
+    // +<str>\r\n
+    RespWriter &status(const char *str) {
+        append("+", 1);
+        append(str, strlen(str));
+        append("\r\n", 2);
+        return *this;
+    }
+
+    // $-1\r\n
+    RespWriter &nil() {
+        append("$-1\r\n", 5);
+        return *this;
+    }
+
+    // :<n>\r\n
+    RespWriter &integer(int64_t value) {
+        writeHeader(':', value);
+        return *this;
+    }
+
+    // 追加已编码好的 RESP 数据
+    RespWriter &raw(const char *data, size_t len) {
+        append(data, len);
+        return *this;
+    }
+
+    size_t size() const {
+        return _buf->size();
+    }
+
+    // 取出构造好的回复，之后不能再写入
+    Buffer::Ptr buffer() {
+        return std::move(_buf);
+    }
+
+    // 编码一个长度为 len 的 bulk 需要的字节数
+    static size_t bulkLength(size_t len) {
+        return 1 + digits(len) + 2 + len + 2;
+    }
+
+    // 编码数组头需要的字节数
+    static size_t arrayLength(size_t n) {
+        return 1 + digits(n) + 2;
+    }
+
+private:
+    static const size_t kMinCapacity = 64;
+
+    static ResourcePool<BufferRaw> &pool() {
+        static ResourcePool<BufferRaw> pool;
+        static onceToken token([]() {
+            pool.setSize(64);
+        });
+        return pool;
+    }
+
+    static size_t digits(uint64_t n) {
+        size_t ret = 1;
+        while (n >= 10) {
+            n /= 10;
+            ++ret;
+        }
+        return ret;
+    }
+
+    void writeHeader(char type, int64_t value) {
+        // 类型 + 符号 + 最多 19 位数字 + \r\n
+        char tmp[24];
+        char *end = tmp + sizeof(tmp);
+        char *p = end;
+        *--p = '\n';
+        *--p = '\r';
+        uint64_t v = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+        do {
+            *--p = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while (v);
+        if (value < 0) {
+            *--p = '-';
+        }
+        *--p = type;
+        append(p, static_cast<size_t>(end - p));
+    }
+
+    void append(const char *data, size_t len) {
+        auto size = _buf->size();
+        if (size + len > _buf->getCapacity()) {
+            grow(size + len);
+        }
+        memcpy(_buf->data() + size, data, len);
+        _buf->setSize(size + len);
+    }
+
+    // BufferRaw::setCapacity 不保留原数据，扩容时换一块更大的缓存并拷贝已写入的内容
+    void grow(size_t need) {
+        auto capacity = _buf->getCapacity() * 2;
+        auto buf = pool().obtain2();
+        buf->setSize(0);
+        buf->setCapacity(capacity > need ? capacity : need);
+        memcpy(buf->data(), _buf->data(), _buf->size());
+        buf->setSize(_buf->size());
+        _buf = std::move(buf);
+    }
+
+private:
+    std::shared_ptr<BufferRaw> _buf;
+};
+
+} // namespace toolkit
+
+#endif
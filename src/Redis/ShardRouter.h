@@ -0,0 +1,316 @@
+#ifndef SHARDROUTER_H
+#define SHARDROUTER_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include "Thread/TaskExecutor.h"
+#include "Network/Session.h"
+#include "CmdArgs.h"
+#include "Keyspace.h"
+#include "SharedReply.h"
+
+namespace toolkit
+{
+
+// 分片路由
+// 每个数据库的键空间按键的哈希分成 N 片，第 i 片只由第 i 个线程（分片的所有者）访问，不需要任何锁。
+// 所有者可以是 poller 线程（分片模式，shared-nothing），也可以是 CommandQueueManager 的执行线程（多执行线程模式）。
+// 命令若属于本线程的分片则直接执行，否则通过 TaskExecutor::async 转发到所属分片执行，
+// 回复再投递回会话所在的 poller，由 ReplySequencer 按命令顺序发送。
+// 跨分片的事务通过 exclusive 让涉及的分片的所有者全部停下，由其中一个线程独占这些分片执行。
+class ShardRouter {
+    // 投递给同一会话的一批回复：(序号, 该命令的回复)
+    using Replies = std::vector<std::pair<uint64_t, std::vector<Buffer::Ptr>>>;
+
+public:
+    // 回复投递缓存：所有者线程一轮中为各会话产生的回复先暂存，本轮结束时每个会话只投递一次（一次 async）
+    class Outbox {
+    public:
+        void add(const Session::Ptr &session, uint64_t seq, std::vector<Buffer::Ptr> replies) {
+            if (_entries.empty() || _entries.back().session != session) {
+                _entries.emplace_back();
+                _entries.back().session = session;
+            }
+            _entries.back().replies.emplace_back(seq, std::move(replies));
+        }
+
+        void flush() {
+            for (auto &entry : _entries) {
+                post(entry.session, std::move(entry.replies));
+            }
+            _entries.clear();
+        }
+
+        // 当前线程的投递缓存，为空时回复直接投递
+        static Outbox *&current() {
+            static thread_local Outbox *outbox = nullptr;
+            return outbox;
+        }
+
+    private:
+        struct Entry {
+            Session::Ptr session;
+            Replies replies;
+        };
+        std::vector<Entry> _entries;
+    };
+
+    // 独占执行作用域（见 exclusive）：作用域内本线程可以访问所有停下的分片，
+    // execute 与 scatter 不再转发，而是切换到目标分片后在本线程中直接执行
+    class Inline {
+    public:
+        Inline() : _prevInline(inlined()), _prevShard(Keyspace::currentShard()) {
+            inlined() = true;
+        }
+        ~Inline() {
+            inlined() = _prevInline;
+            Keyspace::currentShard() = _prevShard;
+        }
+
+    private:
+        bool _prevInline;
+        size_t _prevShard;
+    };
+
+    static ShardRouter &Instance() {
+        static ShardRouter instance;
+        return instance;
+    }
+    ShardRouter(const ShardRouter &) = delete;
+    ShardRouter &operator=(const ShardRouter &) = delete;
+
+    // 启动路由：pool 中第 i 个执行器拥有分片 i（在监听端口之前调用）
+    void start(TaskExecutorGetterImp &pool) {
+        size_t index = 0;
+        pool.for_each([&](const TaskExecutor::Ptr &executor) {
+            executor->sync([index]() {
+                Keyspace::currentShard() = index;
+                ownedShard() = index;
+            });
+            _owners.emplace_back(executor);
+            ++index;
+        });
+    }
+
+    bool enabled() const {
+        return !_owners.empty();
+    }
+
+    size_t shardCount() const {
+        return _owners.size();
+    }
+
+    size_t shardOf(const StrView &key) const {
+        return Keyspace::shardOf(key.data(), key.size(), _owners.size());
+    }
+
+    /**
+    * @brief 在分片 shard 上执行 task，task 中对 session 的回复按命令顺序发送（在会话所在 poller 线程中调用）
+    */
+    void execute(size_t shard, const Session::Ptr &session, const std::function<void()> &task) {
+        if (inlined()) {
+            // 独占执行中（事务），回复由外层捕获
+            Keyspace::currentShard() = shard;
+            guard(session, task);
+            return;
+        }
+        auto sequencer = session->getReplySequencer();
+        if (ownedShard() == shard && sequencer->idle()) {
+            // 键属于本线程且前面没有未完成的命令，直接执行并回复
+            guard(session, task);
+            return;
+        }
+        auto seq = sequencer->reserve();
+        _owners[shard]->async([session, seq, task]() {
+            std::vector<Buffer::Ptr> replies;
+            {
+                ReplySequencer::Capture capture(session.get(), replies);
+                guard(session, task);
+            }
+            // 无论命令是否抛出异常都要投递，否则该序号之后的回复会一直等待
+            reply(session, seq, std::move(replies));
+        });
+    }
+
+    /**
+    * @brief 把 task(shard) 分发到 shards 中的每个分片执行，全部完成后在最后完成的线程中执行 done
+    * 多键命令（MGET/MSET/DEL 等）按分片拆分后用它分发与汇总，各分片只写自己的那部分结果。
+    * 某个分片上 task 抛出异常时其余分片照常执行，全部完成后以第一个异常的信息调用 fail 代替 done（fail 为空时仍调用 done）
+    */
+    void scatter(const std::vector<size_t> &shards, std::function<void(size_t)> task, std::function<void()> done,
+                 std::function<void(const std::string &)> fail = nullptr) {
+        struct State {
+            std::atomic<size_t> remaining;
+            std::atomic<bool> failed{false};
+            std::string error;      // 第一个异常的信息，由置位 failed 的线程写入
+            std::function<void(size_t)> task;
+            std::function<void()> done;
+            std::function<void(const std::string &)> fail;
+        };
+        if (inlined()) {
+            // 独占执行中：依次切换到各分片直接执行
+            std::string error;
+            bool failed = false;
+            for (auto shard : shards) {
+                Keyspace::currentShard() = shard;
+                try {
+                    task(shard);
+                } catch (const std::exception &ex) {
+                    if (!failed) {
+                        error = ex.what();
+                    }
+                    failed = true;
+                }
+            }
+            if (failed && fail) {
+                fail(error);
+            } else {
+                done();
+            }
+            return;
+        }
+        auto state = std::make_shared<State>();
+        state->remaining = shards.size();
+        state->task = std::move(task);
+        state->done = std::move(done);
+        state->fail = std::move(fail);
+        for (auto shard : shards) {
+            _owners[shard]->async([shard, state]() {
+                try {
+                    state->task(shard);
+                } catch (const std::exception &ex) {
+                    if (!state->failed.exchange(true)) {
+                        state->error = ex.what();
+                    }
+                } catch (...) {
+                    if (!state->failed.exchange(true)) {
+                        state->error = "unknown error";
+                    }
+                }
+                if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    if (state->failed.load(std::memory_order_relaxed) && state->fail) {
+                        state->fail(state->error);
+                    } else {
+                        state->done();
+                    }
+                }
+            });
+        }
+    }
+
+    /**
+    * @brief 独占 shards 中的分片执行 task（跨分片事务），task 中对 session 的回复按命令顺序发送（在会话所在 poller 线程中调用）
+    * 向每个分片投递一个停止任务，各所有者线程执行到它时停下等待，全部停下后由最后到达的线程在 Inline 作用域中执行 task，
+    * 完成后所有线程继续。停止任务在全局锁内一次投递完，各分片队列中不同独占任务的先后顺序一致，不会互相等待。
+    * 只涉及一个分片时与 execute 相同，只是在 Inline 作用域中执行。
+    */
+    void exclusive(const std::vector<size_t> &shards, const Session::Ptr &session, const std::function<void()> &task) {
+        auto inlineTask = [task]() {
+            Inline scope;
+            task();
+        };
+        if (shards.size() <= 1) {
+            execute(shards.empty() ? 0 : shards.front(), session, inlineTask);
+            return;
+        }
+        struct Barrier {
+            std::mutex mutex;
+            std::condition_variable cond;
+            size_t arrived = 0;
+            bool finished = false;
+        };
+        auto barrier = std::make_shared<Barrier>();
+        auto count = shards.size();
+        auto seq = session->getReplySequencer()->reserve();
+        std::lock_guard<std::mutex> lock(_exclusiveMutex);
+        for (auto shard : shards) {
+            _owners[shard]->async([barrier, count, session, seq, inlineTask]() {
+                std::unique_lock<std::mutex> lock(barrier->mutex);
+                if (++barrier->arrived < count) {
+                    barrier->cond.wait(lock, [&barrier]() {
+                        return barrier->finished;
+                    });
+                    return;
+                }
+                lock.unlock();
+                std::vector<Buffer::Ptr> replies;
+                {
+                    ReplySequencer::Capture capture(session.get(), replies);
+                    guard(session, inlineTask);
+                }
+                reply(session, seq, std::move(replies));
+                lock.lock();
+                barrier->finished = true;
+                barrier->cond.notify_all();
+            }, false);
+        }
+    }
+
+    // 当前线程处于 Inline 作用域中
+    static bool &inlined() {
+        static thread_local bool value = false;
+        return value;
+    }
+
+    // 在每个分片上各执行一次 task（后台任务，如渐进式 rehash）
+    void broadcast(const std::function<void()> &task) {
+        for (auto &owner : _owners) {
+            owner->async(task, false);
+        }
+    }
+
+    // 把命令 seq 的回复投递回会话所在的 poller（可在任意线程中调用）
+    static void reply(const Session::Ptr &session, uint64_t seq, std::vector<Buffer::Ptr> replies) {
+        if (auto outbox = Outbox::current()) {
+            outbox->add(session, seq, std::move(replies));
+            return;
+        }
+        Replies batch;
+        batch.emplace_back(seq, std::move(replies));
+        post(session, std::move(batch));
+    }
+
+private:
+    ShardRouter() = default;
+
+    // 执行 task，抛出的异常转换为 -ERR 回复，保证路由出去的每条命令都有回复
+    static void guard(const Session::Ptr &session, const std::function<void()> &task) {
+        try {
+            task();
+        } catch (const std::exception &ex) {
+            session->send(SharedReply::error(ex.what()));
+        } catch (...) {
+            session->send(SharedReply::error("unknown error"));
+        }
+    }
+
+    // 本线程拥有的分片，非所有者线程为 kNoShard
+    static const size_t kNoShard = static_cast<size_t>(-1);
+    static size_t &ownedShard() {
+        static thread_local size_t shard = kNoShard;
+        return shard;
+    }
+
+    static void post(const Session::Ptr &session, Replies replies) {
+        auto shared = std::make_shared<Replies>(std::move(replies));
+        session->getPoller()->async([session, shared]() {
+            auto sequencer = session->getReplySequencer();
+            for (auto &item : *shared) {
+                sequencer->deliver(item.first, std::move(item.second));
+            }
+        });
+    }
+
+    std::vector<TaskExecutor::Ptr> _owners;     // 下标即分片号
+    std::mutex _exclusiveMutex;                 // 保证独占任务在各分片队列中的顺序一致
+};
+
+} // namespace toolkit
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef SHAREDREPLY_H
+#define SHAREDREPLY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Network/Buffer.h"
+
+namespace toolkit
+{
+
+// 预先编码好的常用回复（类似 Redis 的 shared 对象）
+// 这些 Buffer 创建后只读、由所有会话共享，发送时只增加引用计数，热路径上的 SET/HSET/SADD/INCR 等回复不再分配内存
+class SharedReply {
+public:
+    static const int64_t kMaxCachedInteger = 10000;    // 缓存 :0 ~ :9999
+
+    static const Buffer::Ptr &ok() { return instance()._ok; }
+    static const Buffer::Ptr &queued() { return instance()._queued; }
+    static const Buffer::Ptr &pong() { return instance()._pong; }
+    static const Buffer::Ptr &nil() { return instance()._nil; }
+    static const Buffer::Ptr &emptyArray() { return instance()._emptyArray; }
+    static const Buffer::Ptr &wrongType() { return instance()._wrongType; }
+    static const Buffer::Ptr &busy() { return instance()._busy; }
+    static const Buffer::Ptr &nullArray() { return instance()._nullArray; }
+    static const Buffer::Ptr &execAbort() { return instance()._execAbort; }
+    static const Buffer::Ptr &oom() { return instance()._oom; }
+
+    // 整数回复 :<n>\r\n，小整数直接取缓存
+    static Buffer::Ptr integer(int64_t value) {
+        if (value >= 0 && value < kMaxCachedInteger) {
+            return instance()._integers[value];
+        }
+        return encodeInteger(value);
+    }
+
+    // 错误回复 -ERR <message>\r\n（命令执行中抛出异常时使用，不缓存）
+    static Buffer::Ptr error(const std::string &message) {
+        return std::make_shared<BufferString>("-ERR " + message + "\r\n");
+    }
+
+private:
+    static const SharedReply &instance() {
+        static SharedReply instance;    // C++11 线程安全的局部静态变量
+        return instance;
+    }
+
+    SharedReply() {
+        _ok = std::make_shared<BufferString>("+OK\r\n");
+        _queued = std::make_shared<BufferString>("+QUEUED\r\n");
+        _pong = std::make_shared<BufferString>("+PONG\r\n");
+        _nil = std::make_shared<BufferString>("$-1\r\n");
+        _emptyArray = std::make_shared<BufferString>("*0\r\n");
+        _wrongType = std::make_shared<BufferString>("-WRONGTYPE Operation against a key holding the wrong kind of value\r\n");
+        _busy = std::make_shared<BufferString>("-BUSY server is overloaded, command not executed, try again later\r\n");
+        _nullArray = std::make_shared<BufferString>("*-1\r\n");
+        _execAbort = std::make_shared<BufferString>("-EXECABORT Transaction discarded because of previous errors.\r\n");
+        _oom = std::make_shared<BufferString>("-OOM command not allowed when used memory > 'maxmemory'.\r\n");
+        _integers.reserve(kMaxCachedInteger);
+        for (int64_t i = 0; i < kMaxCachedInteger; ++i) {
+            _integers.emplace_back(encodeInteger(i));
+        }
+    }
+
+    static Buffer::Ptr encodeInteger(int64_t value) {
+        return std::make_shared<BufferString>(":" + std::to_string(value) + "\r\n");
+    }
+
+private:
+    Buffer::Ptr _ok;
+    Buffer::Ptr _queued;
+    Buffer::Ptr _pong;
+    Buffer::Ptr _nil;
+    Buffer::Ptr _emptyArray;
+    Buffer::Ptr _wrongType;
+    Buffer::Ptr _busy;
+    Buffer::Ptr _nullArray;
+    Buffer::Ptr _execAbort;
+    Buffer::Ptr _oom;
+    std::vector<Buffer::Ptr> _integers;
+};
+
+} // namespace toolkit
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef STRINGMATCH_H
+#define STRINGMATCH_H
+
+#include <cstddef>
+
+namespace toolkit
+{
+
+// glob 风格的模式匹配（SCAN/HSCAN/SSCAN 的 MATCH），语法同 Redis 的 stringmatchlen：
+// * 任意个字符，? 一个字符，[abc] / [^abc] / [a-z] 字符集合，\x 转义。
+// 遇到不匹配时回到上一个 * 多吞一个字符重试，不递归，最坏 O(模式长度 * 字符串长度)，不会像 std::regex 一样每次调用都要编译模式。
+class StringMatch {
+public:
+    static bool match(const char *pattern, size_t plen, const char *str, size_t slen) {
+        static const size_t kNone = static_cast<size_t>(-1);
+        size_t p = 0, s = 0;
+        size_t starP = kNone, starS = 0;
+        while (s < slen) {
+            if (p < plen) {
+                if (pattern[p] == '*') {
+                    // 记下 * 的位置，先按匹配 0 个字符继续
+                    starP = p++;
+                    starS = s;
+                    continue;
+                }
+                size_t next;
+                if (matchOne(pattern, plen, p, str[s], next)) {
+                    p = next;
+                    ++s;
+                    continue;
+                }
+            }
+            if (starP == kNone) {
+                return false;
+            }
+            p = starP + 1;
+            s = ++starS;
+        }
+        while (p < plen && pattern[p] == '*') {
+            ++p;
+        }
+        return p == plen;
+    }
+
+private:
+    // 模式中 p 处的一个单元（字符、?、字符集合或转义）是否匹配 c，next 为下一个单元的位置
+    static bool matchOne(const char *pattern, size_t plen, size_t p, char c, size_t &next) {
+        switch (pattern[p]) {
+            case '?':
+                next = p + 1;
+                return true;
+            case '\\':
+                if (p + 1 < plen) {
+                    next = p + 2;
+                    return pattern[p + 1] == c;
+                }
+                break;
+            case '[':
+                return matchClass(pattern, plen, p + 1, c, next);
+            default:
+                break;
+        }
+        next = p + 1;
+        return pattern[p] == c;
+    }
+
+    // 字符集合，p 为 [ 之后的位置；没有 ] 时到模式结尾为止
+    static bool matchClass(const char *pattern, size_t plen, size_t p, char c, size_t &next) {
+        bool negate = p < plen && pattern[p] == '^';
+        if (negate) {
+            ++p;
+        }
+        bool matched = false;
+        while (p < plen && pattern[p] != ']') {
+            if (pattern[p] == '\\' && p + 1 < plen) {
+                matched |= pattern[p + 1] == c;
+                p += 2;
+            } else if (p + 2 < plen && pattern[p + 1] == '-' && pattern[p + 2] != ']') {
+                char lo = pattern[p], hi = pattern[p + 2];
+                if (lo > hi) {
+                    char t = lo;
+                    lo = hi;
+                    hi = t;
+                }
+                matched |= c >= lo && c <= hi;
+                p += 3;
+            } else {
+                matched |= pattern[p] == c;
+                ++p;
+            }
+        }
+        next = p < plen ? p + 1 : p;
+        return matched != negate;
+    }
+};
+
+} // namespace toolkit
+
+#endif
@@ -1,21 +1,40 @@
 #ifndef TRANSACTIONCONTEXT_H
 #define TRANSACTIONCONTEXT_H
+#include <mutex>
+#include <algorithm>
+#include <string>
 #include <vector>
-#include <functional>
-#include <iostream>
+#include <utility>
+#include <cstdint>
+#include "CmdDesc.h"
 
 namespace toolkit
 {
 // 封装事务状态管理和命令队列逻辑
+// 事务状态与事务队列只在会话所在 poller 线程中访问；WATCH 的键在键所属分片的线程中记录、由 EXEC 取走，
+// UNWATCH 可能在其它线程中清空，用锁保护。
+// WATCH 的键按批次记录：EXEC/UNWATCH/DISCARD 在 poller 线程中结束当前批次，只处理此前（及该批次）的 WATCH 记录的键。
+// 启用分片路由时 WATCH 在各分片上异步执行，完成顺序与命令顺序可能不一致，按批次区分不会误删之后新 WATCH 的键，
+// 也不会让已结束批次中迟到的键影响之后的 EXEC
 class TransactionContext {
 public:
+    // WATCH 的一个键及其当时的版本号
+    struct WatchedKey {
+        int dbIndex;
+        std::string key;
+        uint64_t version;
+        uint64_t batch;     // WATCH 解析时的批次
+    };
+
     void startTransaction() {
         _inTransation = true;
+        _dirty = false;
         _transcationQueue.clear();
     }
 
     void endTransaction() {
         _inTransation = false;
+        _dirty = false;
         _transcationQueue.clear();
     }
 
@@ -23,22 +42,92 @@ public:
         return _inTransation;
     }
 
-    void addCommandToQueue(const std::function<void(std::ostringstream&)>& command) {
+    // 事务中有命令解析失败，EXEC 时放弃整个事务
+    void markDirty() {
+        _dirty = true;
+    }
+
+    bool isDirty() const {
+        return _dirty;
+    }
+
+    // 当前的 WATCH 批次（只在 poller 线程中访问）
+    uint64_t watchBatch() const {
+        return _watchBatch;
+    }
+
+    // 结束当前批次，返回结束的批次号（EXEC/UNWATCH/DISCARD 解析时调用）
+    uint64_t endWatchBatch() {
+        return _watchBatch++;
+    }
+
+    // 启用分片路由时记录 WATCH 的键所属的分片：EXEC 与 UNWATCH 要排在这些分片上的 WATCH 之后执行（只在 poller 线程中访问）
+    void addWatchShard(size_t shard) {
+        if (std::find(_watchShards.begin(), _watchShards.end(), shard) == _watchShards.end()) {
+            _watchShards.push_back(shard);
+        }
+    }
+
+    std::vector<size_t> takeWatchShards() {
+        std::vector<size_t> shards;
+        shards.swap(_watchShards);
+        return shards;
+    }
+
+    // 入队的是已解析的命令描述符，EXEC 时在同一个任务中依次执行
+    void addCommandToQueue(CmdDesc::Ptr command) {
         if(_inTransation) {
-            _transcationQueue.push_back(command);
+            _transcationQueue.push_back(std::move(command));
         }
     }
 
-    const std::vector<std::function<void(std::ostringstream&)>> getTransactionQueue() const {
-        return _transcationQueue;
+    // 取走事务队列（EXEC）
+    std::vector<CmdDesc::Ptr> takeTransactionQueue() {
+        std::vector<CmdDesc::Ptr> queue;
+        queue.swap(_transcationQueue);
+        return queue;
+    }
+
+    void watch(WatchedKey key) {
+        std::lock_guard<std::mutex> lock(_watchMutex);
+        _watched.push_back(std::move(key));
+    }
+
+    // 取走批次 batch 中 WATCH 的键（EXEC），更早批次中迟到的键一并丢弃，之后不再监视
+    std::vector<WatchedKey> takeWatched(uint64_t batch) {
+        std::lock_guard<std::mutex> lock(_watchMutex);
+        std::vector<WatchedKey> watched;
+        for (auto &key : _watched) {
+            if (key.batch == batch) {
+                watched.push_back(std::move(key));
+            }
+        }
+        removeWatched(batch);
+        return watched;
+    }
+
+    // 取消监视批次 batch 及更早批次的键，缺省为所有键
+    void unwatch(uint64_t batch = UINT64_MAX) {
+        std::lock_guard<std::mutex> lock(_watchMutex);
+        removeWatched(batch);
     }
 
 private:
+    void removeWatched(uint64_t batch) {
+        _watched.erase(std::remove_if(_watched.begin(), _watched.end(), [batch](const WatchedKey &key) {
+            return key.batch <= batch;
+        }), _watched.end());
+    }
+
     bool _inTransation = false;  // 是否开启事务标志
-    std::vector<std::function<void(std::ostringstream&)>> _transcationQueue;    // 事务队列
-    
+    bool _dirty = false;         // 事务中有命令解析失败
+    uint64_t _watchBatch = 0;    // 当前的 WATCH 批次
+    std::vector<size_t> _watchShards;   // 当前批次 WATCH 的键所属的分片
+    std::vector<CmdDesc::Ptr> _transcationQueue;    // 事务队列
+    std::mutex _watchMutex;
+    std::vector<WatchedKey> _watched;               // WATCH 的键
 };
 } // namespace toolkit
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,147 @@
+#include <new>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include "UsedMemory.h"
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#define blockSize(ptr) malloc_size(ptr)
+#else
+#include <malloc.h>
+#define blockSize(ptr) malloc_usable_size(ptr)
+#endif
+
+namespace toolkit
+{
+
+// 常量初始化，静态初始化阶段的分配也能计数
+static std::atomic<int64_t> s_used{0};
+static std::atomic<int64_t> s_peak{0};
+
+static inline void update(int64_t delta) {
+    static thread_local int64_t pending = 0;
+    pending += delta;
+    if (pending > static_cast<int64_t>(UsedMemory::kBatch) || pending < -static_cast<int64_t>(UsedMemory::kBatch)) {
+        auto used = s_used.fetch_add(pending, std::memory_order_relaxed) + pending;
+        pending = 0;
+        // 峰值只在合并时更新，与 get() 有相同的误差
+        auto peak = s_peak.load(std::memory_order_relaxed);
+        while (used > peak && !s_peak.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+size_t UsedMemory::get() {
+    auto used = s_used.load(std::memory_order_relaxed);
+    return used > 0 ? static_cast<size_t>(used) : 0;
+}
+
+size_t UsedMemory::peak() {
+    auto peak = s_peak.load(std::memory_order_relaxed);
+    return peak > 0 ? static_cast<size_t>(peak) : 0;
+}
+
+size_t UsedMemory::usableSize(const void *ptr) {
+    return ptr ? blockSize(const_cast<void *>(ptr)) : 0;
+}
+
+size_t UsedMemory::allocSize(size_t size) {
+    auto ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        return size;
+    }
+    size_t ret = blockSize(ptr);
+    std::free(ptr);
+    return ret;
+}
+
+void UsedMemory::onAlloc(void *ptr) {
+    update(static_cast<int64_t>(blockSize(ptr)));
+}
+
+void UsedMemory::onFree(void *ptr) {
+    update(-static_cast<int64_t>(blockSize(ptr)));
+}
+
+void *UsedMemory::malloc(size_t size) {
+    auto ptr = std::malloc(size);
+    if (ptr) {
+        onAlloc(ptr);
+    }
+    return ptr;
+}
+
+void *UsedMemory::calloc(size_t count, size_t size) {
+    auto ptr = std::calloc(count, size);
+    if (ptr) {
+        onAlloc(ptr);
+    }
+    return ptr;
+}
+
+void UsedMemory::free(void *ptr) {
+    if (ptr) {
+        onFree(ptr);
+        std::free(ptr);
+    }
+}
+
+} // namespace toolkit
+
+// 替换全局的 operator new/delete，所有 C++ 对象的分配都计入 UsedMemory
+static void *countedNew(std::size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    void *ptr;
+    while (!(ptr = std::malloc(size))) {
+        auto handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+    toolkit::UsedMemory::onAlloc(ptr);
+    return ptr;
+}
+
+void *operator new(std::size_t size) {
+    return countedNew(size);
+}
+
+void *operator new[](std::size_t size) {
+    return countedNew(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return countedNew(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return countedNew(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *ptr) noexcept {
+    toolkit::UsedMemory::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    toolkit::UsedMemory::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    toolkit::UsedMemory::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    toolkit::UsedMemory::free(ptr);
+}
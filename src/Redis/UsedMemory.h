@@ -0,0 +1,38 @@
+#ifndef USEDMEMORY_H
+#define USEDMEMORY_H
+
+#include <cstddef>
+
+namespace toolkit
+{
+
+// 进程已分配的内存（类似 Redis 的 zmalloc_used_memory），供 maxmemory 与 INFO 使用
+// 全局 operator new/delete 按 malloc_usable_size 计数；直接用 malloc/calloc 分配的大块内存（哈希表的桶数组）
+// 需改用这里的 malloc/calloc/free。每个线程先在线程局部变量中累加，变化超过 kBatch 字节后才合并到全局计数，
+// 读取只需一次原子读，代价是每个线程有不超过 kBatch 字节的误差。
+class UsedMemory {
+public:
+    static const size_t kBatch = 16 * 1024;
+
+    // 已分配的字节数
+    static size_t get();
+    // 已分配字节数的峰值
+    static size_t peak();
+
+    // 内存块实际占用的字节数（分配器按大小分级向上取整），ptr 须由 malloc 或 operator new 分配
+    static size_t usableSize(const void *ptr);
+    // 申请 size 字节时分配器实际分配的字节数（试分配一次得到，调用者应缓存结果）
+    static size_t allocSize(size_t size);
+
+    static void *malloc(size_t size);
+    static void *calloc(size_t count, size_t size);
+    static void free(void *ptr);
+
+    // 已分配/将释放的内存块计入统计（operator new/delete 使用）
+    static void onAlloc(void *ptr);
+    static void onFree(void *ptr);
+};
+
+} // namespace toolkit
+
+#endif
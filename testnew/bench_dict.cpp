@@ -0,0 +1,57 @@
+// 键空间扩容时的尾延迟基准：对比 std::unordered_map 与渐进式 rehash 的 Dict 在持续插入时单次插入的耗时分布
+// std::unordered_map 扩容时一次性搬迁全部元素，单次插入耗时随键数线性增长；Dict 每次插入只搬迁一个桶
+// 用法：./bin/bench_dict [插入键数，默认 4000000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Redis/Dict.h"
+
+using namespace std;
+using namespace toolkit;
+
+static void report(const char *name, vector<uint64_t> &samples, double totalMs) {
+    sort(samples.begin(), samples.end());
+    auto pick = [&](double q) {
+        return samples[min(samples.size() - 1, static_cast<size_t>(samples.size() * q))];
+    };
+    printf("%-14s total=%8.1f ms  p50=%6llu ns  p99=%6llu ns  p99.9=%8llu ns  max=%10llu ns\n", name, totalMs,
+           (unsigned long long)pick(0.5), (unsigned long long)pick(0.99), (unsigned long long)pick(0.999),
+           (unsigned long long)samples.back());
+}
+
+template <typename Insert>
+static void run(const char *name, const vector<string> &keys, Insert &&insert) {
+    vector<uint64_t> samples(keys.size());
+    auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto start = chrono::steady_clock::now();
+        insert(keys[i]);
+        samples[i] = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+    double totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+    report(name, samples, totalMs);
+}
+
+int main(int argc, char *argv[]) {
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 4000000;
+    vector<string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        keys.emplace_back("key:" + to_string(i));
+    }
+
+    {
+        unordered_map<string, string> map;
+        run("unordered_map", keys, [&](const string &key) { map.emplace(key, "v"); });
+    }
+    {
+        Dict<string, string> dict;
+        run("Dict", keys, [&](const string &key) { dict.emplace(key, "v"); });
+    }
+    return 0;
+}
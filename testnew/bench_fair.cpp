@@ -0,0 +1,117 @@
+// 公平调度基准：一个客户端持续 pipeline 大量慢命令（类似对大哈希的 HGETALL，每执行完一条补发一条，始终有 N 条未完成），
+// 同时若干轻量客户端逐条发送快命令，对比按到达顺序执行与按客户端轮流执行时轻量客户端的延迟分布
+// 命令直接投递给 CommandExecutor（不经过网络），命令的执行时间用忙等模拟
+// 用法：./bin/bench_fair [重客户端排队的命令数，默认 10000] [每条慢命令耗时 us，默认 50] [轻量客户端数，默认 4] [每个轻量客户端的请求数，默认 50]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "Redis/CmdQueueManager.h"
+
+using namespace std;
+using namespace toolkit;
+
+static uint64_t nowUs() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void busy(uint64_t us) {
+    auto end = nowUs() + us;
+    while (nowUs() < end) {
+    }
+}
+
+static uint64_t percentile(vector<uint64_t> &values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    auto index = static_cast<size_t>(p * (values.size() - 1));
+    nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static void run(const char *name, bool fair, bool heavy, size_t heavyCount, uint64_t heavyUs, int lightClients,
+                size_t lightRequests) {
+    auto &config = RedisConfig::Instance();
+    config.fairScheduling = fair;
+    auto executor = make_shared<CommandExecutor>(0, config.commandQueueSize);
+
+    // 重客户端：始终保持 heavyCount 条慢命令在排队，直到轻量客户端结束
+    atomic<bool> stopHeavy{false};
+    atomic<size_t> heavyPending{0};
+    atomic<size_t> heavyDone{0};
+    int heavyOwner = 0;
+    function<void()> heavyCommand = [&]() {
+        busy(heavyUs);
+        heavyDone.fetch_add(1, memory_order_relaxed);
+        if (!stopHeavy.load(memory_order_relaxed)) {
+            executor->pushCommand(CommandQueue::Command(heavyCommand, &heavyOwner));
+        } else {
+            heavyPending.fetch_sub(1, memory_order_release);
+        }
+    };
+    if (heavy) {
+        heavyPending = heavyCount;
+        for (size_t i = 0; i < heavyCount; ++i) {
+            executor->pushCommand(CommandQueue::Command(heavyCommand, &heavyOwner));
+        }
+    }
+
+    // 轻量客户端：发送一条快命令，收到回复后再发下一条
+    vector<vector<uint64_t>> latencies(lightClients);
+    vector<int> owners(lightClients);
+    vector<thread> threads;
+    for (int c = 0; c < lightClients; ++c) {
+        threads.emplace_back([&, c]() {
+            for (size_t n = 0; n < lightRequests; ++n) {
+                atomic<bool> done{false};
+                auto sent = nowUs();
+                executor->pushCommand(CommandQueue::Command([&done]() {
+                    done.store(true, memory_order_release);
+                }, &owners[c]));
+                while (!done.load(memory_order_acquire)) {
+                    this_thread::sleep_for(chrono::microseconds(10));
+                }
+                latencies[c].push_back(nowUs() - sent);
+                this_thread::sleep_for(chrono::microseconds(200));
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    stopHeavy = true;
+    while (heavyPending.load(memory_order_acquire)) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    executor->stop();
+
+    vector<uint64_t> all;
+    for (auto &values : latencies) {
+        all.insert(all.end(), values.begin(), values.end());
+    }
+    auto p50 = percentile(all, 0.50);
+    auto p99 = percentile(all, 0.99);
+    auto max = percentile(all, 1.0);
+    printf("%-20s light p50=%8llu us  p99=%8llu us  max=%8llu us  heavy executed=%zu\n", name,
+           (unsigned long long)p50, (unsigned long long)p99, (unsigned long long)max, heavyDone.load());
+}
+
+int main(int argc, char *argv[]) {
+    size_t heavyCount = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+    uint64_t heavyUs = argc > 2 ? strtoull(argv[2], nullptr, 10) : 50;
+    int lightClients = argc > 3 ? atoi(argv[3]) : 4;
+    size_t lightRequests = argc > 4 ? strtoul(argv[4], nullptr, 10) : 50;
+
+    printf("heavy client: %zu x %llu us, light clients: %d x %zu requests, client budget: %zu\n", heavyCount,
+           (unsigned long long)heavyUs, lightClients, lightRequests, RedisConfig::Instance().clientBudget);
+    run("no heavy neighbour", true, false, heavyCount, heavyUs, lightClients, lightRequests);
+    run("fifo", false, true, heavyCount, heavyUs, lightClients, lightRequests);
+    run("fair", true, true, heavyCount, heavyUs, lightClients, lightRequests);
+    return 0;
+}
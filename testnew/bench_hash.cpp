@@ -0,0 +1,97 @@
+// 哈希表基准：对比 std::unordered_map、Dict（渐进式 rehash）与 FlatDict（开放寻址 + SSE2 分组探测）
+// 测量插入、命中查找、未命中查找的平均耗时以及每个元素占用的堆内存
+// 用法：./bin/bench_hash [键数，默认 1000000]
+
+#include <malloc.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Redis/Dict.h"
+#include "Redis/FlatDict.h"
+
+using namespace std;
+using namespace toolkit;
+
+// 与 std::unordered_map 统一接口
+struct StdMap {
+    unordered_map<string, string> map;
+
+    void emplace(const string &key, const string &value) {
+        map.emplace(key, value);
+    }
+    const string *find(const string &key) const {
+        auto it = map.find(key);
+        return it == map.end() ? nullptr : &it->second;
+    }
+};
+
+// 堆上已分配的字节数，大块内存由 mmap 分配，需要加上 hblkhd
+static size_t heapUsed() {
+    auto info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+template <typename Func>
+static double measure(size_t count, Func &&func) {
+    auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / count;
+}
+
+template <typename Map>
+static void run(const char *name, const vector<string> &keys, const vector<string> &lookups, const vector<string> &misses) {
+    size_t base = heapUsed();
+    auto map = new Map();
+    const string value = "value";
+
+    double insertNs = measure(keys.size(), [&]() {
+        for (auto &key : keys) {
+            map->emplace(key, value);
+        }
+    });
+    // 键和值都是短字符串（SSO，不额外分配），统计的即为容器本身的开销
+    double bytesPerEntry = static_cast<double>(heapUsed() - base) / keys.size();
+
+    size_t sink = 0;
+    double hitNs = measure(lookups.size(), [&]() {
+        for (auto &key : lookups) {
+            sink += map->find(key) != nullptr;
+        }
+    });
+    double missNs = measure(misses.size(), [&]() {
+        for (auto &key : misses) {
+            sink += map->find(key) != nullptr;
+        }
+    });
+    delete map;
+
+    printf("%-14s insert=%7.1f ns  hit=%7.1f ns  miss=%7.1f ns  memory=%6.1f B/entry\n", name, insertNs, hitNs, missNs,
+           bytesPerEntry);
+    if (sink != lookups.size()) {
+        printf("unexpected\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+    vector<string> keys, misses;
+    keys.reserve(count);
+    misses.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        keys.emplace_back("key:" + to_string(i));
+        misses.emplace_back("miss:" + to_string(i));
+    }
+    // 随机顺序查找，避免按插入顺序访问带来的缓存局部性
+    vector<string> lookups = keys;
+    shuffle(lookups.begin(), lookups.end(), mt19937(42));
+
+    run<StdMap>("unordered_map", keys, lookups, misses);
+    run<Dict<string, string>>("Dict", keys, lookups, misses);
+    run<FlatDict<string, string>>("FlatDict", keys, lookups, misses);
+    return 0;
+}
@@ -0,0 +1,112 @@
+// 命令队列基准：对比旧的 std::queue + mutex + condition_variable 队列与无锁 MPSC CommandQueue
+// 多个生产者线程（模拟 poller）并发投递命令，单个消费者线程（模拟执行线程）批量取出执行
+// 用法：./bin/bench_queue [生产者线程数，默认 4] [每个线程投递的命令数，默认 1000000]
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "Redis/CmdQueue.h"
+
+using namespace std;
+using namespace toolkit;
+
+// 旧版 CommandQueue，作为对比基准
+class LegacyQueue {
+public:
+    using Command = function<void()>;
+
+    void push(Command cmd) {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _queue.push(move(cmd));
+        }
+        _condition.notify_one();
+    }
+
+    Command pop() {
+        unique_lock<mutex> lock(_mutex);
+        _condition.wait(lock, [this]() { return !_queue.empty(); });
+        Command cmd = move(_queue.front());
+        _queue.pop();
+        return cmd;
+    }
+
+    bool tryPop(Command &cmd) {
+        lock_guard<mutex> lock(_mutex);
+        if (_queue.empty()) {
+            return false;
+        }
+        cmd = move(_queue.front());
+        _queue.pop();
+        return true;
+    }
+
+private:
+    queue<Command> _queue;
+    mutex _mutex;
+    condition_variable _condition;
+};
+
+template <typename Queue>
+static void run(const char *name, Queue &queue, int producers, size_t perProducer) {
+    const size_t total = producers * perProducer;
+    atomic<size_t> executed{0};
+    size_t rounds = 0;
+
+    auto start = chrono::steady_clock::now();
+    thread consumer([&]() {
+        size_t done = 0;
+        while (done < total) {
+            auto cmd = queue.pop();
+            size_t count = 0;
+            do {
+                cmd();
+                ++done;
+            } while (++count < 128 && queue.tryPop(cmd));
+            ++rounds;
+        }
+    });
+    vector<thread> threads;
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&]() {
+            for (size_t n = 0; n < perProducer; ++n) {
+                queue.push([&executed]() { executed.fetch_add(1, memory_order_relaxed); });
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    consumer.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%-14s producers=%d  %8.2f Mops/s  %6.1f cmds/round", name, producers, total / seconds / 1e6,
+           static_cast<double>(total) / rounds);
+    if (executed != total) {
+        printf("  unexpected");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int producers = argc > 1 ? atoi(argv[1]) : 4;
+    size_t perProducer = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000;
+
+    {
+        LegacyQueue queue;
+        run("mutex-queue", queue, producers, perProducer);
+        printf("\n");
+    }
+    {
+        CommandQueue queue;
+        run("mpsc-ring", queue, producers, perProducer);
+        printf("  parks=%llu  wait_avg=%.1f us  full_waits=%llu\n", (unsigned long long)queue.parks(),
+               queue.avgWaitUs(), (unsigned long long)queue.fullWaits());
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+// RESP 解析微基准：对比旧的 std::getline 版 parseRESPCommand 与 RespDecoder 在各扫描内核下的解析速度
+// 用法：./bin/bench_resp [迭代总字节数(MB)，默认 256]
+
+#include <iostream>
+#include <sstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include "Redis/RespParser.h"
+
+using namespace std;
+using namespace toolkit;
+
+// 旧版 RedisSession::parseRESPCommand，作为对比基准
+static vector<string> legacyParseRESPCommand(const string &data) {
+    vector<string> result;
+    istringstream stream(data);
+    string line;
+
+    function<void(istringstream &, int)> parseRESP = [&](istringstream &stream, int depth) -> void {
+        while (getline(stream, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty()) {
+                continue;
+            }
+            if (line[0] == '*') {
+                int num_elements = stoi(line.substr(1));
+                while (num_elements-- > 0) {
+                    parseRESP(stream, depth + 1);
+                }
+            } else if (line[0] == '$') {
+                int bulk_length = stoi(line.substr(1));
+                if (bulk_length > 0 && getline(stream, line)) {
+                    if (!line.empty() && line.back() == '\r') {
+                        line.pop_back();
+                    }
+                    result.push_back(line.substr(0, bulk_length));
+                }
+            }
+        }
+    };
+
+    parseRESP(stream, 0);
+    return result;
+}
+
+// 构造一条 MSET k0 v0 ... k9 v9 命令，value 长度为 valueSize
+static string makeMSet(size_t valueSize) {
+    const int pairs = 10;
+    string value(valueSize, 'x');
+    ostringstream oss;
+    oss << "*" << (1 + pairs * 2) << "\r\n$4\r\nMSET\r\n";
+    for (int i = 0; i < pairs; ++i) {
+        string key = "key:" + to_string(i);
+        oss << "$" << key.size() << "\r\n" << key << "\r\n";
+        oss << "$" << value.size() << "\r\n" << value << "\r\n";
+    }
+    return oss.str();
+}
+
+template <typename Func>
+static double measure(size_t iterations, Func &&func) {
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        func();
+    }
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, nano>(end - start).count() / iterations;
+}
+
+static void report(const char *name, size_t valueSize, size_t cmdSize, double ns) {
+    printf("%-10s value=%-6zu %10.1f ns/op %10.1f MB/s\n", name, valueSize, ns, cmdSize / ns * 1e9 / (1024 * 1024));
+}
+
+int main(int argc, char *argv[]) {
+    size_t totalMB = argc > 1 ? strtoul(argv[1], nullptr, 10) : 256;
+    size_t valueSizes[] = {16, 1024, 64 * 1024};
+    RespScan::Kernel kernels[] = {RespScan::KERNEL_SCALAR, RespScan::KERNEL_SSE2, RespScan::KERNEL_AVX2};
+
+    for (auto valueSize : valueSizes) {
+        string cmd = makeMSet(valueSize);
+        // 把多条命令拼在一起模拟 pipeline
+        string batch;
+        for (int i = 0; i < 16; ++i) {
+            batch += cmd;
+        }
+        size_t iterations = max<size_t>(totalMB * 1024 * 1024 / batch.size(), 1);
+
+        size_t sink = 0;
+        double ns = measure(iterations, [&]() {
+            // 旧实现每次只能处理一条命令
+            for (int i = 0; i < 16; ++i) {
+                sink += legacyParseRESPCommand(cmd).size();
+            }
+        });
+        report("getline", valueSize, cmd.size(), ns / 16);
+
+        for (auto kernel : kernels) {
+            if (RespScan::select(kernel) != kernel) {
+                continue;
+            }
+            RespDecoder decoder;
+            vector<RespDecoder::Slice> slices;
+            ns = measure(iterations, [&]() {
+                size_t offset = 0;
+                while (offset < batch.size()) {
+                    size_t consumed = 0;
+                    if (decoder.decode(batch.data() + offset, batch.size() - offset, consumed, slices) != RespDecoder::COMPLETE) {
+                        abort();
+                    }
+                    offset += consumed;
+                    sink += slices.size();
+                }
+            });
+            report(RespScan::kernelName(kernel), valueSize, cmd.size(), ns / 16);
+        }
+
+        // 只扫描不解析：衡量内核本身在大块数据上的查找速度
+        for (auto kernel : kernels) {
+            if (RespScan::select(kernel) != kernel) {
+                continue;
+            }
+            string name = string("scan-") + RespScan::kernelName(kernel);
+            ns = measure(iterations, [&]() {
+                auto begin = batch.data(), end = batch.data() + batch.size();
+                sink += RespScan::find(begin, end, '\0') == nullptr;
+            });
+            report(name.c_str(), valueSize, batch.size(), ns);
+        }
+        printf("\n");
+        if (sink == 0) {
+            printf("unexpected\n");
+        }
+    }
+    RespScan::select();
+    return 0;
+}
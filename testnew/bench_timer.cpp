@@ -0,0 +1,103 @@
+// 定时器基准：对比 EventPoller 原来的有序 multimap 与分层时间轮
+// 放入 N 个定时器（到期时间在 1 毫秒 ~ 1 小时内随机），取消其中 1/10，再按 poller 的方式推进虚拟时钟：
+// 查询最早到期时间（getMinDelay）-> 推进到该时间并执行到期的定时器，直到全部到期
+// 用法：./bin/bench_timer [定时器数，默认 10000000] [最大延时毫秒，默认 3600000]
+
+#include <map>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "Poller/TimingWheel.h"
+
+using namespace std;
+using namespace toolkit;
+
+static double nowSec() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char *name, const char *phase, double seconds, size_t ops) {
+    printf("%-10s %-8s %8.3f s  %8.1f ns/op\n", name, phase, seconds, seconds * 1e9 / (ops ? ops : 1));
+}
+
+static void benchMultimap(const vector<uint64_t> &expires, size_t cancelStep) {
+    using Map = multimap<uint64_t, size_t>;
+    Map timers;
+    vector<Map::iterator> handles(expires.size());
+    auto start = nowSec();
+    for (size_t i = 0; i < expires.size(); ++i) {
+        handles[i] = timers.emplace(expires[i], i);
+    }
+    report("multimap", "insert", nowSec() - start, expires.size());
+
+    start = nowSec();
+    size_t cancelled = 0;
+    for (size_t i = 0; i < expires.size(); i += cancelStep) {
+        timers.erase(handles[i]);
+        ++cancelled;
+    }
+    report("multimap", "cancel", nowSec() - start, cancelled);
+
+    start = nowSec();
+    size_t fired = 0, polls = 0;
+    while (!timers.empty()) {
+        auto now = timers.begin()->first;
+        ++polls;
+        for (auto it = timers.begin(); it != timers.end() && it->first <= now; it = timers.erase(it)) {
+            ++fired;
+        }
+    }
+    report("multimap", "expire", nowSec() - start, fired);
+    printf("%-10s fired=%zu polls=%zu\n", "multimap", fired, polls);
+}
+
+static void benchWheel(const vector<uint64_t> &expires, size_t cancelStep) {
+    TimingWheel wheel(0);
+    vector<TimingWheel::Node> nodes(expires.size());
+    auto start = nowSec();
+    for (size_t i = 0; i < expires.size(); ++i) {
+        wheel.add(&nodes[i], expires[i]);
+    }
+    report("wheel", "insert", nowSec() - start, expires.size());
+
+    start = nowSec();
+    size_t cancelled = 0;
+    for (size_t i = 0; i < expires.size(); i += cancelStep) {
+        wheel.cancel(&nodes[i]);
+        ++cancelled;
+    }
+    report("wheel", "cancel", nowSec() - start, cancelled);
+
+    start = nowSec();
+    size_t fired = 0, polls = 0, late = 0;
+    uint64_t now;
+    while (wheel.nextExpire(now)) {
+        ++polls;
+        wheel.advance(now, [&](TimingWheel::Node *node) {
+            ++fired;
+            if (node->expire() != now) {
+                ++late;
+            }
+        });
+    }
+    report("wheel", "expire", nowSec() - start, fired);
+    printf("%-10s fired=%zu polls=%zu late=%zu\n", "wheel", fired, polls, late);
+}
+
+int main(int argc, char *argv[]) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    uint64_t maxDelay = argc > 2 ? strtoull(argv[2], nullptr, 10) : 3600000;
+
+    mt19937_64 rng(20240601);
+    uniform_int_distribution<uint64_t> delay(1, maxDelay);
+    vector<uint64_t> expires(count);
+    for (auto &expire : expires) {
+        expire = delay(rng);
+    }
+    printf("timers: %zu, delay: 1 ~ %llu ms, cancel: 1/10\n", count, (unsigned long long)maxDelay);
+    benchWheel(expires, 10);
+    benchMultimap(expires, 10);
+    return 0;
+}
@@ -1,14 +1,91 @@
 
 
 #include <csignal>
+#include <cctype>
+#include <cstdlib>
 #include <iostream>
 #include <unistd.h>
 
+#include "Util/CMD.h"
 #include "Redis/RedisSession.h"
+#include "Redis/RedisConfig.h"
 using namespace std;
 using namespace toolkit;
 
+// 启动参数
+class CMD_main : public CMD {
+public:
+    CMD_main() {
+        _parser.reset(new OptionParser(nullptr));
+        (*_parser) << Option('p', "port", Option::ArgRequired, "6380", false, "监听端口", nullptr);
+        (*_parser) << Option('b', "reply-batching", Option::ArgRequired, "1", false,
+                             "是否合并回复，开启后同一会话一轮处理中的回复合并为一次 sendmsg 发送", nullptr);
+        (*_parser) << Option(0, "executor-batch", Option::ArgRequired, "128", false,
+                             "执行线程每轮最多连续执行的命令条数", nullptr);
+        (*_parser) << Option(0, "executor-threads", Option::ArgRequired, "1", false,
+                             "执行线程数，多于 1 个时不同键的命令按键的哈希分配到各执行线程并行执行", nullptr);
+        (*_parser) << Option(0, "fair-scheduling", Option::ArgRequired, "1", false,
+                             "执行线程是否按客户端轮流执行命令，关闭后按到达顺序执行", nullptr);
+        (*_parser) << Option(0, "client-budget", Option::ArgRequired, "16", false,
+                             "公平调度时每个客户端每轮最多连续执行的命令条数", nullptr);
+        (*_parser) << Option(0, "queue-size", Option::ArgRequired, "65536", false,
+                             "命令队列容量，向上取整为 2 的幂", nullptr);
+        (*_parser) << Option(0, "max-queue-depth", Option::ArgRequired, "0", false,
+                             "等待执行的命令数达到该值后新命令回复 -BUSY，0 表示不限制", nullptr);
+        (*_parser) << Option(0, "max-queue-age", Option::ArgRequired, "0", false,
+                             "命令排队超过该毫秒数后不再执行并回复 -BUSY，0 表示不限制", nullptr);
+        (*_parser) << Option(0, "poller-reads", Option::ArgRequired, "1", false,
+                             "只读命令是否在 poller 线程中直接执行，不经过执行线程", nullptr);
+        (*_parser) << Option(0, "active-rehashing", Option::ArgRequired, "1", false,
+                             "是否在空闲时由定时任务推进键空间的渐进式 rehash", nullptr);
+        (*_parser) << Option(0, "active-expire", Option::ArgRequired, "1", false,
+                             "是否由定时任务抽样删除已过期的键", nullptr);
+        (*_parser) << Option(0, "active-expire-ms", Option::ArgRequired, "2", false,
+                             "每 100ms 主动过期最多占用的毫秒数", nullptr);
+        (*_parser) << Option(0, "timeout", Option::ArgRequired, "0", false,
+                             "连接空闲超过该秒数后断开，0 表示不限制", nullptr);
+        (*_parser) << Option(0, "maxmemory", Option::ArgRequired, "0", false,
+                             "内存上限，可带 kb/mb/gb 后缀，0 表示不限制", nullptr);
+        (*_parser) << Option(0, "maxmemory-policy", Option::ArgRequired, "noeviction", false,
+                             "超出内存上限时的淘汰策略：noeviction/allkeys-lru/allkeys-lfu/volatile-lru/volatile-ttl", nullptr);
+        (*_parser) << Option(0, "maxmemory-samples", Option::ArgRequired, "5", false,
+                             "每次淘汰从每个数据库抽样的键数", nullptr);
+        (*_parser) << Option(0, "threads", Option::ArgRequired, "0", false,
+                             "poller 线程数，0 表示与 CPU 核数相同", nullptr);
+        (*_parser) << Option(0, "sharded", Option::ArgRequired, "0", false,
+                             "是否开启分片模式，开启后键空间按 poller 线程分片，命令在所属分片的 poller 线程上直接执行", nullptr);
+    }
 
+    const char *description() const override {
+        return "PicoRedis 服务器";
+    }
+};
+
+
+// 解析内存大小：字节数，可带 k/kb/m/mb/g/gb 后缀（不区分大小写，按 1024 换算）
+static bool parseMemory(const string &str, size_t &bytes) {
+    char *end = nullptr;
+    auto value = strtoull(str.c_str(), &end, 10);
+    if (end == str.c_str()) {
+        return false;
+    }
+    string unit(end);
+    for (auto &c : unit) {
+        c = static_cast<char>(tolower(c));
+    }
+    size_t scale = 1;
+    if (unit == "k" || unit == "kb") {
+        scale = 1024;
+    } else if (unit == "m" || unit == "mb") {
+        scale = 1024 * 1024;
+    } else if (unit == "g" || unit == "gb") {
+        scale = 1024 * 1024 * 1024;
+    } else if (!unit.empty()) {
+        return false;
+    }
+    bytes = static_cast<size_t>(value) * scale;
+    return true;
+}
 
 // 打印欢迎信息和服务器启动信息
 void printWelcomeMessage() {
@@ -33,14 +110,56 @@ void printShutdownMessage() {
 }
 
 
-int main() {
+int main(int argc, char *argv[]) {
+    // 解析启动参数
+    CMD_main cmd_main;
+    try {
+        cmd_main.operator()(argc, argv);
+    } catch (ExitException &) {
+        return 0;
+    } catch (std::exception &ex) {
+        cout << ex.what() << endl;
+        return -1;
+    }
+    auto &config = RedisConfig::Instance();
+    config.port = cmd_main["port"];
+    config.replyBatching = cmd_main["reply-batching"];
+    config.executorBatch = std::max<size_t>(cmd_main["executor-batch"].as<size_t>(), 1);
+    config.fairScheduling = cmd_main["fair-scheduling"];
+    config.clientBudget = std::max<size_t>(cmd_main["client-budget"].as<size_t>(), 1);
+    config.commandQueueSize = std::max<size_t>(cmd_main["queue-size"].as<size_t>(), 2);
+    config.maxQueueDepth = cmd_main["max-queue-depth"].as<size_t>();
+    config.maxQueueAgeMs = cmd_main["max-queue-age"].as<uint64_t>();
+    config.pollerReads = cmd_main["poller-reads"];
+    config.activeRehashing = cmd_main["active-rehashing"];
+    config.activeExpire = cmd_main["active-expire"];
+    config.activeExpireMs = std::max(cmd_main["active-expire-ms"].as<int>(), 1);
+    config.clientTimeoutMs = cmd_main["timeout"].as<uint64_t>() * 1000;
+    config.sharded = cmd_main["sharded"];
+    if (!parseMemory(cmd_main["maxmemory"], config.maxmemory)) {
+        cout << "invalid maxmemory: " << cmd_main["maxmemory"] << endl;
+        return -1;
+    }
+    if (!parseEvictionPolicy(cmd_main["maxmemory-policy"].data(), config.maxmemoryPolicy)) {
+        cout << "invalid maxmemory-policy: " << cmd_main["maxmemory-policy"] << endl;
+        return -1;
+    }
+    config.maxmemorySamples = std::max(cmd_main["maxmemory-samples"].as<int>(), 1);
+    // 访问记录的含义（空闲时间或访问频率）需在创建任何对象之前确定
+    RedisObject::lfuMode() = config.maxmemoryPolicy == EVICT_ALLKEYS_LFU;
+    // poller 线程数需在线程池第一次使用之前设置；分片模式下每个 poller 一个分片
+    EventPollerPool::setPoolSize(cmd_main["threads"].as<size_t>());
+    // 分片模式下命令不经过执行线程，只保留一个
+    config.executorThreads = config.sharded ? 1 : std::max<size_t>(cmd_main["executor-threads"].as<size_t>(), 1);
+    config.shardCount = config.sharded ? EventPollerPool::Instance().getExecutorSize() : config.executorThreads;
+
     // 打印欢迎信息
     printWelcomeMessage();
 
     // 启动 Redis 服务器
     RedisServer::Ptr server(new RedisServer());
-    server->Start<RedisSession>(6380, false); // 监听 6380 端口
-    cout << "PicoRedis server is listening on port 6380..." << endl;
+    server->Start<RedisSession>(config.port, false); // 默认监听 6380 端口
+    cout << "PicoRedis server is listening on port " << config.port << "..." << endl;
 
     //退出程序事件处理
     static semaphore sem;
@@ -0,0 +1,90 @@
+// 过期时间测试：INCR、APPEND 等修改已有值的命令（RedisString::update）保留键的过期时间，SET（RedisString::set）清除过期时间
+// 用法：./bin/test_expire，全部通过返回 0
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "Redis/DataType.h"
+#include "Util/util.h"
+
+using namespace std;
+using namespace toolkit;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond);       \
+            ++failures;                                                    \
+        }                                                                  \
+    } while (0)
+
+static int64_t expireAt(Keyspace &keyspace, const string &key) {
+    auto obj = keyspace.lookup(key);
+    return obj ? obj->expireAt() : -2;
+}
+
+int main() {
+    // getCurrentMillisecond 从进程启动时的 0 开始计时，等它走过几毫秒，过去的时刻才不会与 kNoExpire（-1）重合
+    while (getCurrentMillisecond() < 10) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    auto keyspace = make_shared<Keyspace>();
+    RedisString strings(keyspace);
+    auto at = static_cast<int64_t>(getCurrentMillisecond()) + 100000;
+
+    // SET k 1; EXPIRE k 100; INCR k
+    strings.set("k", "1");
+    CHECK(keyspace->setExpire("k", at));
+    strings.update("k", "2");
+    CHECK(*strings.get(StrView("k")) == "2");
+    CHECK(expireAt(*keyspace, "k") == at);
+    CHECK(keyspace->expires() == 1);
+
+    // APPEND
+    strings.update("k", "2abc");
+    CHECK(expireAt(*keyspace, "k") == at);
+    CHECK(keyspace->expires() == 1);
+
+    // 不存在的键与 set 相同，不带过期时间
+    strings.update("n", "1");
+    CHECK(expireAt(*keyspace, "n") == RedisObject::kNoExpire);
+    CHECK(keyspace->expires() == 1);
+
+    // SET 覆盖时清除过期时间
+    strings.set("k", "3");
+    CHECK(expireAt(*keyspace, "k") == RedisObject::kNoExpire);
+    CHECK(keyspace->expires() == 0);
+
+    // 已过期的键不会被 update 延续
+    CHECK(keyspace->setExpire("k", static_cast<int64_t>(getCurrentMillisecond()) - 1));
+    CHECK(strings.get(StrView("k")) == nullptr);
+    strings.update("k", "1");
+    CHECK(expireAt(*keyspace, "k") == RedisObject::kNoExpire);
+    CHECK(keyspace->expires() == 0);
+
+    // 主动过期：过期登记扩容、rehash 期间按游标抽样，已过期的键全部删除，未过期的保留
+    auto past = static_cast<int64_t>(getCurrentMillisecond()) - 1;
+    for (int i = 0; i < 1000; ++i) {
+        strings.set("e" + to_string(i), "v");
+        CHECK(keyspace->setExpire("e" + to_string(i), i % 2 ? past : at));
+    }
+    CHECK(keyspace->expires() == 1000);
+    for (int i = 0; i < 100 && keyspace->expires() > 500; ++i) {
+        keyspace->activeExpire(getCurrentMicrosecond() + 100000);
+    }
+    CHECK(keyspace->expires() == 500);
+    CHECK(expireAt(*keyspace, "e0") == at);
+    CHECK(keyspace->lookup("e1") == nullptr);
+
+    // 删除键时同时删除过期登记
+    keyspace->erase("e0");
+    CHECK(keyspace->expires() == 499);
+    keyspace->clearType(OBJ_STRING);
+    CHECK(keyspace->expires() == 0);
+
+    printf("%s\n", failures ? "test_expire: FAILED" : "test_expire: OK");
+    return failures ? 1 : 0;
+}